@@ -50,9 +50,18 @@ public:
     [[nodiscard]] INvsManager &getNvsManager() const;
 
     /**
-     * @brief called upon registration in the app_manager, allows the app to do some initialization beforehand.
-     * The app should not start performing tasks yet
+     * @brief called once during boot, concurrently with the initialization of the display and the other apps. Allows
+     * the app to do slow preparations like reading NVS, which will then be ready by the time it gets activated.
      *
+     * Note that this function must not use LVGL, as the display might not be initialized yet.
+     */
+    virtual void preload();
+
+    /**
+     * @brief called by the app_manager right before the app is activated for the first time, allows the app to do some
+     * initialization beforehand. The app should not start performing tasks yet.
+     *
+     * Note that if the app is reclaimable, init() can be called again after a deinit().
      */
     virtual void init() = 0;
 
@@ -79,6 +88,30 @@ public:
      */
     [[nodiscard]] virtual bool getVisible() const = 0;
 
+    /**
+     * @brief determines if the app can be deinitialized by the app_manager while it is inactive
+     *
+     * When memory runs low, the app_manager will deinitialize the least recently used reclaimable apps. They will be
+     * initialized again before their next activation, so an app should only return true if it does not mind losing
+     * the state it keeps between init() and deinit().
+     *
+     * @return
+     * - true app can be reclaimed
+     * - false app should stay initialized (default)
+     */
+    [[nodiscard]] virtual bool getReclaimable() const;
+
+    /**
+     * @brief determines if launchers should draw attention to the app, for example because an update is available
+     *
+     * Note that launchers are not obligated to adhere to this. This can be called while the app is not initialized.
+     *
+     * @return
+     * - true app has something new for the user
+     * - false nothing to flag (default)
+     */
+    [[nodiscard]] virtual bool getHighlighted() const;
+
     /**
      * @brief the app has been activated (brought to the foreground), it should start doing something.
      * Note that this function should return asap, any required processing should be done in a separate thread
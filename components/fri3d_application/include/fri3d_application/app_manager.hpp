@@ -36,6 +36,23 @@ public:
      * deactivate itself, for example when it's done processing something.
      */
     virtual void previousApp() = 0;
+
+    /**
+     * @brief check if the badge is booting in fast boot mode
+     *
+     * Fast boot is used when it is enabled in NVS, when the B button is held during boot, after an OTA update and when
+     * returning from another firmware. Apps should skip anything that is just for show, like the splash screen.
+     *
+     * @return bool to indicate fast boot mode
+     */
+    [[nodiscard]] virtual bool getFastBoot() const = 0;
+
+    /**
+     * @brief store the navigation state in RTC memory, right before booting into another firmware
+     *
+     * When that firmware restarts the badge, the last app is shown again and the boot is a fast one.
+     */
+    virtual void storeHandoff() const = 0;
 };
 
 } // namespace Fri3d::Application
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <functional>
+
+#include "fri3d_application/console.hpp"
+
+namespace Fri3d::Application
+{
+
+/**
+ * @brief Collects timestamped markers from app_main up to the first interactive frame
+ *
+ * Marking is cheap and safe from any task, so markers can be placed anywhere during boot. Once the first frame after
+ * activating the default app has been rendered, the owner of the completion callback is told to report(), which prints
+ * the timeline and checks it against the boot budget.
+ */
+class IBootProfiler
+{
+public:
+    typedef std::function<void()> CCallback;
+
+    /**
+     * @brief record a marker on the boot timeline, ignored once the boot is complete
+     *
+     * @param[in]event name of the marker, needs to stay valid forever
+     * @param[in]detail optional detail (e.g. an app name), needs to stay valid forever
+     */
+    virtual void mark(const char *event, const char *detail = nullptr) = 0;
+
+    /**
+     * @brief the default app has been activated, the next rendered frame completes the boot
+     */
+    virtual void markInteractive() = 0;
+
+    /**
+     * @brief called after every frame flush, completes the boot when it is the first interactive frame
+     *
+     * Only records the time and calls the completion callback, so it can be called from the flush of LVGL.
+     */
+    virtual void frameRendered() = 0;
+
+    /**
+     * @brief set the function called once the boot is complete, it should only pass this on to a task of its own
+     */
+    virtual void setOnComplete(CCallback callback) = 0;
+
+    /**
+     * @brief print the timeline of the completed boot and add it to a running benchmark, which reboots for the next run
+     */
+    virtual void report() = 0;
+
+    /**
+     * @brief print the boot timeline to the log
+     */
+    virtual void printTimeline() const = 0;
+
+    /**
+     * @brief register the `boot` command, which prints the timeline and runs the reboot benchmark
+     */
+    virtual void registerCommands(IConsole &console) = 0;
+};
+
+extern IBootProfiler &bootProfiler;
+
+} // namespace Fri3d::Application
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <functional>
+
+namespace Fri3d::Application
+{
+
+class IConsole
+{
+public:
+    typedef std::function<int(int argc, char **argv)> CCommand;
+
+    /**
+     * @brief start the interactive console on the configured serial port. Does nothing if the console is disabled in
+     * the configuration.
+     */
+    virtual void start() = 0;
+
+    /**
+     * @brief register a command on the console. Commands can be registered before and after starting the console.
+     *
+     * @param[in]command name of the command, needs to stay valid forever
+     * @param[in]help description shown by the `help` command, needs to stay valid forever
+     * @param[in]handler called with the command line arguments, including the command itself
+     */
+    virtual void registerCommand(const char *command, const char *help, CCommand handler) = 0;
+};
+
+extern IConsole &console;
+
+} // namespace Fri3d::Application
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+
+#include "fri3d_application/console.hpp"
+
+namespace Fri3d::Application
+{
+
+/**
+ * @brief Measures how smoothly the LVGL thread keeps up
+ *
+ * Every run of the LVGL timer handler counts as a frame. Its time is how long the UI did not respond: the time the
+ * handler took, plus how much later than planned it started. Stalls, like code waiting for a flash erase to finish,
+ * show up in the latter. Frames that take longer than FRI3D_FRAME_BUDGET_MS are counted separately.
+ */
+class IFrameStats
+{
+public:
+    struct CSummary
+    {
+        uint32_t frames;
+        uint32_t overBudget;
+        // In microseconds
+        uint32_t average;
+        uint32_t worst;
+    };
+
+    /**
+     * @brief record a frame, called by the LVGL thread
+     *
+     * @param[in]duration in microseconds
+     */
+    virtual void frameDone(uint32_t duration) = 0;
+
+    /**
+     * @brief start counting again, for example when an update starts
+     */
+    virtual void reset() = 0;
+
+    [[nodiscard]] virtual CSummary getSummary() const = 0;
+
+    /**
+     * @brief print the summary to the log, as a warning when frames went over budget
+     */
+    virtual void print(const char *title) const = 0;
+
+    /**
+     * @brief register the `frames` command, which prints the summary or resets it
+     */
+    virtual void registerCommands(IConsole &console) = 0;
+};
+
+extern IFrameStats &frameStats;
+
+} // namespace Fri3d::Application
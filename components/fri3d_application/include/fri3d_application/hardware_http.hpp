@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "esp_http_client.h"
+
+namespace Fri3d::Application::Hardware
+{
+
+class IHttp;
+
+/**
+ * @brief an HTTP client borrowed from the pool, it is given back when this goes out of scope
+ *
+ * The connection of the client is kept open after a response was read completely, so the next request to the same
+ * host skips the TCP and TLS handshakes. Headers set through setHeader() are removed again when the client is given
+ * back, headers set directly on the handle are not. The event handler belongs to the pool, so response headers are only
+ * available when they are watched before the request is sent.
+ */
+class CHttpClient
+{
+private:
+    IHttp *http;
+    esp_http_client_handle_t handle;
+    std::vector<std::string> headers;
+
+public:
+    CHttpClient(IHttp &http, esp_http_client_handle_t handle);
+    ~CHttpClient();
+
+    CHttpClient(CHttpClient &&other) noexcept;
+    CHttpClient(const CHttpClient &) = delete;
+    CHttpClient &operator=(const CHttpClient &) = delete;
+    CHttpClient &operator=(CHttpClient &&) = delete;
+
+    [[nodiscard]] esp_http_client_handle_t get() const;
+
+    /**
+     * @return false if no client could be created
+     */
+    explicit operator bool() const;
+
+    bool setHeader(const char *key, const char *value);
+
+    /**
+     * @brief keep the value of a response header for getHeader(), until the client is given back
+     */
+    void watchHeader(const char *key);
+
+    /**
+     * @return value of a watched header in the last response, empty when the server didn't send it
+     */
+    [[nodiscard]] std::string getHeader(const char *key) const;
+};
+
+struct CHttpStatistics
+{
+    // Requests sent over all pooled clients
+    uint32_t requests;
+    // New connections, each one costs a TCP and often a TLS handshake
+    uint32_t connections;
+};
+
+class IHttp
+{
+protected:
+    friend class CHttpClient;
+
+    /**
+     * @brief give a client back to the pool, called by CHttpClient
+     */
+    virtual void release(esp_http_client_handle_t handle) = 0;
+
+    /**
+     * @brief start keeping a response header of a borrowed client, called by CHttpClient
+     */
+    virtual void watchHeader(esp_http_client_handle_t handle, const char *key) = 0;
+
+    /**
+     * @return value of a watched response header of a borrowed client, called by CHttpClient
+     */
+    [[nodiscard]] virtual std::string getHeader(esp_http_client_handle_t handle, const char *key) = 0;
+
+public:
+    /**
+     * @brief borrow a client for the host of the url, reusing an idle connection to that host when there is one
+     *
+     * The client is configured for HTTPS with the certificate bundle. Only the open, fetch headers and read API may be
+     * used on it, the event handler belongs to the pool.
+     *
+     * @param url first url that will be requested, later requests can change it with esp_http_client_set_url()
+     */
+    virtual CHttpClient acquire(const std::string &url) = 0;
+
+    /**
+     * @brief close all idle connections, to give the memory of their TLS sessions back
+     */
+    virtual void closeIdle() = 0;
+
+    [[nodiscard]] virtual CHttpStatistics getStatistics() const = 0;
+};
+
+} // namespace Fri3d::Application::Hardware
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "fri3d_application/hardware_http.hpp"
 #include "fri3d_application/hardware_wifi.hpp"
 
 namespace Fri3d::Application
@@ -9,6 +10,11 @@ class IHardwareManager
 {
 public:
     virtual Hardware::IWifi &getWifi() = 0;
+
+    /**
+     * @brief shared HTTP clients, which keep their connections open between requests
+     */
+    virtual Hardware::IHttp &getHttp() = 0;
 };
 
 } // namespace Fri3d::Application
@@ -10,6 +10,13 @@ namespace Fri3d::Application::Hardware
 class IWifi
 {
 public:
+    /**
+     * @brief initialize the wifi driver without connecting, so a later connect() is faster
+     *
+     * Calling this is optional, connect() will prepare the driver when needed.
+     */
+    virtual void prepare() = 0;
+
     /**
      * @brief connect the wifi
      *
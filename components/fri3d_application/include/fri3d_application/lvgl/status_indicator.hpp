@@ -0,0 +1,38 @@
+#pragma once
+
+#include <string>
+
+#include "lvgl.h"
+
+namespace Fri3d::Application::LVGL
+{
+
+/**
+ * @brief a small label in the corner of the display, over every screen, for work that continues in the background
+ *
+ * Unlike CWaitDialog it takes no input, so the badge stays usable while it is shown.
+ */
+class CStatusIndicator
+{
+private:
+    std::string text;
+    lv_obj_t *indicator;
+    lv_obj_t *label;
+
+public:
+    CStatusIndicator();
+    ~CStatusIndicator();
+
+    CStatusIndicator(const CStatusIndicator &) = delete;
+    CStatusIndicator &operator=(const CStatusIndicator &) = delete;
+
+    /**
+     * @brief change the text, the display is only touched when it differs
+     */
+    void setText(const char *value);
+
+    void show();
+    void hide();
+};
+
+} // namespace Fri3d::Application::LVGL
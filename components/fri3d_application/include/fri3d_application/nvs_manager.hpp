@@ -1,40 +1,97 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
+#include <string>
 
 #include "nvs.h"
 
 namespace Fri3d::Application
 {
 
+class CNvsNamespace;
+
 /**
- * @brief the handle will auto-convert to nvs_handle_t and will commit and close when it goes out of scope.
- * While you can call `nvs_commit()` on the handle yourself, you should never call `nvs_close()` on it.
+ * @brief cached access to a single NVS namespace, all copies of a handle share the same cache
+ *
+ * All values in the namespace are read into RAM once, when it is opened for the first time. Writes only update the
+ * cache, unchanged values are never written. Changed values are committed to flash in batches: shortly after the first
+ * change, when calling commit() and at shutdown.
  *
+ * Blobs are the exception: they are read from flash on every call and written and committed immediately, so large
+ * values don't take up RAM.
  */
 class CNvsHandle
 {
 private:
-    std::shared_ptr<nvs_handle_t> handle;
-    std::string ns;
+    std::shared_ptr<CNvsNamespace> ns;
 
-    explicit CNvsHandle(const char *ns);
-    friend class INvsManager;
+    explicit CNvsHandle(std::shared_ptr<CNvsNamespace> ns);
+    friend class CNvsManager;
 
 public:
-    CNvsHandle(const CNvsHandle &other);
-    ~CNvsHandle();
+    /**
+     * @brief check if a key exists in the namespace
+     */
+    [[nodiscard]] bool contains(const char *key) const;
 
-    CNvsHandle &operator=(const CNvsHandle &other);
-    operator nvs_handle_t(); // NOLINT(google-explicit-constructor)
+    [[nodiscard]] int32_t getI32(const char *key, int32_t defaultValue = 0) const;
+    void setI32(const char *key, int32_t value);
+
+    [[nodiscard]] uint16_t getU16(const char *key, uint16_t defaultValue = 0) const;
+    void setU16(const char *key, uint16_t value);
+
+    [[nodiscard]] uint8_t getU8(const char *key, uint8_t defaultValue = 0) const;
+    void setU8(const char *key, uint8_t value);
 
     /**
-     * @brief convenience function to fetch strings and auto-convert them to std::string
+     * @brief fetch a string value
      *
      * @param key
      * @return std::string containing the value, empty string if the key does not exist or is empty
      */
-    std::string getString(const char *key);
+    [[nodiscard]] std::string getString(const char *key) const;
+    void setString(const char *key, const std::string &value);
+
+    /**
+     * @brief read a blob straight from flash
+     *
+     * @return false if the key does not exist or could not be read
+     */
+    [[nodiscard]] bool getBlob(const char *key, std::string &value) const;
+
+    /**
+     * @brief write and commit a blob straight to flash
+     *
+     * @return false if it could not be written, for example because the partition is full
+     */
+    bool setBlob(const char *key, const std::string &value);
+
+    /**
+     * @brief remove a blob from flash and commit, a blob that doesn't exist counts as removed
+     *
+     * @return false if it could not be removed
+     */
+    bool eraseBlob(const char *key);
+
+    /**
+     * @brief write all pending changes in this namespace to flash immediately
+     */
+    void commit();
+};
+
+struct CNvsStatistics
+{
+    // Values served from the cache
+    uint32_t reads;
+    // Values actually written to flash
+    uint32_t writes;
+    // Writes skipped because the value did not change
+    uint32_t writesAvoided;
+    // Writes skipped because the value changed again before it was committed
+    uint32_t writesCoalesced;
+    // Number of commits to flash
+    uint32_t commits;
 };
 
 class INvsManager
@@ -47,13 +104,24 @@ public:
      *
      * @return an open handle
      */
-    virtual CNvsHandle open(const char *ns);
+    virtual CNvsHandle open(const char *ns) = 0;
 
     /**
-     * @brief open the
-     * @return
+     * @brief open the system namespace, shared by all firmwares on the badge
+     *
+     * @return an open handle
      */
     virtual CNvsHandle openSys() = 0;
+
+    /**
+     * @brief write all pending changes in all namespaces to flash immediately
+     */
+    virtual void flush() = 0;
+
+    /**
+     * @return counters on the usage of the cache
+     */
+    [[nodiscard]] virtual CNvsStatistics getStatistics() const = 0;
 };
 
 } // namespace Fri3d::Application
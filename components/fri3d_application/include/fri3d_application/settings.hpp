@@ -0,0 +1,309 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "fri3d_application/nvs_manager.hpp"
+
+namespace Fri3d::Application
+{
+
+/**
+ * @brief the NVS namespace shared by all firmwares on the badge
+ */
+inline constexpr const char *SYS_NAMESPACE = "fri3d.sys";
+
+/**
+ * @brief Base of all settings, keeps a registry of every setting declared in the firmware
+ *
+ * Settings register themselves on construction, so they should be declared at namespace scope. All registered settings
+ * are loaded in one pass when the NVS Manager is initialized.
+ */
+class CSettingBase
+{
+private:
+    static inline CSettingBase *first = nullptr;
+    CSettingBase *next;
+
+protected:
+    const char *ns;
+    const char *key;
+
+    std::optional<CNvsHandle> handle;
+
+    CSettingBase(const char *ns, const char *key);
+
+    /**
+     * @brief copy the value from NVS into the in-RAM snapshot
+     */
+    virtual void load() = 0;
+
+    CNvsHandle &getHandle();
+
+public:
+    virtual ~CSettingBase() = default;
+
+    CSettingBase(const CSettingBase &) = delete;
+    CSettingBase &operator=(const CSettingBase &) = delete;
+
+    /**
+     * @brief load all registered settings, called by the NVS Manager during initialization
+     */
+    static void loadAll(INvsManager &nvs);
+
+    /**
+     * @brief release the NVS handles of all registered settings, called by the NVS Manager during deinitialization
+     */
+    static void unloadAll();
+};
+
+/**
+ * @brief maps a setting type onto the typed accessors of CNvsHandle
+ */
+template <typename T> struct CSettingTraits;
+
+template <> struct CSettingTraits<int32_t>
+{
+    static int32_t read(const CNvsHandle &handle, const char *key, int32_t defaultValue)
+    {
+        return handle.getI32(key, defaultValue);
+    }
+
+    static void write(CNvsHandle &handle, const char *key, int32_t value)
+    {
+        handle.setI32(key, value);
+    }
+};
+
+template <> struct CSettingTraits<uint16_t>
+{
+    static uint16_t read(const CNvsHandle &handle, const char *key, uint16_t defaultValue)
+    {
+        return handle.getU16(key, defaultValue);
+    }
+
+    static void write(CNvsHandle &handle, const char *key, uint16_t value)
+    {
+        handle.setU16(key, value);
+    }
+};
+
+template <> struct CSettingTraits<uint8_t>
+{
+    static uint8_t read(const CNvsHandle &handle, const char *key, uint8_t defaultValue)
+    {
+        return handle.getU8(key, defaultValue);
+    }
+
+    static void write(CNvsHandle &handle, const char *key, uint8_t value)
+    {
+        handle.setU8(key, value);
+    }
+};
+
+// Booleans are stored as u8, so other firmwares can easily read them
+template <> struct CSettingTraits<bool>
+{
+    static bool read(const CNvsHandle &handle, const char *key, bool defaultValue)
+    {
+        return handle.getU8(key, defaultValue ? 1 : 0) != 0;
+    }
+
+    static void write(CNvsHandle &handle, const char *key, bool value)
+    {
+        handle.setU8(key, value ? 1 : 0);
+    }
+};
+
+template <> struct CSettingTraits<std::string>
+{
+    static std::string read(const CNvsHandle &handle, const char *key, const std::string &defaultValue)
+    {
+        return handle.contains(key) ? handle.getString(key) : defaultValue;
+    }
+
+    static void write(CNvsHandle &handle, const char *key, const std::string &value)
+    {
+        handle.setString(key, value);
+    }
+};
+
+/**
+ * @brief in-RAM snapshot of a setting, lock-free for integer types
+ */
+template <typename T> class CSettingValue
+{
+private:
+    std::atomic<T> value;
+
+public:
+    explicit CSettingValue(T value)
+        : value(value)
+    {
+    }
+
+    T load() const
+    {
+        return this->value.load(std::memory_order_relaxed);
+    }
+
+    void store(const T &newValue)
+    {
+        this->value.store(newValue, std::memory_order_relaxed);
+    }
+};
+
+template <> class CSettingValue<std::string>
+{
+private:
+    std::string value;
+    mutable std::mutex valueMutex;
+
+public:
+    explicit CSettingValue(std::string value)
+        : value(std::move(value))
+    {
+    }
+
+    std::string load() const
+    {
+        std::lock_guard lock(this->valueMutex);
+        return this->value;
+    }
+
+    void store(const std::string &newValue)
+    {
+        std::lock_guard lock(this->valueMutex);
+        this->value = newValue;
+    }
+};
+
+/**
+ * @brief a typed setting stored in NVS
+ *
+ * Reads are served from an in-RAM snapshot and never touch NVS. Writes update the snapshot, go through the NVS cache
+ * (which batches the actual flash writes) and notify all subscribers when the value changed.
+ *
+ * Declare settings at namespace scope, for example:
+ *
+ *     CSetting<bool> fastBoot(SYS_NAMESPACE, "fastBoot", false);
+ */
+template <typename T> class CSetting : public CSettingBase
+{
+public:
+    typedef std::function<void(const T &value)> CCallback;
+
+private:
+    const T defaultValue;
+    CSettingValue<T> value;
+
+    std::vector<std::pair<int, CCallback>> subscribers;
+    std::mutex subscribersMutex;
+    int nextSubscriber;
+
+    void load() override
+    {
+        this->value.store(CSettingTraits<T>::read(this->getHandle(), this->key, this->defaultValue));
+    }
+
+    void notify(const T &newValue)
+    {
+        // Work on a copy, so callbacks are free to (un)subscribe
+        decltype(this->subscribers) targets;
+        {
+            std::lock_guard lock(this->subscribersMutex);
+            targets = this->subscribers;
+        }
+
+        for (const auto &target : targets)
+        {
+            target.second(newValue);
+        }
+    }
+
+public:
+    /**
+     * @param[in]ns NVS namespace the setting is stored in
+     * @param[in]key NVS key, checked at compile time to fit NVS
+     * @param[in]defaultValue value used when the key is not stored in NVS
+     */
+    template <std::size_t N>
+    CSetting(const char *ns, const char (&key)[N], T defaultValue)
+        : CSettingBase(ns, key)
+        , defaultValue(defaultValue)
+        , value(defaultValue)
+        , nextSubscriber(0)
+    {
+        static_assert(N <= NVS_KEY_NAME_MAX_SIZE, "NVS keys can be at most 15 characters long");
+    }
+
+    /**
+     * @return the current value, without any NVS access
+     */
+    [[nodiscard]] T get() const
+    {
+        return this->value.load();
+    }
+
+    /**
+     * @return the value used when nothing is stored in NVS
+     */
+    [[nodiscard]] const T &getDefault() const
+    {
+        return this->defaultValue;
+    }
+
+    /**
+     * @brief change the value, subscribers are only notified when it actually changed
+     */
+    void set(const T &newValue)
+    {
+        bool changed = this->value.load() != newValue;
+        this->value.store(newValue);
+
+        // Always pass it on, the NVS cache skips the write when the value is already stored
+        CSettingTraits<T>::write(this->getHandle(), this->key, newValue);
+
+        if (changed)
+        {
+            this->notify(newValue);
+        }
+    }
+
+    /**
+     * @brief get notified whenever the value changes. The callback is called from the task changing the value.
+     *
+     * @return id to unsubscribe with
+     */
+    int subscribe(CCallback callback)
+    {
+        std::lock_guard lock(this->subscribersMutex);
+        this->subscribers.emplace_back(this->nextSubscriber, std::move(callback));
+
+        return this->nextSubscriber++;
+    }
+
+    void unsubscribe(int id)
+    {
+        std::lock_guard lock(this->subscribersMutex);
+        std::erase_if(this->subscribers, [id](const auto &item) { return item.first == id; });
+    }
+};
+
+namespace Settings
+{
+
+/**
+ * @brief always boot in fast boot mode, skipping the splash screen
+ */
+extern CSetting<bool> fastBoot;
+
+} // namespace Settings
+
+} // namespace Fri3d::Application
@@ -47,6 +47,26 @@ INvsManager &CBaseApp::impl::getNvsManager() const
     return *this->nvsManager;
 }
 
+void CBaseApp::impl::setInitialized(bool value)
+{
+    this->initialized = value;
+}
+
+bool CBaseApp::impl::getInitialized() const
+{
+    return this->initialized;
+}
+
+void CBaseApp::impl::setLastActivated(uint32_t value)
+{
+    this->lastActivated = value;
+}
+
+uint32_t CBaseApp::impl::getLastActivated() const
+{
+    return this->lastActivated;
+}
+
 IAppManager &CBaseApp::getAppManager() const
 {
     return this->base->getAppManager();
@@ -62,6 +82,21 @@ INvsManager &CBaseApp::getNvsManager() const
     return this->base->getNvsManager();
 }
 
+void CBaseApp::preload()
+{
+    // Empty implementation
+}
+
+bool CBaseApp::getReclaimable() const
+{
+    return false;
+}
+
+bool CBaseApp::getHighlighted() const
+{
+    return false;
+}
+
 void CBaseApp::onSystemStart()
 {
     // Empty implementation
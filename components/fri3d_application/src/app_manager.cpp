@@ -1,9 +1,12 @@
 #include <algorithm>
 
+#include "esp_heap_caps.h"
 #include "esp_log.h"
 
+#include "fri3d_application/boot_profiler.hpp"
 #include "fri3d_private/app.hpp"
 #include "fri3d_private/app_manager.hpp"
+#include "fri3d_private/handoff.hpp"
 
 namespace Fri3d::Application
 {
@@ -13,8 +16,10 @@ static const char *TAG = "Fri3d::Application::CAppManager";
 CAppManager::CAppManager()
     : CThread<AppManagerEvent>(TAG)
     , defaultApp(nullptr)
+    , activations(0)
     , hardwareManager(nullptr)
     , nvsManager(nullptr)
+    , fastBoot(false)
 {
     esp_log_level_set(TAG, static_cast<esp_log_level_t>(LOG_LOCAL_LEVEL));
 }
@@ -24,6 +29,9 @@ void CAppManager::init(IHardwareManager &hardware, INvsManager &nvs)
     ESP_LOGI(TAG, "Initializing");
     this->hardwareManager = &hardware;
     this->nvsManager = &nvs;
+
+    // The boot completes in the flush of LVGL, the report is printed from here
+    bootProfiler.setOnComplete([this]() { this->sendEvent({AppManagerEvent::BootCompleted, nullptr}); });
 }
 
 void CAppManager::deinit()
@@ -31,12 +39,14 @@ void CAppManager::deinit()
     ESP_LOGI(TAG, "Deinitializing all apps");
     for (auto app : this->apps)
     {
-        const_cast<CBaseApp *>(app)->deinit();
+        CAppManager::deinitApp(const_cast<CBaseApp *>(app));
     }
 
     ESP_LOGI(TAG, "Deinitializing");
     this->apps = std::vector<const CBaseApp *>();
 
+    bootProfiler.setOnComplete(nullptr);
+
     this->nvsManager = nullptr;
     this->hardwareManager = nullptr;
 }
@@ -44,12 +54,15 @@ void CAppManager::deinit()
 void CAppManager::registerApp(CBaseApp &app)
 {
     ESP_LOGI(TAG, "Registering new app (%s)", app.getName());
+    bootProfiler.mark("registerApp", app.getName());
 
     app.base->setAppManager(this);
     app.base->setHardwareManager(this->hardwareManager);
     app.base->setNvsManager(this->nvsManager);
 
-    app.init();
+    // Initialization is deferred until the app gets activated for the first time
+    app.base->setInitialized(false);
+    app.base->setLastActivated(0);
 
     this->apps.push_back(&app);
 }
@@ -103,6 +116,70 @@ void CAppManager::previousApp()
     this->sendEvent({AppManagerEvent::PreviousApp, nullptr});
 }
 
+void CAppManager::setFastBoot(bool value)
+{
+    this->fastBoot = value;
+}
+
+bool CAppManager::getFastBoot() const
+{
+    return this->fastBoot;
+}
+
+void CAppManager::storeHandoff() const
+{
+    std::vector<uint8_t> indices;
+
+    for (auto app : this->navigation)
+    {
+        auto it = std::find(this->apps.begin(), this->apps.end(), app);
+        indices.push_back(it - this->apps.begin());
+    }
+
+    CHandoff::store(indices);
+}
+
+bool CAppManager::takeHandoff()
+{
+    return CHandoff::take(this->handoff);
+}
+
+bool CAppManager::restoreNavigation()
+{
+    if (this->handoff.empty())
+    {
+        return false;
+    }
+
+    // The last app is the one that booted the other firmware, we return to the one before it
+    this->handoff.pop_back();
+
+    NavigationList restored;
+    for (auto index : this->handoff)
+    {
+        if (index >= this->apps.size())
+        {
+            ESP_LOGW(TAG, "Invalid navigation state handed over, ignoring");
+            restored.clear();
+            break;
+        }
+
+        restored.push_back(const_cast<CBaseApp *>(this->apps[index]));
+    }
+
+    this->handoff.clear();
+
+    if (restored.empty())
+    {
+        return false;
+    }
+
+    this->navigation = restored;
+    bootProfiler.mark("navigation restored");
+
+    return true;
+}
+
 void CAppManager::switchApp(CBaseApp *from, CBaseApp *to)
 {
     if (from)
@@ -111,8 +188,70 @@ void CAppManager::switchApp(CBaseApp *from, CBaseApp *to)
         from->deactivate();
     }
 
+    CAppManager::initApp(to);
+
     ESP_LOGD(TAG, "Activating app (%s)", to->getName());
+    to->base->setLastActivated(++this->activations);
     to->activate();
+
+    this->reclaimApps(to);
+}
+
+void CAppManager::initApp(CBaseApp *app)
+{
+    if (!app->base->getInitialized())
+    {
+        ESP_LOGI(TAG, "Initializing app (%s)", app->getName());
+        app->init();
+        app->base->setInitialized(true);
+    }
+}
+
+void CAppManager::deinitApp(CBaseApp *app)
+{
+    if (app->base->getInitialized())
+    {
+        ESP_LOGI(TAG, "Deinitializing app (%s)", app->getName());
+        app->deinit();
+        app->base->setInitialized(false);
+    }
+}
+
+void CAppManager::reclaimApps(const CBaseApp *active) const
+{
+    auto freeHeap = heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+
+    while (freeHeap < CONFIG_FRI3D_APP_RECLAIM_THRESHOLD)
+    {
+        // Find the least recently used app that is allowed to be reclaimed
+        CBaseApp *candidate = nullptr;
+
+        for (auto item : this->apps)
+        {
+            auto app = const_cast<CBaseApp *>(item);
+
+            if (app == active || !app->base->getInitialized() || !app->getReclaimable())
+            {
+                continue;
+            }
+
+            if (candidate == nullptr || app->base->getLastActivated() < candidate->base->getLastActivated())
+            {
+                candidate = app;
+            }
+        }
+
+        if (candidate == nullptr)
+        {
+            ESP_LOGW(TAG, "Low on memory (%u bytes free), but no apps left to reclaim", freeHeap);
+            break;
+        }
+
+        ESP_LOGI(TAG, "Low on memory (%u bytes free), reclaiming app (%s)", freeHeap, candidate->getName());
+        CAppManager::deinitApp(candidate);
+
+        freeHeap = heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+    }
 }
 
 void CAppManager::onEvent(const AppManagerEvent &event)
@@ -133,21 +272,38 @@ void CAppManager::onEvent(const AppManagerEvent &event)
         ESP_LOGD(TAG, "Default app activated, cleaning navigation history.");
         this->navigation = NavigationList();
 
+        if (this->restoreNavigation())
+        {
+            ESP_LOGI(TAG, "Returning to app (%s)", this->navigation.back()->getName());
+            this->switchApp(previous, this->navigation.back());
+            break;
+        }
+
         // We fall through to app activation
         [[fallthrough]];
 
     case AppManagerEvent::ActivateApp:
         this->navigation.push_back(event.targetApp);
-        CAppManager::switchApp(previous, event.targetApp);
+        this->switchApp(previous, event.targetApp);
         break;
 
     case AppManagerEvent::PreviousApp:
         if (this->navigation.size() > 1)
         {
             this->navigation.pop_back();
-            CAppManager::switchApp(previous, this->navigation.back());
+            this->switchApp(previous, this->navigation.back());
         }
         break;
+
+    case AppManagerEvent::BootCompleted:
+        bootProfiler.report();
+        break;
+    }
+
+    // The screen of the default app is loaded now, the next frame shows it
+    if (event.eventType == AppManagerEvent::ActivateDefaultApp)
+    {
+        bootProfiler.markInteractive();
     }
 }
 
@@ -1,8 +1,15 @@
 #include <chrono>
+#include <cstring>
 #include <thread>
 
+#include "driver/gpio.h"
 #include "esp_log.h"
+#include "esp_ota_ops.h"
 
+#include "fri3d_application/boot_profiler.hpp"
+#include "fri3d_application/frame_stats.hpp"
+#include "fri3d_application/settings.hpp"
+#include "fri3d_bsp/bsp.h"
 #include "fri3d_private/application.hpp"
 
 using namespace std::chrono_literals;
@@ -27,14 +34,100 @@ void CApplication::init()
     }
 
     ESP_LOGI(TAG, "Initializing application");
-    this->hardwareManager.init();
-    this->nvsManager.init();
-    this->lvgl.init();
-    this->appManager.init(this->hardwareManager, this->nvsManager);
+    bootProfiler.mark("CApplication::init");
+
+    // Independent subsystems are brought up concurrently. The display takes the longest, so it gets the last core to
+    // itself while the main task continues registering apps.
+    this->bootGraph.add("hardware", {}, [this]() { this->hardwareManager.init(); });
+    this->bootGraph.add("nvs", {}, [this]() { this->nvsManager.init(); });
+    this->bootGraph.add("lvgl", {}, [this]() { this->lvgl.init(); }, CONFIG_FREERTOS_NUMBER_OF_CORES - 1);
+    this->bootGraph.add("appManager", {"hardware", "nvs"}, [this]() {
+        this->appManager.init(this->hardwareManager, this->nvsManager);
+    });
+    this->bootGraph.add("bootMode", {"nvs"}, [this]() { this->appManager.setFastBoot(this->detectFastBoot()); });
+
+    // Apps can be registered as soon as the App Manager is ready, the display is awaited in run()
+    this->bootGraph.wait("appManager");
+
+    bootProfiler.registerCommands(console);
+    frameStats.registerCommands(console);
+    this->nvsManager.registerCommands(console);
+    console.registerCommand(
+        "fastboot",
+        "Show or change the fast boot setting: `fastboot [on|off]`",
+        [this](int argc, char **argv) { return this->fastBootCommand(argc, argv); });
+    console.start();
+
+    bootProfiler.mark("CApplication::init", "done");
 
     this->initialized = true;
 }
 
+bool CApplication::detectFastBoot()
+{
+    // Returning from another firmware that was started from one of our apps
+    if (this->appManager.takeHandoff())
+    {
+        ESP_LOGI(TAG, "Fast boot: returning from another firmware");
+        return true;
+    }
+
+    // Explicitly enabled in NVS
+    if (Settings::fastBoot.get())
+    {
+        ESP_LOGI(TAG, "Fast boot: enabled in NVS");
+        return true;
+    }
+
+    // The B button is held during boot, the button driver isn't running yet so we read the pin directly
+    gpio_config_t button = {
+        .pin_bit_mask = 1ULL << BSP_BUTTON_B_IO,
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_ENABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_DISABLE,
+    };
+    ESP_ERROR_CHECK(gpio_config(&button));
+    std::this_thread::sleep_for(1ms);
+
+    if (gpio_get_level(BSP_BUTTON_B_IO) == 0)
+    {
+        ESP_LOGI(TAG, "Fast boot: button held");
+        return true;
+    }
+
+    // First boot after an OTA update
+    esp_ota_img_states_t state;
+    if (esp_ota_get_state_partition(esp_ota_get_running_partition(), &state) == ESP_OK &&
+        state == ESP_OTA_IMG_PENDING_VERIFY)
+    {
+        ESP_LOGI(TAG, "Fast boot: new firmware");
+        return true;
+    }
+
+    return false;
+}
+
+int CApplication::fastBootCommand(int argc, char **argv)
+{
+    if (argc == 2 && (strcmp(argv[1], "on") == 0 || strcmp(argv[1], "off") == 0))
+    {
+        Settings::fastBoot.set(strcmp(argv[1], "on") == 0);
+    }
+    else if (argc != 1)
+    {
+        printf("Usage: %s [on|off]\n", argv[0]);
+        return 1;
+    }
+
+    printf(
+        "Fast boot is %s, this boot was %s\n",
+        Settings::fastBoot.get() ? "on" : "off",
+        this->appManager.getFastBoot() ? "fast" : "normal");
+
+    return 0;
+}
+
 void CApplication::deinit()
 {
     if (!this->initialized)
@@ -43,6 +136,9 @@ void CApplication::deinit()
         return;
     }
 
+    // Make sure nothing is still initializing in the background
+    this->bootGraph.wait();
+
     this->appManager.deinit();
     this->lvgl.deinit();
     this->hardwareManager.deinit();
@@ -58,6 +154,16 @@ IAppManager &CApplication::getAppManager()
 
 void CApplication::run(const CBaseApp &app)
 {
+    // All registered apps get to preload concurrently, while the display might still be initializing
+    for (auto item : this->appManager.getApps())
+    {
+        auto target = const_cast<CBaseApp *>(item);
+        this->bootGraph.add(target->getName(), {"appManager"}, [target]() { target->preload(); });
+    }
+
+    this->bootGraph.wait();
+    bootProfiler.mark("preload", "done");
+
     this->lvgl.start();
 
     this->appManager.setDefaultApp(app);
@@ -67,6 +173,13 @@ void CApplication::run(const CBaseApp &app)
 
     this->appManager.activateDefaultApp();
 
+    if (this->appManager.getFastBoot())
+    {
+        // The launcher is shown without waiting on the rest, so warm up the wifi driver in the background
+        this->bootGraph.add("wifi", {}, [this]() { this->hardwareManager.getWifi().prepare(); });
+        this->bootGraph.wait();
+    }
+
     ESP_LOGI(TAG, "Starting application loop");
     this->running = true;
 
@@ -0,0 +1,231 @@
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "esp_cpu.h"
+#include "esp_log.h"
+#include "esp_pthread.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+
+#include "fri3d_private/boot_graph.hpp"
+
+namespace Fri3d::Application
+{
+
+static const char *TAG = "Fri3d::Application::CBootGraph";
+
+CBootGraph::CBootGraph()
+    : created(esp_timer_get_time())
+{
+    esp_log_level_set(TAG, static_cast<esp_log_level_t>(LOG_LOCAL_LEVEL));
+}
+
+CBootGraph::~CBootGraph()
+{
+    for (auto &node : this->nodes)
+    {
+        if (node.worker.joinable())
+        {
+            node.worker.join();
+        }
+    }
+}
+
+CBootGraph::CNode *CBootGraph::find(const char *name)
+{
+    auto it = std::find_if(
+        this->nodes.begin(),
+        this->nodes.end(),
+        [name](const CNode &node) { return strcmp(node.name, name) == 0; });
+
+    return it == this->nodes.end() ? nullptr : &*it;
+}
+
+void CBootGraph::add(
+    const char *name,
+    std::initializer_list<const char *> dependencies,
+    std::function<void()> function,
+    int core)
+{
+    CNode *node;
+
+    {
+        std::lock_guard lock(this->nodesMutex);
+
+        if (this->find(name) != nullptr)
+        {
+            throw std::runtime_error("Boot graph node already exists");
+        }
+
+        std::vector<CNode *> resolved;
+        for (auto dependency : dependencies)
+        {
+            auto target = this->find(dependency);
+            if (target == nullptr)
+            {
+                // Only allowing dependencies on existing nodes keeps the graph free of cycles
+                throw std::runtime_error("Boot graph dependency does not exist");
+            }
+            resolved.push_back(target);
+        }
+
+        node = &this->nodes.emplace_back();
+        node->name = name;
+        node->dependencies = std::move(resolved);
+        node->function = std::move(function);
+        node->core = core;
+        node->done = false;
+        node->started = 0;
+        node->finished = 0;
+        node->ranOnCore = NoAffinity;
+    }
+
+    // The pthread configuration is applied to the next thread created from this task
+    auto config = esp_pthread_get_default_config();
+    config.thread_name = name;
+    config.pin_to_core = core == NoAffinity ? tskNO_AFFINITY : core;
+    ESP_ERROR_CHECK(esp_pthread_set_cfg(&config));
+
+    node->worker = std::thread(&CBootGraph::run, this, node);
+
+    auto defaults = esp_pthread_get_default_config();
+    ESP_ERROR_CHECK(esp_pthread_set_cfg(&defaults));
+}
+
+void CBootGraph::run(CNode *node)
+{
+    std::exception_ptr error;
+
+    {
+        std::unique_lock lock(this->nodesMutex);
+        this->nodesChanged.wait(lock, [node]() {
+            return std::all_of(
+                node->dependencies.begin(),
+                node->dependencies.end(),
+                [](const CNode *dependency) { return dependency->done; });
+        });
+
+        for (auto dependency : node->dependencies)
+        {
+            if (dependency->error)
+            {
+                ESP_LOGE(TAG, "Skipping %s, dependency %s failed", node->name, dependency->name);
+                error = dependency->error;
+                break;
+            }
+        }
+    }
+
+    auto started = esp_timer_get_time();
+
+    if (!error)
+    {
+        ESP_LOGD(TAG, "Running %s", node->name);
+
+        try
+        {
+            node->function();
+        }
+        catch (...)
+        {
+            ESP_LOGE(TAG, "Node %s failed", node->name);
+            error = std::current_exception();
+        }
+    }
+
+    auto finished = esp_timer_get_time();
+
+    {
+        std::lock_guard lock(this->nodesMutex);
+        node->started = started - this->created;
+        node->finished = finished - this->created;
+        node->ranOnCore = esp_cpu_get_core_id();
+        node->error = error;
+        node->done = true;
+    }
+
+    this->nodesChanged.notify_all();
+}
+
+void CBootGraph::wait(const char *name)
+{
+    std::unique_lock lock(this->nodesMutex);
+
+    auto node = this->find(name);
+    if (node == nullptr)
+    {
+        throw std::runtime_error("Boot graph node does not exist");
+    }
+
+    this->nodesChanged.wait(lock, [node]() { return node->done; });
+
+    if (node->error)
+    {
+        std::rethrow_exception(node->error);
+    }
+}
+
+void CBootGraph::wait()
+{
+    for (auto &node : this->nodes)
+    {
+        if (node.worker.joinable())
+        {
+            node.worker.join();
+        }
+    }
+
+    this->report();
+
+    std::exception_ptr error;
+    for (const auto &node : this->nodes)
+    {
+        if (node.error)
+        {
+            error = node.error;
+            break;
+        }
+    }
+
+    this->nodes.clear();
+    this->created = esp_timer_get_time();
+
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+}
+
+void CBootGraph::report() const
+{
+    if (this->nodes.empty())
+    {
+        return;
+    }
+
+    int64_t total = 0;
+    int64_t busy = 0;
+
+    ESP_LOGI(TAG, "Boot graph timing (start, duration, core):");
+    for (const auto &node : this->nodes)
+    {
+        auto duration = node.finished - node.started;
+
+        ESP_LOGI(
+            TAG,
+            "  %-16s %6lld ms %6lld ms  %d%s",
+            node.name,
+            node.started / 1000,
+            duration / 1000,
+            node.ranOnCore,
+            node.error ? "  (failed)" : "");
+
+        total = std::max(total, node.finished);
+        busy += duration;
+    }
+
+    ESP_LOGI(TAG, "Boot graph completed in %lld ms, %lld ms of work", total / 1000, busy / 1000);
+}
+
+} // namespace Fri3d::Application
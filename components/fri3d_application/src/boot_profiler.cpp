@@ -0,0 +1,347 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+#include "esp_attr.h"
+#include "esp_cpu.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+
+#include "fri3d_private/boot_profiler.hpp"
+
+namespace Fri3d::Application
+{
+
+static const char *TAG = "Fri3d::Application::CBootProfiler";
+
+static const uint32_t BENCHMARK_MAGIC = 0x46334242; // F3BB
+
+// The benchmark results need to survive a software reset, so they live in RTC memory that is not initialized at boot
+struct CBenchmark
+{
+    uint32_t magic;
+    uint32_t remaining;
+    uint32_t runs;
+    uint32_t overBudget;
+    uint32_t count;
+
+    struct
+    {
+        uint32_t hash;
+        uint32_t min;
+        uint32_t max;
+        uint64_t sum;
+    } entries[CBootProfiler::MaxMarks];
+};
+
+static RTC_NOINIT_ATTR CBenchmark benchmark;
+
+static CBootProfiler bootProfiler_impl;
+IBootProfiler &bootProfiler = bootProfiler_impl;
+
+CBootProfiler::CBootProfiler()
+    : marks()
+    , count(0)
+    , interactive(false)
+    , completed(false)
+    , onComplete()
+{
+    esp_log_level_set(TAG, static_cast<esp_log_level_t>(LOG_LOCAL_LEVEL));
+}
+
+uint32_t CBootProfiler::hash(const char *event, const char *detail)
+{
+    // FNV-1a, the benchmark results can't hold pointers as they need to survive a reboot
+    uint32_t result = 2166136261u;
+
+    for (auto part : {event, "/", detail})
+    {
+        for (auto c = part; c != nullptr && *c != '\0'; c++)
+        {
+            result = (result ^ static_cast<uint8_t>(*c)) * 16777619u;
+        }
+    }
+
+    return result;
+}
+
+void CBootProfiler::mark(const char *event, const char *detail)
+{
+    if (this->completed)
+    {
+        return;
+    }
+
+    auto time = static_cast<uint32_t>(esp_timer_get_time());
+    auto index = this->count.fetch_add(1);
+
+    if (index >= MaxMarks)
+    {
+        return;
+    }
+
+    auto &item = this->marks[index];
+    item.event = event;
+    item.detail = detail;
+    item.time = time;
+    item.core = esp_cpu_get_core_id();
+    item.valid = true;
+}
+
+void CBootProfiler::markInteractive()
+{
+    if (this->interactive.exchange(true))
+    {
+        return;
+    }
+
+    this->mark("default app activated");
+}
+
+void CBootProfiler::frameRendered()
+{
+    if (!this->interactive || this->completed)
+    {
+        return;
+    }
+
+    this->mark("first interactive frame");
+
+    if (this->completed.exchange(true))
+    {
+        return;
+    }
+
+    // Printing and rebooting for the benchmark take too long for the flush of a frame
+    if (this->onComplete)
+    {
+        this->onComplete();
+    }
+}
+
+void CBootProfiler::setOnComplete(CCallback callback)
+{
+    this->onComplete = std::move(callback);
+}
+
+void CBootProfiler::report()
+{
+    this->printTimeline();
+    this->aggregate();
+}
+
+void CBootProfiler::printTimeline() const
+{
+    const CMark *sorted[MaxMarks];
+    int size = 0;
+
+    for (const auto &item : this->marks)
+    {
+        if (item.valid)
+        {
+            sorted[size++] = &item;
+        }
+    }
+
+    // Concurrent markers can end up slightly out of order
+    std::sort(sorted, sorted + size, [](const CMark *a, const CMark *b) { return a->time < b->time; });
+
+    ESP_LOGI(TAG, "Boot timeline (time, delta, core):");
+
+    uint32_t previous = 0;
+    for (int i = 0; i < size; i++)
+    {
+        auto item = sorted[i];
+        auto delta = item->time - previous;
+        previous = item->time;
+
+        ESP_LOGI(
+            TAG,
+            "  %5lu.%03lu ms  +%5lu.%03lu ms  %d  %s%s%s",
+            item->time / 1000,
+            item->time % 1000,
+            delta / 1000,
+            delta % 1000,
+            item->core,
+            item->event,
+            item->detail ? ": " : "",
+            item->detail ? item->detail : "");
+    }
+
+    if (!this->completed)
+    {
+        ESP_LOGI(TAG, "Boot has not completed yet");
+        return;
+    }
+
+    auto total = previous / 1000;
+    if (CONFIG_FRI3D_BOOT_BUDGET_MS > 0 && total > CONFIG_FRI3D_BOOT_BUDGET_MS)
+    {
+        ESP_LOGE(TAG, "Boot took %lu ms, exceeding the budget of %d ms", total, CONFIG_FRI3D_BOOT_BUDGET_MS);
+    }
+    else
+    {
+        ESP_LOGI(TAG, "Boot took %lu ms", total);
+    }
+}
+
+void CBootProfiler::aggregate()
+{
+    if (benchmark.magic != BENCHMARK_MAGIC || benchmark.remaining == 0 || benchmark.count > MaxMarks)
+    {
+        return;
+    }
+
+    if (esp_reset_reason() != ESP_RST_SW)
+    {
+        // Somebody pressed reset or we crashed, the results can't be trusted
+        ESP_LOGW(TAG, "Benchmark interrupted, aborting");
+        benchmark.remaining = 0;
+        return;
+    }
+
+    uint32_t total = 0;
+
+    for (const auto &item : this->marks)
+    {
+        if (!item.valid)
+        {
+            continue;
+        }
+
+        total = std::max(total, item.time);
+
+        auto key = CBootProfiler::hash(item.event, item.detail);
+        auto entry = std::find_if(
+            benchmark.entries,
+            benchmark.entries + benchmark.count,
+            [key](const auto &x) { return x.hash == key; });
+
+        if (entry == benchmark.entries + benchmark.count)
+        {
+            if (benchmark.count == MaxMarks)
+            {
+                continue;
+            }
+
+            benchmark.count++;
+            *entry = {key, item.time, item.time, 0};
+        }
+
+        entry->min = std::min(entry->min, item.time);
+        entry->max = std::max(entry->max, item.time);
+        entry->sum += item.time;
+    }
+
+    benchmark.runs++;
+    if (CONFIG_FRI3D_BOOT_BUDGET_MS > 0 && total / 1000 > CONFIG_FRI3D_BOOT_BUDGET_MS)
+    {
+        benchmark.overBudget++;
+    }
+
+    if (--benchmark.remaining > 0)
+    {
+        ESP_LOGI(TAG, "Benchmark run %lu done, %lu runs left, rebooting", benchmark.runs, benchmark.remaining);
+        esp_restart();
+    }
+
+    this->printBenchmark();
+}
+
+void CBootProfiler::printBenchmark() const
+{
+    if (benchmark.magic != BENCHMARK_MAGIC || benchmark.runs == 0 || benchmark.count > MaxMarks)
+    {
+        ESP_LOGI(TAG, "No benchmark results available");
+        return;
+    }
+
+    ESP_LOGI(TAG, "Boot benchmark over %lu runs (min, avg, max):", benchmark.runs);
+
+    for (uint32_t i = 0; i < benchmark.count; i++)
+    {
+        const auto &entry = benchmark.entries[i];
+
+        // Look up the name in the current timeline, the benchmark only keeps hashes
+        const char *event = "unknown";
+        const char *detail = nullptr;
+        for (const auto &item : this->marks)
+        {
+            if (item.valid && CBootProfiler::hash(item.event, item.detail) == entry.hash)
+            {
+                event = item.event;
+                detail = item.detail;
+                break;
+            }
+        }
+
+        ESP_LOGI(
+            TAG,
+            "  %5lu %5lu %5lu ms  %s%s%s",
+            entry.min / 1000,
+            static_cast<uint32_t>(entry.sum / benchmark.runs / 1000),
+            entry.max / 1000,
+            event,
+            detail ? ": " : "",
+            detail ? detail : "");
+    }
+
+    if (CONFIG_FRI3D_BOOT_BUDGET_MS > 0)
+    {
+        ESP_LOGI(
+            TAG,
+            "%lu of %lu runs exceeded the budget of %d ms",
+            benchmark.overBudget,
+            benchmark.runs,
+            CONFIG_FRI3D_BOOT_BUDGET_MS);
+    }
+}
+
+int CBootProfiler::command(int argc, char **argv)
+{
+    if (argc == 1)
+    {
+        this->printTimeline();
+        return 0;
+    }
+
+    if (strcmp(argv[1], "bench") == 0)
+    {
+        if (argc == 2)
+        {
+            this->printBenchmark();
+            return 0;
+        }
+
+        auto runs = strtol(argv[2], nullptr, 10);
+        if (runs <= 0)
+        {
+            printf("Invalid number of runs: %s\n", argv[2]);
+            return 1;
+        }
+
+        memset(&benchmark, 0, sizeof(benchmark));
+        benchmark.magic = BENCHMARK_MAGIC;
+        benchmark.remaining = runs;
+
+        printf("Rebooting %ld times\n", runs);
+        esp_restart();
+    }
+
+    printf("Usage: %s [bench [runs]]\n", argv[0]);
+    return 1;
+}
+
+void CBootProfiler::registerCommands(IConsole &target)
+{
+    target.registerCommand(
+        "boot",
+        "Print the boot timeline. `boot bench <runs>` reboots the given number of times and aggregates the timelines, "
+        "`boot bench` prints the results.",
+        [this](int argc, char **argv) { return this->command(argc, argv); });
+}
+
+} // namespace Fri3d::Application
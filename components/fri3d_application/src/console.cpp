@@ -0,0 +1,105 @@
+#include "esp_log.h"
+
+#include "fri3d_private/console.hpp"
+
+namespace Fri3d::Application
+{
+
+static const char *TAG = "Fri3d::Application::CConsole";
+
+static CConsole console_impl;
+IConsole &console = console_impl;
+
+CConsole::CConsole()
+    : repl(nullptr)
+{
+    esp_log_level_set(TAG, static_cast<esp_log_level_t>(LOG_LOCAL_LEVEL));
+}
+
+void CConsole::start()
+{
+#ifdef CONFIG_FRI3D_CONSOLE
+    std::lock_guard lock(this->commandsMutex);
+    if (this->repl != nullptr)
+    {
+        throw std::runtime_error("Console already started");
+    }
+
+    esp_console_repl_config_t repl_config = ESP_CONSOLE_REPL_CONFIG_DEFAULT();
+    repl_config.prompt = "fri3d>";
+
+#if defined(CONFIG_ESP_CONSOLE_UART_DEFAULT) || defined(CONFIG_ESP_CONSOLE_UART_CUSTOM)
+    esp_console_dev_uart_config_t hw_config = ESP_CONSOLE_DEV_UART_CONFIG_DEFAULT();
+    ESP_ERROR_CHECK(esp_console_new_repl_uart(&hw_config, &repl_config, &this->repl));
+#elif defined(CONFIG_ESP_CONSOLE_USB_CDC)
+    esp_console_dev_usb_cdc_config_t hw_config = ESP_CONSOLE_DEV_CDC_CONFIG_DEFAULT();
+    ESP_ERROR_CHECK(esp_console_new_repl_usb_cdc(&hw_config, &repl_config, &this->repl));
+#elif defined(CONFIG_ESP_CONSOLE_USB_SERIAL_JTAG)
+    esp_console_dev_usb_serial_jtag_config_t hw_config = ESP_CONSOLE_DEV_USB_SERIAL_JTAG_CONFIG_DEFAULT();
+    ESP_ERROR_CHECK(esp_console_new_repl_usb_serial_jtag(&hw_config, &repl_config, &this->repl));
+#else
+#error Unsupported console type
+#endif
+
+    ESP_ERROR_CHECK(esp_console_register_help_command());
+
+    // Install everything that was registered before we were started
+    for (const auto &item : this->commands)
+    {
+        CConsole::install(item.first.c_str(), item.second.help);
+    }
+
+    ESP_ERROR_CHECK(esp_console_start_repl(this->repl));
+
+    ESP_LOGI(TAG, "Started");
+#endif
+}
+
+void CConsole::registerCommand(const char *command, const char *help, CCommand handler)
+{
+    std::lock_guard lock(this->commandsMutex);
+
+    auto result = this->commands.emplace(command, CEntry{help, std::move(handler)});
+    if (!result.second)
+    {
+        throw std::runtime_error("Console command already registered");
+    }
+
+    if (this->repl != nullptr)
+    {
+        CConsole::install(result.first->first.c_str(), help);
+    }
+}
+
+void CConsole::install(const char *command, const char *help)
+{
+    const esp_console_cmd_t cmd = {
+        .command = command,
+        .help = help,
+        .hint = nullptr,
+        .func = CConsole::dispatch,
+        .argtable = nullptr,
+    };
+
+    ESP_ERROR_CHECK(esp_console_cmd_register(&cmd));
+}
+
+int CConsole::dispatch(int argc, char **argv)
+{
+    // esp_console does not pass any context, so we look the handler up by the name of the command
+    CCommand handler;
+
+    {
+        std::lock_guard lock(console_impl.commandsMutex);
+        auto item = console_impl.commands.find(argv[0]);
+        if (item == console_impl.commands.end())
+        {
+            return 1;
+        }
+        handler = item->second.handler;
+    }
+
+    return handler(argc, argv);
+}
+
+} // namespace Fri3d::Application
@@ -0,0 +1,119 @@
+#include <cstring>
+
+#include "esp_log.h"
+
+#include "fri3d_private/frame_stats.hpp"
+
+namespace Fri3d::Application
+{
+
+static const char *TAG = "Fri3d::Application::CFrameStats";
+
+static const uint32_t BUDGET = CONFIG_FRI3D_FRAME_BUDGET_MS * 1000;
+
+static CFrameStats frameStats_impl;
+IFrameStats &frameStats = frameStats_impl;
+
+CFrameStats::CFrameStats()
+    : frames(0)
+    , overBudget(0)
+    , total(0)
+    , worst(0)
+{
+    esp_log_level_set(TAG, static_cast<esp_log_level_t>(LOG_LOCAL_LEVEL));
+}
+
+void CFrameStats::frameDone(uint32_t duration)
+{
+    this->frames++;
+    this->total += duration;
+
+    if (duration > BUDGET)
+    {
+        this->overBudget++;
+    }
+
+    // Only the LVGL thread records, a reset in between at most loses this frame
+    if (duration > this->worst)
+    {
+        this->worst = duration;
+    }
+}
+
+void CFrameStats::reset()
+{
+    this->frames = 0;
+    this->overBudget = 0;
+    this->total = 0;
+    this->worst = 0;
+}
+
+IFrameStats::CSummary CFrameStats::getSummary() const
+{
+    CSummary result = {
+        .frames = this->frames,
+        .overBudget = this->overBudget,
+        .average = 0,
+        .worst = this->worst,
+    };
+
+    if (result.frames > 0)
+    {
+        result.average = static_cast<uint32_t>(this->total / result.frames);
+    }
+
+    return result;
+}
+
+void CFrameStats::print(const char *title) const
+{
+    auto summary = this->getSummary();
+
+    if (summary.overBudget > 0)
+    {
+        ESP_LOGW(
+            TAG,
+            "%s: %lu frames, %lu over the budget of %d ms, average %lu us, worst %lu ms",
+            title,
+            summary.frames,
+            summary.overBudget,
+            CONFIG_FRI3D_FRAME_BUDGET_MS,
+            summary.average,
+            summary.worst / 1000);
+    }
+    else
+    {
+        ESP_LOGI(
+            TAG,
+            "%s: %lu frames, all within the budget of %d ms, average %lu us, worst %lu ms",
+            title,
+            summary.frames,
+            CONFIG_FRI3D_FRAME_BUDGET_MS,
+            summary.average,
+            summary.worst / 1000);
+    }
+}
+
+int CFrameStats::command(int argc, char **argv)
+{
+    if (argc > 1 && strcmp(argv[1], "reset") == 0)
+    {
+        this->reset();
+        return 0;
+    }
+
+    this->print("Frames");
+
+    return 0;
+}
+
+void CFrameStats::registerCommands(IConsole &target)
+{
+    target.registerCommand(
+        "frames",
+        "Print how many frames the UI rendered within the frame budget since the last reset, `frames reset` starts "
+        "counting again.",
+        [this](int argc, char **argv) { return this->command(argc, argv); });
+}
+
+} // namespace Fri3d::Application
@@ -0,0 +1,86 @@
+#include <cstring>
+
+#include "esp_app_desc.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "esp_system.h"
+
+#include "fri3d_private/handoff.hpp"
+
+namespace Fri3d::Application
+{
+
+static const char *TAG = "Fri3d::Application::CHandoff";
+
+static const uint32_t HANDOFF_MAGIC = 0x46334844; // F3HD
+
+static const int ELF_SHA_SIZE = 8;
+
+struct CHandoffRecord
+{
+    uint32_t magic;
+    uint32_t crc;
+
+    // Everything below is covered by the crc
+    uint8_t elfSha[ELF_SHA_SIZE];
+    uint8_t navigationSize;
+    uint8_t navigation[CHandoff::MaxNavigation];
+};
+
+static RTC_NOINIT_ATTR CHandoffRecord handoff;
+
+static uint32_t checksum(const CHandoffRecord &record)
+{
+    auto start = reinterpret_cast<const uint8_t *>(&record.elfSha);
+    auto end = reinterpret_cast<const uint8_t *>(&record) + sizeof(record);
+
+    return esp_rom_crc32_le(0, start, end - start);
+}
+
+void CHandoff::store(const std::vector<uint8_t> &navigation)
+{
+    esp_log_level_set(TAG, static_cast<esp_log_level_t>(LOG_LOCAL_LEVEL));
+
+    if (navigation.empty() || navigation.size() > MaxNavigation)
+    {
+        ESP_LOGW(TAG, "Navigation state does not fit the handoff record, not storing it");
+        handoff.magic = 0;
+        return;
+    }
+
+    memset(&handoff, 0, sizeof(handoff));
+    memcpy(handoff.elfSha, esp_app_get_description()->app_elf_sha256, ELF_SHA_SIZE);
+    handoff.navigationSize = navigation.size();
+    memcpy(handoff.navigation, navigation.data(), navigation.size());
+
+    handoff.crc = checksum(handoff);
+    handoff.magic = HANDOFF_MAGIC;
+
+    ESP_LOGD(TAG, "Stored navigation state of %d apps", handoff.navigationSize);
+}
+
+bool CHandoff::take(std::vector<uint8_t> &navigation)
+{
+    esp_log_level_set(TAG, static_cast<esp_log_level_t>(LOG_LOCAL_LEVEL));
+
+    // RTC memory is only preserved over software resets, after anything else it contains garbage
+    bool valid = esp_reset_reason() == ESP_RST_SW && handoff.magic == HANDOFF_MAGIC && handoff.crc == checksum(handoff) &&
+                 handoff.navigationSize > 0 && handoff.navigationSize <= MaxNavigation &&
+                 memcmp(handoff.elfSha, esp_app_get_description()->app_elf_sha256, ELF_SHA_SIZE) == 0;
+
+    // Make sure the record is only used once
+    handoff.magic = 0;
+
+    if (!valid)
+    {
+        return false;
+    }
+
+    navigation.assign(handoff.navigation, handoff.navigation + handoff.navigationSize);
+    ESP_LOGI(TAG, "Found navigation state of %d apps", handoff.navigationSize);
+
+    return true;
+}
+
+} // namespace Fri3d::Application
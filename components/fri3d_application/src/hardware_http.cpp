@@ -0,0 +1,337 @@
+#include <algorithm>
+#include <strings.h>
+
+#include "esp_crt_bundle.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "fri3d_private/hardware_http.hpp"
+
+namespace Fri3d::Application::Hardware
+{
+
+static const char *TAG = "Fri3d::Application::Hardware::CHttp";
+
+CHttpClient::CHttpClient(IHttp &http, esp_http_client_handle_t handle)
+    : http(&http)
+    , handle(handle)
+{
+}
+
+CHttpClient::~CHttpClient()
+{
+    if (this->handle == nullptr)
+    {
+        return;
+    }
+
+    for (const auto &key : this->headers)
+    {
+        esp_http_client_delete_header(this->handle, key.c_str());
+    }
+
+    this->http->release(this->handle);
+}
+
+CHttpClient::CHttpClient(CHttpClient &&other) noexcept
+    : http(other.http)
+    , handle(other.handle)
+    , headers(std::move(other.headers))
+{
+    other.handle = nullptr;
+}
+
+esp_http_client_handle_t CHttpClient::get() const
+{
+    return this->handle;
+}
+
+CHttpClient::operator bool() const
+{
+    return this->handle != nullptr;
+}
+
+bool CHttpClient::setHeader(const char *key, const char *value)
+{
+    if (std::find(this->headers.begin(), this->headers.end(), key) == this->headers.end())
+    {
+        this->headers.emplace_back(key);
+    }
+
+    return ESP_OK == esp_http_client_set_header(this->handle, key, value);
+}
+
+void CHttpClient::watchHeader(const char *key)
+{
+    this->http->watchHeader(this->handle, key);
+}
+
+std::string CHttpClient::getHeader(const char *key) const
+{
+    return this->http->getHeader(this->handle, key);
+}
+
+CHttp::CHttp()
+    : counters()
+{
+    esp_log_level_set(TAG, static_cast<esp_log_level_t>(LOG_LOCAL_LEVEL));
+}
+
+void CHttp::init()
+{
+    ESP_LOGI(TAG, "Initialized");
+}
+
+void CHttp::deinit()
+{
+    std::lock_guard lock(this->entriesMutex);
+
+    for (auto &entry : this->entries)
+    {
+        if (entry.busy)
+        {
+            ESP_LOGW(TAG, "Client for %s is still in use", entry.origin.c_str());
+        }
+
+        esp_http_client_cleanup(entry.handle);
+    }
+    this->entries.clear();
+
+    ESP_LOGI(TAG, "Deinitialized");
+}
+
+std::string CHttp::getOrigin(const std::string &url)
+{
+    auto scheme = url.find("://");
+    auto start = scheme == std::string::npos ? 0 : scheme + 3;
+
+    return url.substr(0, url.find('/', start));
+}
+
+esp_err_t CHttp::eventHandler(esp_http_client_event_t *event)
+{
+    auto &entry = *static_cast<CEntry *>(event->user_data);
+
+    switch (event->event_id)
+    {
+    case HTTP_EVENT_ON_CONNECTED:
+        ESP_LOGD(TAG, "Connected to %s", entry.origin.c_str());
+        entry.http->counters.connections++;
+        break;
+    case HTTP_EVENT_HEADERS_SENT:
+        entry.http->counters.requests++;
+
+        // Only keep what belongs to the response of this request
+        for (auto &header : entry.headers)
+        {
+            header.value.clear();
+        }
+        break;
+    case HTTP_EVENT_ON_HEADER:
+        if (strcasecmp(event->header_key, "Connection") == 0 && strcasecmp(event->header_value, "close") == 0)
+        {
+            entry.closing = true;
+        }
+
+        for (auto &header : entry.headers)
+        {
+            if (strcasecmp(event->header_key, header.key.c_str()) == 0)
+            {
+                header.value = event->header_value;
+            }
+        }
+        break;
+    default:
+        break;
+    }
+
+    return ESP_OK;
+}
+
+esp_http_client_handle_t CHttp::create(CEntry &entry, const std::string &url)
+{
+    esp_http_client_config_t config({});
+
+    config.url = url.c_str();
+    config.timeout_ms = 5000;
+    config.crt_bundle_attach = esp_crt_bundle_attach;
+    config.keep_alive_enable = true;
+    config.buffer_size = 4096;
+    config.buffer_size_tx = 4096;
+    config.event_handler = CHttp::eventHandler;
+    config.user_data = &entry;
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+    // When the connection drops, the handshake of the next one is shortened by resuming the TLS session
+    config.save_client_session = true;
+#endif
+
+    return esp_http_client_init(&config);
+}
+
+CHttpClient CHttp::acquire(const std::string &url)
+{
+    std::lock_guard lock(this->entriesMutex);
+
+    auto origin = CHttp::getOrigin(url);
+    auto now = esp_timer_get_time();
+
+    auto entry = std::find_if(this->entries.begin(), this->entries.end(), [&origin](const CEntry &item) {
+        return !item.busy && item.origin == origin;
+    });
+
+    if (entry != this->entries.end())
+    {
+        // Servers drop idle connections after a while, better reconnect than to find out halfway a request
+        if (now - entry->lastUsed > CONFIG_FRI3D_HTTP_IDLE_TIMEOUT * 1000000LL)
+        {
+            esp_http_client_close(entry->handle);
+        }
+
+        esp_http_client_set_url(entry->handle, url.c_str());
+    }
+    else
+    {
+        // Make room by dropping the least recently used idle client
+        if (this->entries.size() >= CONFIG_FRI3D_HTTP_POOL_SIZE)
+        {
+            auto oldest = this->entries.end();
+            for (auto item = this->entries.begin(); item != this->entries.end(); item++)
+            {
+                if (!item->busy && (oldest == this->entries.end() || item->lastUsed < oldest->lastUsed))
+                {
+                    oldest = item;
+                }
+            }
+
+            if (oldest != this->entries.end())
+            {
+                esp_http_client_cleanup(oldest->handle);
+                this->entries.erase(oldest);
+            }
+        }
+
+        entry = this->entries.insert(
+            this->entries.end(),
+            CEntry{
+                .http = this,
+                .handle = nullptr,
+                .origin = origin,
+                .busy = false,
+                .closing = false,
+                .lastUsed = now,
+            });
+
+        entry->handle = this->create(*entry, url);
+        if (entry->handle == nullptr)
+        {
+            ESP_LOGE(TAG, "Could not create a client for %s", origin.c_str());
+            this->entries.erase(entry);
+            return {*this, nullptr};
+        }
+    }
+
+    entry->busy = true;
+    entry->closing = false;
+
+    return {*this, entry->handle};
+}
+
+std::list<CHttp::CEntry>::iterator CHttp::find(esp_http_client_handle_t handle)
+{
+    return std::find_if(this->entries.begin(), this->entries.end(), [handle](const CEntry &item) {
+        return item.handle == handle;
+    });
+}
+
+void CHttp::release(esp_http_client_handle_t handle)
+{
+    std::lock_guard lock(this->entriesMutex);
+
+    auto entry = this->find(handle);
+    if (entry == this->entries.end())
+    {
+        return;
+    }
+
+    // The connection can only be reused when nothing of the last response is left to read
+    if (entry->closing || !esp_http_client_is_complete_data_received(handle))
+    {
+        esp_http_client_close(handle);
+    }
+
+    entry->busy = false;
+    entry->lastUsed = esp_timer_get_time();
+    entry->headers.clear();
+
+    // The pool only grows beyond its size while all clients are in use
+    if (this->entries.size() > CONFIG_FRI3D_HTTP_POOL_SIZE)
+    {
+        esp_http_client_cleanup(handle);
+        this->entries.erase(entry);
+    }
+}
+
+void CHttp::watchHeader(esp_http_client_handle_t handle, const char *key)
+{
+    std::lock_guard lock(this->entriesMutex);
+
+    auto entry = this->find(handle);
+    if (entry == this->entries.end())
+    {
+        return;
+    }
+
+    entry->headers.push_back({key, ""});
+}
+
+std::string CHttp::getHeader(esp_http_client_handle_t handle, const char *key)
+{
+    std::lock_guard lock(this->entriesMutex);
+
+    auto entry = this->find(handle);
+    if (entry == this->entries.end())
+    {
+        return "";
+    }
+
+    for (const auto &header : entry->headers)
+    {
+        if (strcasecmp(header.key.c_str(), key) == 0)
+        {
+            return header.value;
+        }
+    }
+
+    return "";
+}
+
+void CHttp::closeIdle()
+{
+    std::lock_guard lock(this->entriesMutex);
+
+    std::erase_if(this->entries, [](const CEntry &entry) {
+        if (entry.busy)
+        {
+            return false;
+        }
+
+        esp_http_client_cleanup(entry.handle);
+        return true;
+    });
+
+    ESP_LOGI(
+        TAG,
+        "Closed idle connections, %lu requests over %lu connections so far",
+        this->counters.requests.load(),
+        this->counters.connections.load());
+}
+
+CHttpStatistics CHttp::getStatistics() const
+{
+    return {
+        .requests = this->counters.requests.load(),
+        .connections = this->counters.connections.load(),
+    };
+}
+
+} // namespace Fri3d::Application::Hardware
@@ -20,6 +20,7 @@ void CHardwareManager::init()
 
     // Initialize drivers
     this->wifi.init();
+    this->http.init();
 
     ESP_LOGI(TAG, "Initialized");
 }
@@ -27,6 +28,7 @@ void CHardwareManager::init()
 void CHardwareManager::deinit()
 {
     // Deinitialize drivers
+    this->http.deinit();
     this->wifi.deinit();
 
     // Disable the default event loop
@@ -40,4 +42,9 @@ Hardware::IWifi &CHardwareManager::getWifi()
     return this->wifi;
 }
 
+Hardware::IHttp &CHardwareManager::getHttp()
+{
+    return this->http;
+}
+
 } // namespace Fri3d::Application
@@ -15,6 +15,7 @@ CWifi::CWifi()
     , instanceAnyWifi(nullptr)
     , instanceGotIP(nullptr)
     , wifiConfig({})
+    , prepared(false)
     , connected(false)
 {
     esp_log_level_set(TAG, static_cast<esp_log_level_t>(LOG_LOCAL_LEVEL));
@@ -27,9 +28,15 @@ CWifi::CWifi()
     wifiConfig.sta.threshold.rssi = -127;
 }
 
-void CWifi::connect()
+void CWifi::prepare()
 {
-    ESP_LOGI(TAG, "Enabling wifi");
+    std::lock_guard<std::mutex> lock(this->preparedMutex);
+    if (this->prepared)
+    {
+        return;
+    }
+
+    ESP_LOGI(TAG, "Preparing wifi");
 
     // Start the network interface
     ESP_ERROR_CHECK(esp_netif_init());
@@ -58,6 +65,15 @@ void CWifi::connect()
     ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
     ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &this->wifiConfig));
 
+    this->prepared = true;
+}
+
+void CWifi::connect()
+{
+    this->prepare();
+
+    ESP_LOGI(TAG, "Enabling wifi");
+
     // Start the wifi
     ESP_ERROR_CHECK(esp_wifi_start());
 }
@@ -87,6 +103,9 @@ void CWifi::disconnect()
     esp_netif_destroy_default_wifi(this->networkInterface);
     this->networkInterface = nullptr;
     ESP_ERROR_CHECK(esp_netif_deinit());
+
+    std::lock_guard<std::mutex> lock(this->preparedMutex);
+    this->prepared = false;
 }
 
 void CWifi::init()
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+
 #include "fri3d_application/app.hpp"
 #include "fri3d_application/hardware_manager.hpp"
 
@@ -13,6 +15,10 @@ private:
     IHardwareManager *hardwareManager;
     INvsManager *nvsManager;
 
+    // Lifecycle information maintained by the app manager
+    bool initialized;
+    uint32_t lastActivated;
+
 public:
     void setAppManager(IAppManager *value);
     [[nodiscard]] IAppManager &getAppManager() const;
@@ -22,6 +28,12 @@ public:
 
     void setNvsManager(INvsManager *value);
     [[nodiscard]] INvsManager &getNvsManager() const;
+
+    void setInitialized(bool value);
+    [[nodiscard]] bool getInitialized() const;
+
+    void setLastActivated(uint32_t value);
+    [[nodiscard]] uint32_t getLastActivated() const;
 };
 
 } // namespace Fri3d::Application
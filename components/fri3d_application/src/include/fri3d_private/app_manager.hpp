@@ -12,6 +12,7 @@ EVENT_CREATE_TYPES_START()
     ActivateApp,
     ActivateDefaultApp,
     PreviousApp,
+    BootCompleted,
 EVENT_CREATE_TYPES_END()
     CBaseApp *targetApp;
 EVENT_CREATE_END()
@@ -26,7 +27,13 @@ private:
     CBaseApp *defaultApp;
 
     CBaseApp *checkApp(const CBaseApp &app);
-    static void switchApp(CBaseApp *from, CBaseApp *to);
+    void switchApp(CBaseApp *from, CBaseApp *to);
+
+    // Lazy initialization and reclaiming of apps
+    uint32_t activations;
+    static void initApp(CBaseApp *app);
+    static void deinitApp(CBaseApp *app);
+    void reclaimApps(const CBaseApp *active) const;
 
     // Pointers to other managers to store in the apps
     IHardwareManager *hardwareManager;
@@ -36,6 +43,12 @@ private:
 
     NavigationList navigation;
 
+    bool fastBoot;
+
+    // Navigation state handed over by the previous run of this firmware, see CHandoff
+    std::vector<uint8_t> handoff;
+    bool restoreNavigation();
+
 public:
     CAppManager();
 
@@ -50,6 +63,18 @@ public:
     void previousApp() override;
     void activateDefaultApp();
 
+    void setFastBoot(bool value);
+    [[nodiscard]] bool getFastBoot() const override;
+
+    void storeHandoff() const override;
+
+    /**
+     * @brief pick up the navigation state stored before booting into another firmware
+     *
+     * @return true if the badge is returning from another firmware
+     */
+    bool takeHandoff();
+
     // TODO: turn this into an event system for apps
     void notifyStartStop(bool start) const;
 };
@@ -2,6 +2,7 @@
 
 #include "fri3d_application/application.hpp"
 #include "fri3d_private/app_manager.hpp"
+#include "fri3d_private/boot_graph.hpp"
 #include "fri3d_private/hardware_manager.hpp"
 #include "fri3d_private/lvgl.hpp"
 #include "fri3d_private/nvs_manager.hpp"
@@ -20,6 +21,12 @@ private:
     CLVGL lvgl;
     CNvsManager nvsManager;
 
+    // Declared last, so any running initialization is joined before the managers are destroyed
+    CBootGraph bootGraph;
+
+    bool detectFastBoot();
+    int fastBootCommand(int argc, char **argv);
+
 public:
     CApplication();
 
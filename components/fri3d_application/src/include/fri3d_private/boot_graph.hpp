@@ -0,0 +1,87 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <initializer_list>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Fri3d::Application
+{
+
+/**
+ * @brief Runs initialization steps concurrently while respecting the dependencies between them
+ *
+ * Every node gets its own thread as soon as it is added. The thread waits until all of the node's dependencies have
+ * completed and then runs the node's function. Dependencies need to be added before the nodes depending on them, which
+ * also guarantees the graph can not contain any cycles.
+ */
+class CBootGraph
+{
+public:
+    static const int NoAffinity = -1;
+
+private:
+    struct CNode
+    {
+        const char *name;
+        std::vector<CNode *> dependencies;
+        std::function<void()> function;
+        int core;
+
+        std::thread worker;
+        bool done;
+        std::exception_ptr error;
+
+        // Timestamps in microseconds, relative to the creation of the graph
+        int64_t started;
+        int64_t finished;
+        int ranOnCore;
+    };
+
+    int64_t created;
+
+    std::list<CNode> nodes;
+    std::mutex nodesMutex;
+    std::condition_variable nodesChanged;
+
+    CNode *find(const char *name);
+    void run(CNode *node);
+    void report() const;
+
+public:
+    CBootGraph();
+    ~CBootGraph();
+
+    /**
+     * @brief Add a node to the graph and start it as soon as its dependencies are done
+     *
+     * @param[in]name unique name of the node, the pointer needs to stay valid for the lifetime of the graph
+     * @param[in]dependencies names of the nodes that need to complete first
+     * @param[in]function the work to perform
+     * @param[in]core the core to pin the node to, or NoAffinity
+     */
+    void add(
+        const char *name,
+        std::initializer_list<const char *> dependencies,
+        std::function<void()> function,
+        int core = NoAffinity);
+
+    /**
+     * @brief Wait until a single node has completed, rethrowing any exception it raised
+     */
+    void wait(const char *name);
+
+    /**
+     * @brief Wait until all nodes have completed, log the timing report and clear the graph
+     *
+     * The first exception raised by any of the nodes is rethrown after all of them have finished.
+     */
+    void wait();
+};
+
+} // namespace Fri3d::Application
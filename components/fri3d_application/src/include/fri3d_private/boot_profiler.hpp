@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "fri3d_application/boot_profiler.hpp"
+
+namespace Fri3d::Application
+{
+
+class CBootProfiler : public IBootProfiler
+{
+public:
+    static const int MaxMarks = 32;
+
+private:
+    struct CMark
+    {
+        const char *event;
+        const char *detail;
+        uint32_t time;
+        int core;
+        std::atomic<bool> valid;
+    };
+
+    CMark marks[MaxMarks];
+    std::atomic<int> count;
+
+    std::atomic<bool> interactive;
+    std::atomic<bool> completed;
+    CCallback onComplete;
+
+    static uint32_t hash(const char *event, const char *detail);
+
+    void aggregate();
+    void printBenchmark() const;
+    int command(int argc, char **argv);
+
+public:
+    CBootProfiler();
+
+    void mark(const char *event, const char *detail = nullptr) override;
+    void markInteractive() override;
+    void frameRendered() override;
+    void setOnComplete(CCallback callback) override;
+    void report() override;
+    void printTimeline() const override;
+    void registerCommands(IConsole &console) override;
+};
+
+} // namespace Fri3d::Application
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <string>
+
+#include "esp_console.h"
+
+#include "fri3d_application/console.hpp"
+
+namespace Fri3d::Application
+{
+
+class CConsole : public IConsole
+{
+private:
+    struct CEntry
+    {
+        const char *help;
+        CCommand handler;
+    };
+
+    std::map<std::string, CEntry> commands;
+    std::mutex commandsMutex;
+
+    esp_console_repl_t *repl;
+
+    static int dispatch(int argc, char **argv);
+    static void install(const char *command, const char *help);
+
+public:
+    CConsole();
+
+    void start() override;
+
+    void registerCommand(const char *command, const char *help, CCommand handler) override;
+};
+
+} // namespace Fri3d::Application
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "fri3d_application/frame_stats.hpp"
+
+namespace Fri3d::Application
+{
+
+class CFrameStats : public IFrameStats
+{
+private:
+    std::atomic<uint32_t> frames;
+    std::atomic<uint32_t> overBudget;
+    std::atomic<uint64_t> total;
+    std::atomic<uint32_t> worst;
+
+    int command(int argc, char **argv);
+
+public:
+    CFrameStats();
+
+    void frameDone(uint32_t duration) override;
+    void reset() override;
+    [[nodiscard]] CSummary getSummary() const override;
+    void print(const char *title) const override;
+    void registerCommands(IConsole &console) override;
+};
+
+} // namespace Fri3d::Application
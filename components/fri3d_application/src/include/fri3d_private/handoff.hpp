@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace Fri3d::Application
+{
+
+/**
+ * @brief Small record in RTC memory that survives switching to another firmware and back
+ *
+ * Before booting another partition, the navigation state is stored as indices into the list of registered apps. When
+ * the other firmware returns with a software reset, the record is picked up again so the badge can go straight back
+ * to where it was. The record is only valid for the exact same firmware image that wrote it.
+ */
+class CHandoff
+{
+public:
+    static const int MaxNavigation = 8;
+
+    /**
+     * @brief store the navigation state, the last entry is the app that boots the other firmware
+     */
+    static void store(const std::vector<uint8_t> &navigation);
+
+    /**
+     * @brief fetch and invalidate the stored navigation state
+     *
+     * @return false if there is no valid record
+     */
+    static bool take(std::vector<uint8_t> &navigation);
+};
+
+} // namespace Fri3d::Application
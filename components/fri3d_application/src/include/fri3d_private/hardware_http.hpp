@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "fri3d_application/hardware_http.hpp"
+
+namespace Fri3d::Application::Hardware
+{
+
+class CHttp : public IHttp
+{
+private:
+    struct CHeader
+    {
+        std::string key;
+        std::string value;
+    };
+
+    struct CEntry
+    {
+        CHttp *http;
+        esp_http_client_handle_t handle;
+        // Scheme, host and port, a client can only reuse its connection for the same origin
+        std::string origin;
+        bool busy;
+        // The server announced it will close the connection after the current response
+        bool closing;
+        int64_t lastUsed;
+        // Response headers the borrower asked for, with their value in the last response
+        std::vector<CHeader> headers;
+    };
+
+    // Entries are referenced by the event handler of their client, so they can't move
+    std::list<CEntry> entries;
+    std::mutex entriesMutex;
+
+    struct
+    {
+        std::atomic<uint32_t> requests;
+        std::atomic<uint32_t> connections;
+    } counters;
+
+    static std::string getOrigin(const std::string &url);
+    static esp_err_t eventHandler(esp_http_client_event_t *event);
+
+    esp_http_client_handle_t create(CEntry &entry, const std::string &url);
+    std::list<CEntry>::iterator find(esp_http_client_handle_t handle);
+
+protected:
+    void release(esp_http_client_handle_t handle) override;
+    void watchHeader(esp_http_client_handle_t handle, const char *key) override;
+    [[nodiscard]] std::string getHeader(esp_http_client_handle_t handle, const char *key) override;
+
+public:
+    CHttp();
+
+    void init();
+    void deinit();
+
+    CHttpClient acquire(const std::string &url) override;
+    void closeIdle() override;
+
+    [[nodiscard]] CHttpStatistics getStatistics() const override;
+};
+
+} // namespace Fri3d::Application::Hardware
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "fri3d_application/hardware_manager.hpp"
+#include "fri3d_private/hardware_http.hpp"
 #include "fri3d_private/hardware_wifi.hpp"
 
 namespace Fri3d::Application
@@ -10,6 +11,7 @@ class CHardwareManager : public IHardwareManager
 {
 private:
     Hardware::CWifi wifi;
+    Hardware::CHttp http;
 
 public:
     CHardwareManager();
@@ -18,6 +20,7 @@ public:
     void deinit();
 
     Hardware::IWifi &getWifi() override;
+    Hardware::IHttp &getHttp() override;
 };
 
 } // namespace Fri3d::Application
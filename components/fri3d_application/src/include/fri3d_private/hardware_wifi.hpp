@@ -18,6 +18,9 @@ private:
 
     wifi_config_t wifiConfig;
 
+    bool prepared;
+    std::mutex preparedMutex;
+
     bool connected;
     std::mutex connectedMutex;
     std::condition_variable connectedSignal;
@@ -30,6 +33,7 @@ public:
     void init();
     void deinit();
 
+    void prepare() override;
     void connect() override;
     void disconnect() override;
 
@@ -1,19 +1,108 @@
 #pragma once
 
+#include <atomic>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 
+#include "esp_timer.h"
+
+#include "fri3d_application/console.hpp"
 #include "fri3d_application/nvs_manager.hpp"
 
 namespace Fri3d::Application
 {
 
+class CNvsManager;
+
+class CNvsNamespace
+{
+private:
+    struct CEntry
+    {
+        nvs_type_t type;
+        // Holds all integer types
+        int32_t number;
+        std::string text;
+        bool dirty;
+    };
+
+    std::string name;
+    nvs_handle_t handle;
+    CNvsManager &manager;
+
+    std::map<std::string, CEntry> entries;
+    mutable std::mutex entriesMutex;
+
+    void loadEntry(const char *key, nvs_type_t type);
+
+    int32_t getNumber(const char *key, nvs_type_t type, int32_t defaultValue) const;
+    void setNumber(const char *key, nvs_type_t type, int32_t value);
+
+public:
+    CNvsNamespace(const char *name, CNvsManager &manager);
+    ~CNvsNamespace();
+
+    CNvsNamespace(const CNvsNamespace &) = delete;
+    CNvsNamespace &operator=(const CNvsNamespace &) = delete;
+
+    /**
+     * @brief read all values in the namespace into the cache in a single pass
+     */
+    void load();
+
+    /**
+     * @brief write all dirty values to flash and commit them
+     */
+    void flush();
+
+    [[nodiscard]] bool contains(const char *key) const;
+
+    [[nodiscard]] int32_t getI32(const char *key, int32_t defaultValue) const;
+    void setI32(const char *key, int32_t value);
+
+    [[nodiscard]] uint16_t getU16(const char *key, uint16_t defaultValue) const;
+    void setU16(const char *key, uint16_t value);
+
+    [[nodiscard]] uint8_t getU8(const char *key, uint8_t defaultValue) const;
+    void setU8(const char *key, uint8_t value);
+
+    [[nodiscard]] std::string getString(const char *key) const;
+    void setString(const char *key, const std::string &value);
+
+    [[nodiscard]] bool getBlob(const char *key, std::string &value) const;
+    bool setBlob(const char *key, const std::string &value);
+    bool eraseBlob(const char *key);
+};
+
 class CNvsManager : public INvsManager
 {
 private:
-    typedef std::map<std::string, CNvsHandle> NvsHandles;
-    NvsHandles handles;
+    typedef std::map<std::string, std::shared_ptr<CNvsNamespace>> CNamespaces;
+    CNamespaces namespaces;
+    std::mutex namespacesMutex;
+
+    esp_timer_handle_t commitTimer;
+    static void onCommitTimer(void *arg);
+    static void onShutdown();
+
+    int command(int argc, char **argv);
+
+    friend class CNvsNamespace;
+    struct
+    {
+        std::atomic<uint32_t> reads;
+        std::atomic<uint32_t> writes;
+        std::atomic<uint32_t> writesAvoided;
+        std::atomic<uint32_t> writesCoalesced;
+        std::atomic<uint32_t> commits;
+    } counters;
+
+    /**
+     * @brief called by the namespaces when they have changes that need to be committed
+     */
+    void scheduleCommit();
 
 public:
     CNvsManager();
@@ -23,6 +112,14 @@ public:
 
     CNvsHandle open(const char *ns) override;
     CNvsHandle openSys() override;
+
+    void flush() override;
+    [[nodiscard]] CNvsStatistics getStatistics() const override;
+
+    /**
+     * @brief register the `nvs` command, which prints the cache statistics
+     */
+    void registerCommands(IConsole &console);
 };
 
 } // namespace Fri3d::Application
@@ -1,12 +1,15 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
+#include <algorithm>
 #include <stdexcept>
 
 #include "esp_lcd_panel_ops.h"
 #include "esp_log.h"
 #include "esp_timer.h"
 
+#include "fri3d_application/boot_profiler.hpp"
+#include "fri3d_application/frame_stats.hpp"
 #include "fri3d_application/lvgl.hpp"
 #include "fri3d_bsp/bsp.h"
 #include "fri3d_private/lvgl.hpp"
@@ -77,13 +80,17 @@ CLVGL::~CLVGL()
 
 void CLVGL::init()
 {
+    bootProfiler.mark("CLVGL::init");
+
     if (this->panel == nullptr && this->panel_io == nullptr)
     {
         auto config = bsp_display_config_t{
             .max_transfer_sz = 100,
             .on_color_trans_done = CLVGL::on_color_trans_done,
             .user_ctx = this};
+        bootProfiler.mark("bsp_display_new");
         ESP_ERROR_CHECK(bsp_display_new(&config, &this->panel, &this->panel_io));
+        bootProfiler.mark("bsp_display_new", "done");
         ESP_ERROR_CHECK(esp_lcd_panel_disp_on_off(this->panel, true));
     }
 
@@ -132,6 +139,8 @@ void CLVGL::init()
     lv_unlock();
 
     this->indev.init();
+
+    bootProfiler.mark("CLVGL::init", "done");
 }
 
 void CLVGL::deinit()
@@ -154,6 +163,11 @@ void CLVGL::flush_cb(lv_display_t *display, const lv_area_t *area, uint8_t *data
 
     // Blit to the screen
     ESP_ERROR_CHECK(esp_lcd_panel_draw_bitmap(panel, area->x1, area->y1, area->x2 + 1, area->y2 + 1, data));
+
+    if (lv_display_flush_is_last(display))
+    {
+        bootProfiler.frameRendered();
+    }
 }
 
 bool CLVGL::on_color_trans_done(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_io_event_data_t *data, void *user_ctx)
@@ -206,18 +220,27 @@ void CLVGL::work() const
     // TODO: maybe put this together with thread creation in a CThreadManager?
     vTaskPrioritySet(NULL, uxTaskPriorityGet(NULL) + 5);
 
+    auto planned = esp_timer_get_time();
+
     while (this->running)
     {
+        auto start = esp_timer_get_time();
+
         // In LVGL 9.2 and above, the lock will be taken internally in lv_timer_handler() and should be removed here
         lv_lock();
         auto sleep_time = lv_timer_handler();
         lv_unlock();
 
+        // Starting later than planned means the thread could not run, for example during a flash erase
+        auto end = esp_timer_get_time();
+        frameStats.frameDone(static_cast<uint32_t>(end - std::min(start, planned)));
+
         if (sleep_time == LV_NO_TIMER_READY)
         {
             // There is nothing to be done, wait for 40 ms (== 25 fps)
             sleep_time = 40ul;
         }
+        planned = end + sleep_time * 1000;
         std::this_thread::sleep_for(std::chrono::milliseconds(sleep_time));
     }
 }
@@ -0,0 +1,72 @@
+#include "fri3d_application/lvgl/status_indicator.hpp"
+#include "fri3d_application/lvgl.hpp"
+
+namespace Fri3d::Application::LVGL
+{
+
+CStatusIndicator::CStatusIndicator()
+    : indicator(nullptr)
+    , label(nullptr)
+{
+}
+
+CStatusIndicator::~CStatusIndicator()
+{
+    this->hide();
+}
+
+void CStatusIndicator::setText(const char *value)
+{
+    lv_lock();
+
+    if (this->text != value)
+    {
+        this->text = value;
+
+        if (this->label != nullptr)
+        {
+            lv_label_set_text(this->label, this->text.c_str());
+        }
+    }
+
+    lv_unlock();
+}
+
+void CStatusIndicator::show()
+{
+    lv_lock();
+
+    if (this->indicator == nullptr)
+    {
+        // The top layer stays in place when apps load their screens
+        this->indicator = lv_obj_create(lv_layer_top());
+        lv_obj_set_size(this->indicator, LV_SIZE_CONTENT, LV_SIZE_CONTENT);
+        lv_obj_align(this->indicator, LV_ALIGN_TOP_RIGHT, -4, 4);
+        lv_obj_set_style_pad_all(this->indicator, 3, LV_PART_MAIN);
+        lv_obj_set_style_radius(this->indicator, 6, LV_PART_MAIN);
+        lv_obj_set_style_bg_opa(this->indicator, LV_OPA_80, LV_PART_MAIN);
+        lv_obj_remove_flag(this->indicator, LV_OBJ_FLAG_CLICKABLE);
+        lv_obj_remove_flag(this->indicator, LV_OBJ_FLAG_SCROLLABLE);
+
+        this->label = lv_label_create(this->indicator);
+        lv_label_set_text(this->label, this->text.c_str());
+    }
+
+    lv_unlock();
+}
+
+void CStatusIndicator::hide()
+{
+    lv_lock();
+
+    if (this->indicator != nullptr)
+    {
+        lv_obj_delete(this->indicator);
+        this->indicator = nullptr;
+        this->label = nullptr;
+    }
+
+    lv_unlock();
+}
+
+} // namespace Fri3d::Application::LVGL
@@ -1,9 +1,11 @@
-
-#include <fri3d_application/nvs_manager.hpp>
+#include <cstdio>
+#include <cstring>
 
 #include "esp_log.h"
+#include "esp_system.h"
 #include "nvs_flash.h"
 
+#include "fri3d_application/settings.hpp"
 #include "fri3d_private/nvs_manager.hpp"
 
 namespace Fri3d::Application
@@ -11,75 +13,395 @@ namespace Fri3d::Application
 
 static const char *TAG = "Fri3d::Application::CNvsManager";
 
-CNvsHandle::CNvsHandle(const char *ns)
-    : handle(std::make_shared<nvs_handle_t>())
-    , ns(ns)
+// Shutdown handlers don't take an argument, so we keep track of the active manager to flush it on restart
+static CNvsManager *activeManager = nullptr;
+
+CNvsHandle::CNvsHandle(std::shared_ptr<CNvsNamespace> ns)
+    : ns(std::move(ns))
 {
 }
 
-CNvsHandle::CNvsHandle(const CNvsHandle &other)
+bool CNvsHandle::contains(const char *key) const
 {
-    *this = other;
+    return this->ns->contains(key);
 }
 
-CNvsHandle::~CNvsHandle()
+int32_t CNvsHandle::getI32(const char *key, int32_t defaultValue) const
 {
-    // We commit anytime we go out of scope
-    ESP_ERROR_CHECK(nvs_commit(*this->handle));
+    return this->ns->getI32(key, defaultValue);
+}
+
+void CNvsHandle::setI32(const char *key, int32_t value)
+{
+    this->ns->setI32(key, value);
+}
+
+uint16_t CNvsHandle::getU16(const char *key, uint16_t defaultValue) const
+{
+    return this->ns->getU16(key, defaultValue);
+}
+
+void CNvsHandle::setU16(const char *key, uint16_t value)
+{
+    this->ns->setU16(key, value);
+}
+
+uint8_t CNvsHandle::getU8(const char *key, uint8_t defaultValue) const
+{
+    return this->ns->getU8(key, defaultValue);
+}
+
+void CNvsHandle::setU8(const char *key, uint8_t value)
+{
+    this->ns->setU8(key, value);
+}
+
+std::string CNvsHandle::getString(const char *key) const
+{
+    return this->ns->getString(key);
+}
+
+void CNvsHandle::setString(const char *key, const std::string &value)
+{
+    this->ns->setString(key, value);
+}
+
+bool CNvsHandle::getBlob(const char *key, std::string &value) const
+{
+    return this->ns->getBlob(key, value);
+}
+
+bool CNvsHandle::setBlob(const char *key, const std::string &value)
+{
+    return this->ns->setBlob(key, value);
+}
+
+bool CNvsHandle::eraseBlob(const char *key)
+{
+    return this->ns->eraseBlob(key);
+}
+
+void CNvsHandle::commit()
+{
+    this->ns->flush();
+}
+
+CNvsNamespace::CNvsNamespace(const char *name, CNvsManager &manager)
+    : name(name)
+    , handle(0)
+    , manager(manager)
+{
+    ESP_ERROR_CHECK(nvs_open(name, NVS_READWRITE, &this->handle));
+}
+
+CNvsNamespace::~CNvsNamespace()
+{
+    this->flush();
+    nvs_close(this->handle);
+}
+
+void CNvsNamespace::load()
+{
+    std::lock_guard lock(this->entriesMutex);
+
+    nvs_iterator_t it = nullptr;
+    esp_err_t err = nvs_entry_find(NVS_DEFAULT_PART_NAME, this->name.c_str(), NVS_TYPE_ANY, &it);
+
+    while (err == ESP_OK)
+    {
+        nvs_entry_info_t info;
+        ESP_ERROR_CHECK(nvs_entry_info(it, &info));
+
+        this->loadEntry(info.key, info.type);
+
+        err = nvs_entry_next(&it);
+    }
+
+    nvs_release_iterator(it);
 
-    // There's one reference always active in the map in CNvsManager. After this object is destructed, that's the only
-    // one left, so we can close the handle
-    if (this->handle.use_count() == 2)
+    if (err != ESP_ERR_NVS_NOT_FOUND)
     {
-        // We are the last one using the handle, close it
-        nvs_close(*this->handle);
+        ESP_ERROR_CHECK(err);
     }
+
+    ESP_LOGD(TAG, "Loaded %d values from namespace %s", this->entries.size(), this->name.c_str());
 }
 
-CNvsHandle::operator nvs_handle_t()
+void CNvsNamespace::loadEntry(const char *key, nvs_type_t type)
 {
-    return *this->handle;
+    CEntry entry = {type, 0, "", false};
+
+    switch (type)
+    {
+    case NVS_TYPE_I32:
+        ESP_ERROR_CHECK(nvs_get_i32(this->handle, key, &entry.number));
+        break;
+    case NVS_TYPE_U16: {
+        uint16_t value;
+        ESP_ERROR_CHECK(nvs_get_u16(this->handle, key, &value));
+        entry.number = value;
+        break;
+    }
+    case NVS_TYPE_U8: {
+        uint8_t value;
+        ESP_ERROR_CHECK(nvs_get_u8(this->handle, key, &value));
+        entry.number = value;
+        break;
+    }
+    case NVS_TYPE_STR: {
+        size_t size;
+        ESP_ERROR_CHECK(nvs_get_str(this->handle, key, nullptr, &size));
+
+        // The size includes the terminating zero
+        entry.text.resize(size);
+        ESP_ERROR_CHECK(nvs_get_str(this->handle, key, &entry.text.front(), &size));
+        entry.text.resize(size - 1);
+        break;
+    }
+    default:
+        // Not supported by the cache, other firmwares might use these
+        ESP_LOGV(TAG, "Not caching %s in namespace %s, unsupported type", key, this->name.c_str());
+        return;
+    }
+
+    this->entries[key] = entry;
 }
 
-CNvsHandle &CNvsHandle::operator=(const CNvsHandle &other)
+void CNvsNamespace::flush()
 {
-    if (&other != this)
+    std::lock_guard lock(this->entriesMutex);
+
+    bool changed = false;
+
+    for (auto &item : this->entries)
     {
-        this->handle = other.handle;
-        this->ns = other.ns;
+        auto &entry = item.second;
+        if (!entry.dirty)
+        {
+            continue;
+        }
 
-        if (this->handle.use_count() == 2)
+        auto key = item.first.c_str();
+        switch (entry.type)
         {
-            // Somebody wants to use this NVS namespace, let's open it!
-            ESP_ERROR_CHECK(nvs_open(this->ns.c_str(), NVS_READWRITE, this->handle.get()));
+        case NVS_TYPE_I32:
+            ESP_ERROR_CHECK(nvs_set_i32(this->handle, key, entry.number));
+            break;
+        case NVS_TYPE_U16:
+            ESP_ERROR_CHECK(nvs_set_u16(this->handle, key, static_cast<uint16_t>(entry.number)));
+            break;
+        case NVS_TYPE_U8:
+            ESP_ERROR_CHECK(nvs_set_u8(this->handle, key, static_cast<uint8_t>(entry.number)));
+            break;
+        case NVS_TYPE_STR:
+            ESP_ERROR_CHECK(nvs_set_str(this->handle, key, entry.text.c_str()));
+            break;
+        default:
+            break;
         }
+
+        entry.dirty = false;
+        changed = true;
+        this->manager.counters.writes++;
+    }
+
+    if (changed)
+    {
+        ESP_ERROR_CHECK(nvs_commit(this->handle));
+        this->manager.counters.commits++;
+        ESP_LOGD(TAG, "Committed namespace %s", this->name.c_str());
     }
+}
 
-    return *this;
+bool CNvsNamespace::contains(const char *key) const
+{
+    std::lock_guard lock(this->entriesMutex);
+    return this->entries.find(key) != this->entries.end();
 }
 
-std::string CNvsHandle::getString(const char *key)
+int32_t CNvsNamespace::getNumber(const char *key, nvs_type_t type, int32_t defaultValue) const
 {
-    size_t size;
-    esp_err_t err;
+    std::lock_guard lock(this->entriesMutex);
+    this->manager.counters.reads++;
 
-    err = nvs_get_str(*this->handle, key, nullptr, &size);
-    if (err == ESP_ERR_NVS_NOT_FOUND)
+    auto item = this->entries.find(key);
+    if (item == this->entries.end() || item->second.type != type)
+    {
+        return defaultValue;
+    }
+
+    return item->second.number;
+}
+
+void CNvsNamespace::setNumber(const char *key, nvs_type_t type, int32_t value)
+{
+    {
+        std::lock_guard lock(this->entriesMutex);
+
+        auto item = this->entries.find(key);
+        if (item != this->entries.end() && item->second.type == type)
+        {
+            if (item->second.number == value)
+            {
+                this->manager.counters.writesAvoided++;
+                return;
+            }
+
+            if (item->second.dirty)
+            {
+                this->manager.counters.writesCoalesced++;
+            }
+        }
+
+        this->entries[key] = {type, value, "", true};
+    }
+
+    this->manager.scheduleCommit();
+}
+
+int32_t CNvsNamespace::getI32(const char *key, int32_t defaultValue) const
+{
+    return this->getNumber(key, NVS_TYPE_I32, defaultValue);
+}
+
+void CNvsNamespace::setI32(const char *key, int32_t value)
+{
+    this->setNumber(key, NVS_TYPE_I32, value);
+}
+
+uint16_t CNvsNamespace::getU16(const char *key, uint16_t defaultValue) const
+{
+    return static_cast<uint16_t>(this->getNumber(key, NVS_TYPE_U16, defaultValue));
+}
+
+void CNvsNamespace::setU16(const char *key, uint16_t value)
+{
+    this->setNumber(key, NVS_TYPE_U16, value);
+}
+
+uint8_t CNvsNamespace::getU8(const char *key, uint8_t defaultValue) const
+{
+    return static_cast<uint8_t>(this->getNumber(key, NVS_TYPE_U8, defaultValue));
+}
+
+void CNvsNamespace::setU8(const char *key, uint8_t value)
+{
+    this->setNumber(key, NVS_TYPE_U8, value);
+}
+
+std::string CNvsNamespace::getString(const char *key) const
+{
+    std::lock_guard lock(this->entriesMutex);
+    this->manager.counters.reads++;
+
+    auto item = this->entries.find(key);
+    if (item == this->entries.end() || item->second.type != NVS_TYPE_STR)
     {
-        // Key does not exist
         return "";
     }
-    ESP_ERROR_CHECK(err);
 
-    std::string result;
-    result.resize(size);
+    return item->second.text;
+}
 
-    ESP_ERROR_CHECK(nvs_get_str(*this->handle, key, &result.front(), &size));
+void CNvsNamespace::setString(const char *key, const std::string &value)
+{
+    {
+        std::lock_guard lock(this->entriesMutex);
 
-    return result;
+        auto item = this->entries.find(key);
+        if (item != this->entries.end() && item->second.type == NVS_TYPE_STR)
+        {
+            if (item->second.text == value)
+            {
+                this->manager.counters.writesAvoided++;
+                return;
+            }
+
+            if (item->second.dirty)
+            {
+                this->manager.counters.writesCoalesced++;
+            }
+        }
+
+        this->entries[key] = {NVS_TYPE_STR, 0, value, true};
+    }
+
+    this->manager.scheduleCommit();
+}
+
+bool CNvsNamespace::getBlob(const char *key, std::string &value) const
+{
+    size_t size = 0;
+    esp_err_t err = nvs_get_blob(this->handle, key, nullptr, &size);
+
+    if (err == ESP_OK)
+    {
+        value.resize(size);
+        err = nvs_get_blob(this->handle, key, value.data(), &size);
+    }
+
+    if (err != ESP_OK)
+    {
+        if (err != ESP_ERR_NVS_NOT_FOUND)
+        {
+            ESP_LOGW(TAG, "Could not read %s in namespace %s: %s", key, this->name.c_str(), esp_err_to_name(err));
+        }
+
+        value.clear();
+        return false;
+    }
+
+    return true;
+}
+
+bool CNvsNamespace::setBlob(const char *key, const std::string &value)
+{
+    esp_err_t err = nvs_set_blob(this->handle, key, value.data(), value.size());
+    if (err == ESP_OK)
+    {
+        err = nvs_commit(this->handle);
+    }
+
+    if (err != ESP_OK)
+    {
+        ESP_LOGW(TAG, "Could not write %s in namespace %s: %s", key, this->name.c_str(), esp_err_to_name(err));
+        return false;
+    }
+
+    this->manager.counters.writes++;
+    this->manager.counters.commits++;
+
+    return true;
+}
+
+bool CNvsNamespace::eraseBlob(const char *key)
+{
+    esp_err_t err = nvs_erase_key(this->handle, key);
+    if (err == ESP_ERR_NVS_NOT_FOUND)
+    {
+        return true;
+    }
+
+    if (err == ESP_OK)
+    {
+        err = nvs_commit(this->handle);
+    }
+
+    if (err != ESP_OK)
+    {
+        ESP_LOGW(TAG, "Could not erase %s in namespace %s: %s", key, this->name.c_str(), esp_err_to_name(err));
+        return false;
+    }
+
+    this->manager.counters.writes++;
+    this->manager.counters.commits++;
+
+    return true;
 }
 
 CNvsManager::CNvsManager()
+    : commitTimer(nullptr)
+    , counters()
 {
     esp_log_level_set(TAG, static_cast<esp_log_level_t>(LOG_LOCAL_LEVEL));
 }
@@ -97,12 +419,42 @@ void CNvsManager::init()
     }
     ESP_ERROR_CHECK(err);
 
+    const esp_timer_create_args_t timerConfig = {
+        .callback = CNvsManager::onCommitTimer,
+        .arg = this,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "nvs_commit",
+        .skip_unhandled_events = true,
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timerConfig, &this->commitTimer));
+
+    // Make sure pending changes are written when anything restarts the badge
+    activeManager = this;
+    ESP_ERROR_CHECK(esp_register_shutdown_handler(CNvsManager::onShutdown));
+
+    // Take a snapshot of all declared settings, so they can be read without any NVS access
+    CSettingBase::loadAll(*this);
+
     ESP_LOGI(TAG, "Initialized");
 }
 
 void CNvsManager::deinit()
 {
-    this->handles = NvsHandles();
+    ESP_ERROR_CHECK(esp_unregister_shutdown_handler(CNvsManager::onShutdown));
+    activeManager = nullptr;
+
+    // Stopping fails if the timer isn't running, which is fine
+    esp_timer_stop(this->commitTimer);
+    ESP_ERROR_CHECK(esp_timer_delete(this->commitTimer));
+    this->commitTimer = nullptr;
+
+    CSettingBase::unloadAll();
+
+    {
+        // Destroying the namespaces commits any pending changes
+        std::lock_guard lock(this->namespacesMutex);
+        this->namespaces = CNamespaces();
+    }
 
     ESP_ERROR_CHECK(nvs_flash_deinit());
 
@@ -111,27 +463,96 @@ void CNvsManager::deinit()
 
 CNvsHandle CNvsManager::open(const char *ns)
 {
-    auto handle = this->handles.find(ns);
+    std::lock_guard lock(this->namespacesMutex);
+
+    auto item = this->namespaces.find(ns);
+    if (item == this->namespaces.end())
+    {
+        auto created = std::make_shared<CNvsNamespace>(ns, *this);
+        created->load();
+
+        item = this->namespaces.emplace(ns, created).first;
+    }
+
+    return CNvsHandle(item->second);
+}
+
+CNvsHandle CNvsManager::openSys()
+{
+    return this->open(SYS_NAMESPACE);
+}
+
+void CNvsManager::flush()
+{
+    std::lock_guard lock(this->namespacesMutex);
 
-    if (handle == this->handles.end())
+    for (auto &item : this->namespaces)
     {
-        return this->handles.emplace(std::make_pair(ns, INvsManager::open(ns))).first->second;
+        item.second->flush();
     }
-    else
+}
+
+CNvsStatistics CNvsManager::getStatistics() const
+{
+    return {
+        .reads = this->counters.reads,
+        .writes = this->counters.writes,
+        .writesAvoided = this->counters.writesAvoided,
+        .writesCoalesced = this->counters.writesCoalesced,
+        .commits = this->counters.commits,
+    };
+}
+
+void CNvsManager::scheduleCommit()
+{
+    // Changes are batched: the first change starts the timer, everything changed before it fires is committed together
+    if (this->commitTimer != nullptr && !esp_timer_is_active(this->commitTimer))
     {
-        return handle->second;
+        esp_timer_start_once(this->commitTimer, CONFIG_FRI3D_NVS_COMMIT_DELAY_MS * 1000);
     }
 }
 
-CNvsHandle CNvsManager::openSys()
+void CNvsManager::onCommitTimer(void *arg)
+{
+    static_cast<CNvsManager *>(arg)->flush();
+}
+
+void CNvsManager::onShutdown()
+{
+    if (activeManager != nullptr)
+    {
+        activeManager->flush();
+    }
+}
+
+int CNvsManager::command(int argc, char **argv)
 {
-    return this->open("fri3d.sys");
+    if (argc == 2 && strcmp(argv[1], "flush") == 0)
+    {
+        this->flush();
+    }
+    else if (argc != 1)
+    {
+        printf("Usage: %s [flush]\n", argv[0]);
+        return 1;
+    }
+
+    auto statistics = this->getStatistics();
+    printf("Reads from cache:  %lu\n", statistics.reads);
+    printf("Writes to flash:   %lu\n", statistics.writes);
+    printf("Writes avoided:    %lu\n", statistics.writesAvoided);
+    printf("Writes coalesced:  %lu\n", statistics.writesCoalesced);
+    printf("Commits:           %lu\n", statistics.commits);
+
+    return 0;
 }
 
-CNvsHandle INvsManager::open(const char *ns)
+void CNvsManager::registerCommands(IConsole &console)
 {
-    // We don't do any checking here, we just return the constructed object to the inherited class
-    return CNvsHandle(ns);
+    console.registerCommand(
+        "nvs",
+        "Print the NVS cache statistics, `nvs flush` commits all pending changes first",
+        [this](int argc, char **argv) { return this->command(argc, argv); });
 }
 
 } // namespace Fri3d::Application
@@ -69,6 +69,10 @@ void CPartitionBoot::activate()
         else
         {
             ESP_LOGI(TAG, "Booting into %s", this->partition);
+
+            // Remember where we were, so we can return there quickly
+            this->getAppManager().storeHandoff();
+
             // should we display something on the screen?
             std::this_thread::sleep_for(300ms);
 
@@ -0,0 +1,53 @@
+#include <stdexcept>
+
+#include "fri3d_application/settings.hpp"
+
+namespace Fri3d::Application
+{
+
+CSettingBase::CSettingBase(const char *ns, const char *key)
+    : next(CSettingBase::first)
+    , ns(ns)
+    , key(key)
+{
+    // Settings are declared at namespace scope and live forever, so they never need to be removed from the registry
+    CSettingBase::first = this;
+}
+
+CNvsHandle &CSettingBase::getHandle()
+{
+    if (!this->handle)
+    {
+        throw std::runtime_error("Settings have not been loaded yet");
+    }
+
+    return *this->handle;
+}
+
+void CSettingBase::loadAll(INvsManager &nvs)
+{
+    // Every namespace is read into the NVS cache in a single pass the first time it is opened, so this doesn't touch
+    // flash for every single setting
+    for (auto setting = CSettingBase::first; setting != nullptr; setting = setting->next)
+    {
+        setting->handle = nvs.open(setting->ns);
+        setting->load();
+    }
+}
+
+void CSettingBase::unloadAll()
+{
+    for (auto setting = CSettingBase::first; setting != nullptr; setting = setting->next)
+    {
+        setting->handle.reset();
+    }
+}
+
+namespace Settings
+{
+
+CSetting<bool> fastBoot(SYS_NAMESPACE, "fastBoot", false);
+
+} // namespace Settings
+
+} // namespace Fri3d::Application
@@ -1,6 +1,7 @@
 #include "esp_log.h"
 
 #include "fri3d_application/application.hpp"
+#include "fri3d_application/boot_profiler.hpp"
 #include "fri3d_application/partition_boot.hpp"
 #include "fri3d_hello/hello.hpp"
 #include "fri3d_launcher/launcher.hpp"
@@ -16,6 +17,7 @@ static const char *TAG = "main";
 void app_main(void)
 {
     esp_log_level_set(TAG, LOG_LOCAL_LEVEL);
+    bootProfiler.mark("app_main");
 
     application.init();
 
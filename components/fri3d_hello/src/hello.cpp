@@ -86,6 +86,11 @@ bool CHello::getVisible() const
     return true;
 }
 
+bool CHello::getReclaimable() const
+{
+    return true;
+}
+
 static CHello hello_impl;
 Application::CBaseApp &hello = hello_impl;
 
@@ -53,6 +53,13 @@ void CLauncher::activate()
 
     ESP_LOGD(TAG, "Found %d apps", apps.size());
 
+    if (!this->splashShown && this->getAppManager().getFastBoot())
+    {
+        // Skip the splash, but make sure we don't show it later on either
+        ESP_LOGI(TAG, "Fast boot, skipping Splash screen");
+        this->splashShown = true;
+    }
+
     if (!this->splashShown)
     {
         auto splash = this->findSplash(apps);
@@ -109,6 +116,13 @@ void CLauncher::show(CLauncher::IAppList apps)
         auto label = lv_label_create(button);
         lv_obj_align(label, LV_ALIGN_CENTER, 0, 0);
         lv_label_set_text(label, app->getName());
+
+        if (app->getHighlighted())
+        {
+            auto bell = lv_label_create(button);
+            lv_obj_align(bell, LV_ALIGN_RIGHT_MID, 0, 0);
+            lv_label_set_text(bell, LV_SYMBOL_BELL);
+        }
     }
 
     lv_screen_load(this->screen);
@@ -0,0 +1,529 @@
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "esp_log.h"
+
+#include "fri3d_private/binary_manifest_parser.hpp"
+
+namespace Fri3d::Apps::Ota
+{
+
+static const char *TAG = "Fri3d::Apps::Ota::CBinaryManifestParser";
+
+static const char MAGIC[] = {'F', '3', 'D', 'M'};
+static const uint8_t FORMAT_VERSION = 1;
+
+static const uint8_t RECORD_END = 0x00;
+static const uint8_t RECORD_STRING = 0x01;
+static const uint8_t RECORD_FIRMWARE = 0x02;
+
+static const uint8_t FIRMWARE_BETA = 1 << 0;
+static const uint8_t FIRMWARE_ROLLOUT = 1 << 1;
+static const uint8_t FIRMWARE_MIRRORS = 1 << 2;
+
+static const uint8_t VERSION_PARSED = 1 << 0;
+static const uint8_t VERSION_PRERELEASE = 1 << 1;
+static const uint8_t VERSION_METADATA = 1 << 2;
+
+static const uint8_t IMAGE_HASH = 1 << 0;
+static const uint8_t IMAGE_BLOCKS = 1 << 1;
+
+CBinaryManifestParser::CCursor::CCursor(const CBinaryManifestParser &parser, const std::vector<uint8_t> &record)
+    : parser(parser)
+    , data(record.data())
+    , end(record.data() + record.size())
+{
+}
+
+bool CBinaryManifestParser::CCursor::readByte(uint8_t &value)
+{
+    if (this->data == this->end)
+    {
+        return false;
+    }
+
+    value = *this->data++;
+    return true;
+}
+
+bool CBinaryManifestParser::CCursor::readVarint(uint32_t &value)
+{
+    value = 0;
+
+    for (int shift = 0; shift < 32; shift += 7)
+    {
+        uint8_t byte;
+        if (!this->readByte(byte))
+        {
+            return false;
+        }
+
+        value |= static_cast<uint32_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool CBinaryManifestParser::CCursor::readHash(CHash &hash)
+{
+    if (static_cast<size_t>(this->end - this->data) < hash.size())
+    {
+        this->data = this->end;
+        return false;
+    }
+
+    memcpy(hash.data(), this->data, hash.size());
+    this->data += hash.size();
+    return true;
+}
+
+bool CBinaryManifestParser::CCursor::readString(std::string_view &value)
+{
+    uint32_t index;
+    if (!this->readVarint(index) || index >= this->parser.strings.size())
+    {
+        return false;
+    }
+
+    value = this->parser.strings[index];
+    return true;
+}
+
+bool CBinaryManifestParser::CCursor::readVersion(CVersion &version)
+{
+    std::string_view text;
+    uint8_t flags;
+
+    if (!this->readString(text) || !this->readByte(flags))
+    {
+        return false;
+    }
+
+    if ((flags & VERSION_PARSED) == 0)
+    {
+        version = CVersion(text.data());
+        return true;
+    }
+
+    uint32_t major, minor, patch;
+    std::string_view prerelease;
+    std::string_view metadata;
+
+    if (!this->readVarint(major) || !this->readVarint(minor) || !this->readVarint(patch) ||
+        ((flags & VERSION_PRERELEASE) != 0 && !this->readString(prerelease)) ||
+        ((flags & VERSION_METADATA) != 0 && !this->readString(metadata)))
+    {
+        return false;
+    }
+
+    version = CVersion(
+        text.data(),
+        static_cast<int>(major),
+        static_cast<int>(minor),
+        static_cast<int>(patch),
+        (flags & VERSION_PRERELEASE) != 0 ? prerelease.data() : nullptr,
+        (flags & VERSION_METADATA) != 0 ? metadata.data() : nullptr);
+
+    return true;
+}
+
+bool CBinaryManifestParser::CCursor::readUrl(std::string_view &url)
+{
+    std::string_view prefix;
+    std::string_view name;
+
+    if (!this->readString(prefix) || !this->readString(name))
+    {
+        return false;
+    }
+
+    url = this->parser.arena->store(prefix, name);
+
+    return true;
+}
+
+bool CBinaryManifestParser::CCursor::readSize(int &size)
+{
+    uint32_t value;
+    if (!this->readVarint(value))
+    {
+        return false;
+    }
+
+    size = static_cast<int>(value) - 1;
+    return true;
+}
+
+bool CBinaryManifestParser::isBinary(const char *data, size_t length)
+{
+    // A JSON manifest starts with whitespace or [, so the first byte is enough
+    return length > 0 && data[0] == MAGIC[0];
+}
+
+CBinaryManifestParser::CBinaryManifestParser(COnFirmware onFirmware)
+    : onFirmware(std::move(onFirmware))
+    , state(Header)
+    , header()
+    , headerLength(0)
+    , recordType(0)
+    , recordLength(0)
+    , recordLengthShift(0)
+    , record()
+    , arena(std::make_shared<CManifestArena>())
+    , strings()
+    , images()
+    , mirrors()
+    , patches()
+    , firmwareCount(0)
+    , offset(0)
+{
+    esp_log_level_set(TAG, static_cast<esp_log_level_t>(LOG_LOCAL_LEVEL));
+}
+
+bool CBinaryManifestParser::feed(const char *data, size_t length)
+{
+    auto bytes = reinterpret_cast<const uint8_t *>(data);
+
+    while (length > 0 && this->state != Failed)
+    {
+        size_t used = 0;
+        this->step(bytes, length, used);
+
+        bytes += used;
+        length -= used;
+        this->offset += used;
+    }
+
+    return this->state != Failed;
+}
+
+bool CBinaryManifestParser::isDone() const
+{
+    return this->state == Done;
+}
+
+size_t CBinaryManifestParser::getFirmwareCount() const
+{
+    return this->firmwareCount;
+}
+
+bool CBinaryManifestParser::fail(const char *reason)
+{
+    ESP_LOGE(TAG, "Invalid manifest at offset %d: %s", this->offset, reason);
+    this->state = Failed;
+
+    return false;
+}
+
+bool CBinaryManifestParser::step(const uint8_t *data, size_t length, size_t &used)
+{
+    used = 1;
+
+    switch (this->state)
+    {
+    case Header:
+        this->header[this->headerLength++] = *data;
+        if (this->headerLength < this->header.size())
+        {
+            return true;
+        }
+
+        if (memcmp(this->header.data(), MAGIC, sizeof(MAGIC)) != 0)
+        {
+            return this->fail("not a binary manifest");
+        }
+        if (this->header[sizeof(MAGIC)] != FORMAT_VERSION)
+        {
+            return this->fail("unsupported format version");
+        }
+
+        this->state = RecordType;
+        return true;
+
+    case RecordType:
+        this->recordType = *data;
+        this->recordLength = 0;
+        this->recordLengthShift = 0;
+        this->state = RecordLength;
+        return true;
+
+    case RecordLength:
+        if (this->recordLengthShift >= 32)
+        {
+            return this->fail("invalid record length");
+        }
+
+        this->recordLength |= static_cast<uint32_t>(*data & 0x7f) << this->recordLengthShift;
+        this->recordLengthShift += 7;
+
+        if ((*data & 0x80) != 0)
+        {
+            return true;
+        }
+
+        if (this->recordLength > MaxRecordSize)
+        {
+            return this->fail("record too large");
+        }
+
+        this->record.clear();
+        if (this->recordLength == 0)
+        {
+            return this->endRecord();
+        }
+
+        this->record.reserve(this->recordLength);
+        this->state = RecordPayload;
+        return true;
+
+    case RecordPayload:
+        // Take as much of the payload as there is in one go
+        used = std::min(length, this->recordLength - this->record.size());
+        this->record.insert(this->record.end(), data, data + used);
+
+        if (this->record.size() < this->recordLength)
+        {
+            return true;
+        }
+
+        return this->endRecord();
+
+    case Done:
+        return this->fail("data after the end of the manifest");
+
+    case Failed:
+        return false;
+    }
+
+    return false;
+}
+
+bool CBinaryManifestParser::endRecord()
+{
+    this->state = RecordType;
+
+    switch (this->recordType)
+    {
+    case RECORD_END:
+        this->state = Done;
+        return true;
+
+    case RECORD_STRING:
+        this->strings.push_back(
+            this->arena->store(reinterpret_cast<const char *>(this->record.data()), this->record.size()));
+        return true;
+
+    case RECORD_FIRMWARE:
+        return this->parseFirmware();
+
+    default:
+        // Left for newer badges
+        ESP_LOGD(TAG, "Skipping record of type %d", this->recordType);
+        return true;
+    }
+}
+
+bool CBinaryManifestParser::parseFirmware()
+{
+    CCursor cursor(*this, this->record);
+    CFirmware firmware;
+    uint8_t flags;
+    uint32_t imageCount;
+
+    if (!cursor.readByte(flags) || !cursor.readVersion(firmware.version) || !cursor.readVarint(imageCount))
+    {
+        return this->fail("invalid firmware");
+    }
+
+    firmware.arena = this->arena;
+    firmware.beta = (flags & FIRMWARE_BETA) != 0;
+    firmware.rolloutStart = 0;
+    firmware.rolloutWindow = 0;
+
+    this->images.clear();
+
+    for (uint32_t i = 0; i < imageCount; i++)
+    {
+        CImage image;
+        bool known;
+
+        if (!this->parseImage(cursor, image, known))
+        {
+            return this->fail("invalid image");
+        }
+
+        this->images.push_back(nullptr);
+
+        if (known)
+        {
+            // As in JSON, a later image of the same type replaces the earlier one
+            auto &target = firmware.images.set(image);
+            std::replace(this->images.begin(), this->images.end(), &target, static_cast<CImage *>(nullptr));
+            this->images.back() = &target;
+        }
+    }
+
+    // After the images, so older badges simply don't read it
+    if ((flags & FIRMWARE_ROLLOUT) != 0)
+    {
+        uint32_t start, window;
+        if (!cursor.readVarint(start) || !cursor.readVarint(window))
+        {
+            return this->fail("invalid rollout");
+        }
+
+        firmware.rolloutStart = start;
+        firmware.rolloutWindow = window;
+    }
+
+    if ((flags & FIRMWARE_MIRRORS) != 0)
+    {
+        for (auto image : this->images)
+        {
+            uint32_t count;
+            if (!cursor.readVarint(count))
+            {
+                return this->fail("invalid mirrors");
+            }
+
+            this->mirrors.clear();
+            for (uint32_t i = 0; i < count; i++)
+            {
+                std::string_view mirror;
+                if (!cursor.readString(mirror))
+                {
+                    return this->fail("invalid mirrors");
+                }
+
+                this->mirrors.push_back(mirror);
+            }
+
+            if (image != nullptr)
+            {
+                image->mirrors = this->arena->copy(std::span<const std::string_view>(this->mirrors));
+            }
+        }
+    }
+
+    if (!firmware.images.contains(CImage::Main))
+    {
+        ESP_LOGW(TAG, "Firmware %s does not contain at least `main` image", firmware.version.getText());
+        return true;
+    }
+
+    this->firmwareCount++;
+    this->onFirmware(std::move(firmware));
+
+    return true;
+}
+
+bool CBinaryManifestParser::parseImage(CCursor &cursor, CImage &image, bool &known)
+{
+    uint8_t type, encoding, flags;
+    uint32_t blockSize, blockCount, patchCount;
+
+    if (!cursor.readByte(type) || !cursor.readVersion(image.version) || !cursor.readUrl(image.url) ||
+        !cursor.readSize(image.size) || !cursor.readByte(encoding) || !cursor.readByte(flags))
+    {
+        return false;
+    }
+
+    // Types the badge doesn't know yet are read but not used
+    known = type <= CImage::VFS;
+    image.imageType = static_cast<CImage::ImageType>(type);
+    image.encoding = static_cast<CImage::Encoding>(encoding);
+    image.blockSize = 0;
+
+    if ((flags & IMAGE_HASH) != 0)
+    {
+        CHash hash;
+        if (!cursor.readHash(hash))
+        {
+            return false;
+        }
+        image.hash = hash;
+    }
+
+    if ((flags & IMAGE_BLOCKS) != 0)
+    {
+        if (!cursor.readVarint(blockSize) || !cursor.readVarint(blockCount) ||
+            blockCount > MaxRecordSize / sizeof(CHash))
+        {
+            return false;
+        }
+
+        auto blocks = this->arena->allocate<CHash>(blockCount);
+        for (auto &block : blocks)
+        {
+            if (!cursor.readHash(block))
+            {
+                return false;
+            }
+        }
+
+        image.blockSize = static_cast<int>(blockSize);
+        image.blocks = blocks;
+    }
+
+    if (!cursor.readVarint(patchCount))
+    {
+        return false;
+    }
+
+    this->patches.clear();
+    for (uint32_t i = 0; i < patchCount; i++)
+    {
+        CImage::CPatch patch;
+        std::string_view from;
+        uint32_t fromSize;
+        uint8_t patchEncoding;
+
+        if (!cursor.readString(from) || !cursor.readVarint(fromSize) || !cursor.readHash(patch.fromHash) ||
+            !cursor.readUrl(patch.url) || !cursor.readSize(patch.size) || !cursor.readByte(patchEncoding))
+        {
+            return false;
+        }
+
+        if (patchEncoding > CImage::Zlib)
+        {
+            ESP_LOGW(TAG, "Ignoring invalid patch for %s", image.url.data());
+            continue;
+        }
+
+        patch.from = from;
+        patch.fromSize = static_cast<int>(fromSize);
+        patch.encoding = static_cast<CImage::Encoding>(patchEncoding);
+        this->patches.push_back(patch);
+    }
+
+    image.patches = this->patches;
+
+    if (!known)
+    {
+        return true;
+    }
+
+    if (encoding > CImage::Zlib)
+    {
+        ESP_LOGW(TAG, "Skipping %s, unsupported encoding", image.url.data());
+        known = false;
+        return true;
+    }
+
+    if (!image.sanitize())
+    {
+        ESP_LOGW(TAG, "Ignoring invalid block hashes for %s", image.url.data());
+    }
+
+    // Points to the list of the parser until here, sanitize() might have dropped them
+    image.patches = this->arena->copy(image.patches);
+
+    return true;
+}
+
+} // namespace Fri3d::Apps::Ota
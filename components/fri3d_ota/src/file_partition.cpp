@@ -0,0 +1,133 @@
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "esp_log.h"
+
+#include "fri3d_private/file_partition.hpp"
+
+namespace Fri3d::Apps::Ota
+{
+
+static const char *TAG = "Fri3d::Apps::Ota::CFilePartition";
+
+CFilePartition::CFilePartition(std::string path, std::string label, size_t size, size_t eraseSize)
+    : path(std::move(path))
+    , label(std::move(label))
+    , size(size)
+    , eraseSize(eraseSize)
+    , file(nullptr)
+{
+    esp_log_level_set(TAG, static_cast<esp_log_level_t>(LOG_LOCAL_LEVEL));
+}
+
+CFilePartition::~CFilePartition()
+{
+    if (this->file != nullptr)
+    {
+        fclose(this->file);
+    }
+}
+
+const char *CFilePartition::getLabel() const
+{
+    return this->label.c_str();
+}
+
+size_t CFilePartition::getSize() const
+{
+    return this->size;
+}
+
+size_t CFilePartition::getEraseSize() const
+{
+    return this->eraseSize;
+}
+
+bool CFilePartition::begin()
+{
+    if (this->file != nullptr)
+    {
+        return true;
+    }
+
+    this->file = fopen(this->path.c_str(), "r+b");
+    if (this->file == nullptr)
+    {
+        this->file = fopen(this->path.c_str(), "w+b");
+        if (this->file == nullptr)
+        {
+            ESP_LOGE(TAG, "Could not open %s", this->path.c_str());
+            return false;
+        }
+
+        if (!this->erase(0, this->size))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool CFilePartition::read(size_t offset, void *data, size_t length)
+{
+    if (!this->begin() || offset + length > this->size)
+    {
+        return false;
+    }
+
+    return fseek(this->file, static_cast<long>(offset), SEEK_SET) == 0 &&
+           fread(data, 1, length, this->file) == length;
+}
+
+bool CFilePartition::erase(size_t offset, size_t length)
+{
+    if (offset % this->eraseSize != 0 || length % this->eraseSize != 0 || offset + length > this->size)
+    {
+        ESP_LOGE(TAG, "Unaligned erase of `%s` at %d, %d bytes", this->label.c_str(), offset, length);
+        return false;
+    }
+
+    std::vector<uint8_t> erased(this->eraseSize, 0xff);
+
+    if (!this->begin() || fseek(this->file, static_cast<long>(offset), SEEK_SET) != 0)
+    {
+        return false;
+    }
+
+    for (size_t position = 0; position < length; position += erased.size())
+    {
+        if (fwrite(erased.data(), 1, erased.size(), this->file) != erased.size())
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool CFilePartition::write(size_t offset, const void *data, size_t length)
+{
+    std::vector<uint8_t> contents(length);
+    if (!this->read(offset, contents.data(), length))
+    {
+        ESP_LOGE(TAG, "Write beyond the end of `%s` at %d", this->label.c_str(), offset);
+        return false;
+    }
+
+    // Like flash, bits can only be cleared
+    auto bytes = static_cast<const uint8_t *>(data);
+    std::transform(contents.begin(), contents.end(), bytes, contents.begin(), std::bit_and<>());
+
+    return fseek(this->file, static_cast<long>(offset), SEEK_SET) == 0 &&
+           fwrite(contents.data(), 1, length, this->file) == length;
+}
+
+bool CFilePartition::end()
+{
+    return this->file == nullptr || fflush(this->file) == 0;
+}
+
+} // namespace Fri3d::Apps::Ota
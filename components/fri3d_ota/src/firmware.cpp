@@ -1,27 +1,220 @@
 #include <algorithm>
+#include <cstring>
+
+#include "esp_mac.h"
+#include "spi_flash_mmap.h"
 
 #include "fri3d_private/firmware.hpp"
 
 namespace Fri3d::Apps::Ota
 {
 
-CImage::StringToTypeMap CImage::jsonStringToType = {
-    {"main", Main},
-    {"micropython", MicroPython},
-    {"retro-launcher", RetroGoLauncher},
-    {"retro-core", RetroGoCore},
-    {"retro-prboom", RetroGoPRBoom},
-    {"vfs", VFS}};
-
-CImage::TypeToStringMap CImage::typeToUIString = {
-    {Main, "Main firmware"},
-    {MicroPython, "MicroPython"},
-    {RetroGoLauncher, "Retro-Go Launcher"},
-    {RetroGoCore, "Retro-Go Gaming"},
-    {RetroGoPRBoom, "Doom"},
-    {VFS, "User Data (VFS)"},
+const std::array<const char *, CImage::TypeCount> CImage::typeToJsonString = {
+    "main",
+    "micropython",
+    "retro-launcher",
+    "retro-core",
+    "retro-prboom",
+    "vfs",
+};
+
+const std::array<const char *, CImage::TypeCount> CImage::typeToUIString = {
+    "Main firmware",
+    "MicroPython",
+    "Retro-Go Launcher",
+    "Retro-Go Gaming",
+    "Doom",
+    "User Data (VFS)",
+};
+
+const std::array<const char *, CImage::EncodingCount> CImage::encodingToJsonString = {
+    "raw",
+    "zlib",
 };
 
+bool CImage::parseType(const char *text, ImageType &type)
+{
+    for (size_t i = 0; i < CImage::typeToJsonString.size(); i++)
+    {
+        if (strcmp(text, CImage::typeToJsonString[i]) == 0)
+        {
+            type = static_cast<ImageType>(i);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool CImage::parseEncoding(const char *text, Encoding &encoding)
+{
+    for (size_t i = 0; i < CImage::encodingToJsonString.size(); i++)
+    {
+        if (strcmp(text, CImage::encodingToJsonString[i]) == 0)
+        {
+            encoding = static_cast<Encoding>(i);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool CImage::sanitize()
+{
+    bool result = true;
+
+    // Hashes are only usable when we know how much of the partition they cover
+    if (this->size <= 0)
+    {
+        this->hash.reset();
+        this->blocks = {};
+    }
+
+    // Blocks are erased and rewritten separately, so they have to be made of complete sectors
+    if (!this->blocks.empty() &&
+        (this->blockSize <= 0 || this->blockSize % SPI_FLASH_SEC_SIZE != 0 ||
+         this->blocks.size() != static_cast<size_t>((this->size + this->blockSize - 1) / this->blockSize)))
+    {
+        this->blocks = {};
+        result = false;
+    }
+
+    if (this->blocks.empty())
+    {
+        this->blockSize = 0;
+    }
+
+    // Patches can only be verified with the hash of the image
+    if (this->imageType != Main || !this->hash)
+    {
+        this->patches = {};
+    }
+
+    return result;
+}
+
+CImages::CIterator::CIterator(const CImages *images, size_t index)
+    : images(images)
+    , index(index)
+{
+}
+
+const CImage &CImages::CIterator::operator*() const
+{
+    return this->images->images[this->index];
+}
+
+const CImage *CImages::CIterator::operator->() const
+{
+    return &this->images->images[this->index];
+}
+
+CImages::CIterator &CImages::CIterator::operator++()
+{
+    do
+    {
+        this->index++;
+    } while (this->index < CImage::TypeCount && (this->images->present & (1 << this->index)) == 0);
+
+    return *this;
+}
+
+CImages::CIterator CImages::CIterator::operator++(int)
+{
+    auto result = *this;
+    ++*this;
+
+    return result;
+}
+
+bool CImages::CIterator::operator==(const CIterator &other) const
+{
+    return this->index == other.index;
+}
+
+CImages::CImages()
+    : images()
+    , present(0)
+{
+}
+
+bool CImages::contains(CImage::ImageType type) const
+{
+    return (this->present & (1 << type)) != 0;
+}
+
+const CImage &CImages::at(CImage::ImageType type) const
+{
+    return this->images[type];
+}
+
+CImage &CImages::at(CImage::ImageType type)
+{
+    return this->images[type];
+}
+
+CImage &CImages::set(const CImage &image)
+{
+    this->present |= 1 << image.imageType;
+    this->images[image.imageType] = image;
+
+    return this->images[image.imageType];
+}
+
+size_t CImages::size() const
+{
+    return __builtin_popcount(this->present);
+}
+
+bool CImages::empty() const
+{
+    return this->present == 0;
+}
+
+CImages::CIterator CImages::begin() const
+{
+    // The first present image, or the end
+    CIterator result(this, 0);
+    if (!this->contains(CImage::Main))
+    {
+        ++result;
+    }
+
+    return result;
+}
+
+CImages::CIterator CImages::end() const
+{
+    return {this, CImage::TypeCount};
+}
+
+int64_t CFirmware::getSlot() const
+{
+    if (this->rolloutWindow == 0)
+    {
+        return this->rolloutStart;
+    }
+
+    // FNV-1a of the MAC address and the version, so the same badges aren't last for every release
+    uint8_t mac[6] = {};
+    esp_read_mac(mac, ESP_MAC_WIFI_STA);
+
+    uint32_t hash = 2166136261u;
+    auto add = [&hash](uint8_t byte) { hash = (hash ^ byte) * 16777619u; };
+
+    for (auto byte : mac)
+    {
+        add(byte);
+    }
+    for (auto character = this->version.getText(); *character != '\0'; character++)
+    {
+        add(static_cast<uint8_t>(*character));
+    }
+
+    return this->rolloutStart + hash % this->rolloutWindow;
+}
+
 bool operator<(const CImage &l, const CImage &r)
 {
     return l.version < r.version;
@@ -32,4 +225,87 @@ bool operator<(const CFirmware &l, const CFirmware &r)
     return l.version < r.version;
 }
 
+CFirmwareList::CIterator::CIterator(std::vector<const CFirmware *>::const_iterator item)
+    : item(item)
+{
+}
+
+const CFirmware &CFirmwareList::CIterator::operator*() const
+{
+    return **this->item;
+}
+
+const CFirmware *CFirmwareList::CIterator::operator->() const
+{
+    return *this->item;
+}
+
+CFirmwareList::CIterator &CFirmwareList::CIterator::operator++()
+{
+    ++this->item;
+
+    return *this;
+}
+
+CFirmwareList::CIterator CFirmwareList::CIterator::operator++(int)
+{
+    auto result = *this;
+    ++this->item;
+
+    return result;
+}
+
+bool CFirmwareList::CIterator::operator==(const CIterator &other) const
+{
+    return this->item == other.item;
+}
+
+void CFirmwareList::clear()
+{
+    this->items = std::vector<const CFirmware *>();
+}
+
+void CFirmwareList::add(const CFirmware &firmware)
+{
+    this->items.push_back(&firmware);
+}
+
+void CFirmwareList::sort()
+{
+    // Only the pointers move
+    std::sort(this->items.begin(), this->items.end(), [](const CFirmware *l, const CFirmware *r) {
+        return CVersion::compare(l->version, r->version) > 0;
+    });
+}
+
+size_t CFirmwareList::size() const
+{
+    return this->items.size();
+}
+
+bool CFirmwareList::empty() const
+{
+    return this->items.empty();
+}
+
+const CFirmware &CFirmwareList::front() const
+{
+    return *this->items.front();
+}
+
+const CFirmware &CFirmwareList::operator[](size_t index) const
+{
+    return *this->items[index];
+}
+
+CFirmwareList::CIterator CFirmwareList::begin() const
+{
+    return CIterator(this->items.begin());
+}
+
+CFirmwareList::CIterator CFirmwareList::end() const
+{
+    return CIterator(this->items.end());
+}
+
 } // namespace Fri3d::Apps::Ota
@@ -1,189 +1,385 @@
-#include <algorithm>
+#include <memory>
+#include <utility>
 
-#include "cJSON.h"
-#include "esp_crt_bundle.h"
 #include "esp_http_client.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 
 #include "fri3d_application/lvgl/wait_dialog.hpp"
+#include "fri3d_private/binary_manifest_parser.hpp"
 #include "fri3d_private/firmware_fetcher.hpp"
+#include "fri3d_private/manifest_parser.hpp"
+#include "fri3d_private/retry_policy.hpp"
+#include "fri3d_private/settings.hpp"
 
 namespace Fri3d::Apps::Ota
 {
 
 static const char *TAG = "Fri3d::Apps::Ota::CVersionFetcher";
 
+// The manifest is parsed in parts of this size while it is downloaded
+static const size_t FETCH_BUFFER_SIZE = 512;
+
+std::mutex CFirmwareFetcher::refreshMutex;
+
 CFirmwareFetcher::CFirmwareFetcher()
+    : fresh(false)
+    , cached(false)
 {
     esp_log_level_set(TAG, static_cast<esp_log_level_t>(LOG_LOCAL_LEVEL));
 }
 
-bool CFirmwareFetcher::refresh()
+bool CFirmwareFetcher::load(Application::INvsManager &nvs, bool fresh)
+{
+    this->clear();
+
+    auto start = esp_timer_get_time();
+
+    if (!this->parseCache(nvs))
+    {
+        this->clear();
+        return false;
+    }
+
+    ESP_LOGI(
+        TAG,
+        "Loaded %d cached firmwares in %lu ms",
+        this->firmwares.size(),
+        static_cast<uint32_t>((esp_timer_get_time() - start) / 1000));
+
+    this->sort();
+    this->fresh = fresh;
+
+    return !this->firmwares.empty();
+}
+
+bool CFirmwareFetcher::refresh(Application::Hardware::IHttp &http, Application::INvsManager &nvs, bool showDialog)
 {
     Application::LVGL::CWaitDialog dialog("Fetching versions");
-    dialog.show();
+    if (showDialog)
+    {
+        dialog.show();
+    }
 
-    this->firmwares = CFirmwares();
-    this->official = CFirmwares();
+    std::lock_guard lock(CFirmwareFetcher::refreshMutex);
+
+    this->clear();
+
+    auto start = esp_timer_get_time();
 
-    auto buffer = CFirmwareFetcher::fetch();
+    std::unique_ptr<IManifestParser> parser;
+    CCacheEntry cache;
+    CTiming timing = {};
+    auto size = this->fetch(http, parser, cache, timing);
 
-    if (buffer.empty())
+    if (size == 0 && !this->parseCache(nvs))
     {
-        return false;
+        // Without the validators the server has to send the complete manifest
+        ESP_LOGW(TAG, "Cached versions are not usable, downloading them again");
+        Settings::manifestETag.set("");
+        Settings::manifestModified.set("");
+
+        this->clear();
+        size = this->fetch(http, parser, cache, timing);
     }
 
-    dialog.setStatus("Parsing version info");
+    if (size < 0 || (size == 0 && this->firmwares.empty()))
+    {
+        this->clear();
+        return false;
+    }
 
-    if (this->parse(buffer.c_str()))
+    if (parser)
     {
-        for (const auto &i : this->firmwares)
-        {
-            if (!i.beta)
-            {
-                this->official.emplace_back(i);
-            }
-        }
+        ESP_LOGI(
+            TAG,
+            "Parsed %d firmwares from %d bytes in %lu ms (connecting %lu ms, waiting for the response %lu ms, "
+            "receiving %lu ms, parsing %lu ms, pausing before retries %lu ms)",
+            parser->getFirmwareCount(),
+            size,
+            static_cast<uint32_t>((esp_timer_get_time() - start) / 1000),
+            static_cast<uint32_t>(timing.download.connect / 1000),
+            static_cast<uint32_t>(timing.download.response / 1000),
+            static_cast<uint32_t>(timing.download.receive / 1000),
+            static_cast<uint32_t>(timing.parse / 1000),
+            static_cast<uint32_t>(timing.download.backoff / 1000));
+
+        this->cached = CFirmwareFetcher::store(nvs, cache);
     }
     else
     {
-        this->firmwares = CFirmwares();
+        ESP_LOGI(
+            TAG,
+            "Versions not modified, loaded %d cached firmwares in %lu ms (connecting %lu ms, waiting for the response "
+            "%lu ms)",
+            this->firmwares.size(),
+            static_cast<uint32_t>((esp_timer_get_time() - start) / 1000),
+            static_cast<uint32_t>(timing.download.connect / 1000),
+            static_cast<uint32_t>(timing.download.response / 1000));
+
+        this->cached = true;
     }
 
+    this->sort();
+    this->fresh = true;
+
     return !this->firmwares.empty();
 }
 
-std::string CFirmwareFetcher::fetch()
+void CFirmwareFetcher::clear()
 {
-    std::string buffer;
+    this->firmwares = CFirmwares();
+    this->all.clear();
+    this->official.clear();
+    this->fresh = false;
+    this->cached = false;
+}
 
-    esp_http_client_config_t config({});
+void CFirmwareFetcher::sort()
+{
+    // The firmwares stay where they are, only the pointers to them are sorted
+    for (const auto &firmware : this->firmwares)
+    {
+        this->all.add(firmware);
+    }
 
-    config.url = CONFIG_FRI3D_VERSIONS_URL;
-    config.timeout_ms = 5000;
-    config.user_data = &buffer;
-    config.crt_bundle_attach = esp_crt_bundle_attach;
-    config.event_handler = [](esp_http_client_event_t *event) -> esp_err_t {
-        std::string &buffer = *static_cast<std::string *>(event->user_data);
+    this->all.sort();
 
-        switch (event->event_id)
+    for (const auto &firmware : this->all)
+    {
+        if (!firmware.beta)
         {
-        case HTTP_EVENT_ERROR:
-            ESP_LOGW(TAG, "HTTP_EVENT_ERROR");
-            return ESP_FAIL;
-            break;
-        case HTTP_EVENT_ON_DATA:
-            ESP_LOGV(TAG, "Received %d bytes", event->data_len);
-            buffer.append(static_cast<const char *>(event->data), event->data_len);
-            break;
-        default:
-            break;
+            this->official.add(firmware);
         }
-        return ESP_OK;
-    };
-
-    esp_http_client_handle_t client = esp_http_client_init(&config);
+    }
+}
 
-    if (ESP_OK != esp_http_client_set_header(client, "Accept", "application/json"))
+std::unique_ptr<IManifestParser> CFirmwareFetcher::createParser(
+    const char *data,
+    size_t length,
+    const IManifestParser::COnFirmware &onFirmware)
+{
+    if (CBinaryManifestParser::isBinary(data, length))
     {
-        ESP_LOGE(TAG, "Could not set headers");
+        ESP_LOGD(TAG, "Parsing binary manifest");
+        return std::make_unique<CBinaryManifestParser>(onFirmware);
     }
-    else
+
+    ESP_LOGD(TAG, "Parsing JSON manifest");
+    return std::make_unique<CManifestParser>(onFirmware);
+}
+
+bool CFirmwareFetcher::parse(const std::string &manifest)
+{
+    auto parser = CFirmwareFetcher::createParser(manifest.data(), manifest.size(), [this](CFirmware &&firmware) {
+        this->firmwares.emplace_back(std::move(firmware));
+    });
+
+    return parser->feed(manifest.data(), manifest.size()) && parser->isDone();
+}
+
+bool CFirmwareFetcher::parseCache(Application::INvsManager &nvs)
+{
+    std::string manifest;
+    if (!nvs.open(Settings::OTA_NAMESPACE).getBlob(Settings::MANIFEST_KEY, manifest))
     {
-        ESP_LOGD(TAG, "Downloading from %s", config.url);
-        if (ESP_OK != esp_http_client_perform(client) || 200 != esp_http_client_get_status_code(client))
-        {
-            ESP_LOGE(TAG, "Could not download from %s", config.url);
-            buffer = std::string();
-        }
+        ESP_LOGD(TAG, "No cached versions");
+        return false;
     }
 
-    esp_http_client_cleanup(client);
-
-    return buffer;
+    return this->parse(manifest);
 }
 
-const CFirmwares &CFirmwareFetcher::getFirmwares(bool beta) const
+bool CFirmwareFetcher::store(Application::INvsManager &nvs, const CCacheEntry &cache)
 {
-    if (beta)
+    auto handle = nvs.open(Settings::OTA_NAMESPACE);
+
+    // NVS skips the write when the blob didn't change. The validators are only stored along with the manifest they
+    // belong to.
+    if (!cache.manifest.empty() && handle.setBlob(Settings::MANIFEST_KEY, cache.manifest))
     {
-        return this->firmwares;
+        Settings::manifestETag.set(cache.eTag);
+        Settings::manifestModified.set(cache.modified);
+
+        return true;
     }
-    else
+
+    // The old manifest doesn't match the server anymore, it is not shown again and not asked for as not modified
+    if (cache.manifest.empty())
     {
-        return this->official;
+        ESP_LOGD(TAG, "Versions are too large to cache");
     }
+
+    handle.eraseBlob(Settings::MANIFEST_KEY);
+    Settings::manifestETag.set("");
+    Settings::manifestModified.set("");
+
+    return false;
 }
 
-bool CFirmwareFetcher::parse(const char *json)
+int CFirmwareFetcher::fetch(
+    Application::Hardware::IHttp &http,
+    std::unique_ptr<IManifestParser> &parser,
+    CCacheEntry &cache,
+    CTiming &timing)
 {
-    cJSON *root = cJSON_Parse(json);
+    // The connection stays open afterwards, so flashing the images doesn't need a new TLS handshake
+    auto client = http.acquire(CONFIG_FRI3D_VERSIONS_URL);
+    if (!client)
+    {
+        return -1;
+    }
+
+    auto eTag = Settings::manifestETag.get();
+    auto modified = Settings::manifestModified.get();
 
-    if (root == nullptr)
+    // Servers that don't have the binary manifest send the JSON one
+    bool result = client.setHeader("Accept", "application/vnd.fri3d.manifest, application/json;q=0.5") &&
+                  (eTag.empty() || client.setHeader("If-None-Match", eTag.c_str())) &&
+                  (modified.empty() || client.setHeader("If-Modified-Since", modified.c_str()));
+
+    if (!result)
     {
-        ESP_LOGE(TAG, "Could not parse JSON");
-        return false;
+        ESP_LOGE(TAG, "Could not set headers");
+        return -1;
     }
 
-    const cJSON *firmwareNode;
-    cJSON_ArrayForEach(firmwareNode, root)
+    client.watchHeader("ETag");
+    client.watchHeader("Last-Modified");
+    CRetryPolicy::watch(client);
+
+    ESP_LOGD(TAG, "Downloading from %s", CONFIG_FRI3D_VERSIONS_URL);
+
+    // Connection errors and a busy server are retried, the body is parsed as it arrives so it can't be
+    CRetryPolicy policy;
+    int status = 0;
+
+    while (true)
     {
-        cJSON *firmwareVersion = cJSON_GetObjectItemCaseSensitive(firmwareNode, "version");
-        cJSON *images = cJSON_GetObjectItemCaseSensitive(firmwareNode, "images");
-        cJSON *beta = cJSON_GetObjectItemCaseSensitive(firmwareNode, "beta");
+        timing.download.requests++;
 
-        if (firmwareVersion == nullptr || images == nullptr || !cJSON_IsArray(images))
-        {
-            continue;
-        }
+        auto now = esp_timer_get_time();
+        result = ESP_OK == esp_http_client_open(client.get(), 0);
+        timing.download.connect += esp_timer_get_time() - now;
 
-        CFirmware firmware;
-        firmware.version = CVersion(firmwareVersion->valuestring);
-        firmware.beta = cJSON_IsTrue(beta);
+        now = esp_timer_get_time();
+        result = result && esp_http_client_fetch_headers(client.get()) >= 0;
+        timing.download.response += esp_timer_get_time() - now;
 
-        const cJSON *imageNode;
-        cJSON_ArrayForEach(imageNode, images)
+        if (result)
         {
-            cJSON *imageType = cJSON_GetObjectItemCaseSensitive(imageNode, "type");
-            cJSON *imageVersion = cJSON_GetObjectItemCaseSensitive(imageNode, "version");
-            cJSON *url = cJSON_GetObjectItemCaseSensitive(imageNode, "url");
-            cJSON *size = cJSON_GetObjectItemCaseSensitive(imageNode, "size");
+            policy.update(client);
+            status = esp_http_client_get_status_code(client.get());
 
-            if (imageType == nullptr || !CImage::jsonStringToType.contains(imageType->valuestring) ||
-                imageVersion == nullptr || url == nullptr)
+            if (!CRetryPolicy::isBusy(status) && status < 500)
             {
-                continue;
+                break;
             }
 
-            CImage image;
-            image.imageType = CImage::jsonStringToType.at(imageType->valuestring);
-            image.version = CVersion(imageVersion->valuestring);
-            image.url = url->valuestring;
-            image.size = -1;
+            ESP_LOGW(TAG, "Server error %d for %s", status, CONFIG_FRI3D_VERSIONS_URL);
+        }
 
-            if (cJSON_IsNumber(size))
-            {
-                image.size = size->valueint;
-            }
+        esp_http_client_close(client.get());
 
-            firmware.images[image.imageType] = image;
+        now = esp_timer_get_time();
+        result = policy.wait(CONFIG_FRI3D_VERSIONS_URL);
+        timing.download.backoff += esp_timer_get_time() - now;
+
+        if (!result)
+        {
+            return -1;
         }
+    }
+
+    if (status == 304)
+    {
+        ESP_LOGD(TAG, "Not modified since the versions were cached");
+        return 0;
+    }
+
+    result = status == 200;
+
+    cache.eTag = client.getHeader("ETag");
+    cache.modified = client.getHeader("Last-Modified");
+
+    // Nothing of the manifest is kept, it is parsed while it comes in
+    char data[FETCH_BUFFER_SIZE];
+    int size = 0;
+
+    while (result && !esp_http_client_is_complete_data_received(client.get()))
+    {
+        auto now = esp_timer_get_time();
+        auto read = esp_http_client_read(client.get(), data, sizeof(data));
+        timing.download.receive += esp_timer_get_time() - now;
 
-        if (firmware.images.contains(CImage::Main))
+        if (read <= 0)
         {
-            this->firmwares.emplace_back(firmware);
+            result = read == 0 && esp_http_client_is_complete_data_received(client.get());
+            break;
+        }
+
+        ESP_LOGV(TAG, "Received %d bytes", read);
+        size += read;
+        timing.download.received += read;
+
+        if (!parser)
+        {
+            parser = CFirmwareFetcher::createParser(data, read, [this](CFirmware &&firmware) {
+                this->firmwares.emplace_back(std::move(firmware));
+            });
+        }
+
+        // Except for a copy for the cache, as long as it fits
+        if (size <= CONFIG_FRI3D_OTA_MANIFEST_CACHE_SIZE)
+        {
+            cache.manifest.append(data, read);
         }
-        else
+        else if (!cache.manifest.empty())
         {
-            ESP_LOGW(TAG, "Firmware %s does not contain at least `main` image", firmware.version.text.c_str());
+            cache.manifest = std::string();
         }
+
+        now = esp_timer_get_time();
+        result = parser->feed(data, read);
+        timing.parse += esp_timer_get_time() - now;
     }
 
-    cJSON_Delete(root);
+    if (!result)
+    {
+        ESP_LOGE(TAG, "Could not download from %s", CONFIG_FRI3D_VERSIONS_URL);
+        esp_http_client_close(client.get());
+        return -1;
+    }
 
-    std::sort(this->firmwares.rbegin(), this->firmwares.rend());
+    if (!parser || !parser->isDone())
+    {
+        ESP_LOGE(TAG, "Incomplete versions from %s", CONFIG_FRI3D_VERSIONS_URL);
+        return -1;
+    }
+
+    return size;
+}
 
-    return true;
+const CFirmwareList &CFirmwareFetcher::getFirmwares(bool beta) const
+{
+    if (beta)
+    {
+        return this->all;
+    }
+    else
+    {
+        return this->official;
+    }
+}
+
+bool CFirmwareFetcher::isFresh() const
+{
+    return this->fresh;
+}
+
+bool CFirmwareFetcher::isCached() const
+{
+    return this->cached;
 }
 
 } // namespace Fri3d::Apps::Ota
@@ -0,0 +1,205 @@
+#include <functional>
+#include <vector>
+
+#include "esp_log.h"
+#include "spi_flash_mmap.h"
+
+#include "fri3d_private/flash_engine.hpp"
+
+namespace Fri3d::Apps::Ota
+{
+
+static const char *TAG = "Fri3d::Apps::Ota::CFlashEngine";
+
+static const CPartitionWriter::CStatistics NO_STATISTICS = {};
+
+CFlashEngine::CFlashEngine(
+    IPartition &partition,
+    IVerifier *verifier,
+    CPartitionWriter::COnWritten onWritten,
+    COnProgress onProgress)
+    : partition(partition)
+    , verifier(verifier)
+    , onWritten(std::move(onWritten))
+    , onProgress(std::move(onProgress))
+    , throttle()
+{
+    esp_log_level_set(TAG, static_cast<esp_log_level_t>(LOG_LOCAL_LEVEL));
+}
+
+CFlashEngine::~CFlashEngine()
+{
+    this->finish();
+}
+
+void CFlashEngine::setThrottle(const CFlashThrottle &value)
+{
+    this->throttle = value;
+}
+
+bool CFlashEngine::begin()
+{
+    if (!this->partition.begin())
+    {
+        ESP_LOGE(TAG, "Could not prepare `%s` for writing", this->partition.getLabel());
+        return false;
+    }
+
+    this->writer.emplace(this->partition, this->onWritten, this->verifier, this->throttle);
+
+    return true;
+}
+
+bool CFlashEngine::writeRaw(ISource &source)
+{
+    while (true)
+    {
+        // Raw data is read straight into the buffers of the writer
+        auto buffer = this->writer->acquire();
+        if (buffer == nullptr)
+        {
+            return false;
+        }
+
+        bool end = false;
+
+        // Fill the whole buffer, so flash is written in large chunks
+        while (buffer->length < buffer->data.size())
+        {
+            auto read = source.read(buffer->data.data() + buffer->length, buffer->data.size() - buffer->length);
+
+            if (read < 0)
+            {
+                this->writer->submit(buffer);
+                return false;
+            }
+
+            if (read == 0)
+            {
+                end = true;
+                break;
+            }
+
+            buffer->length += read;
+        }
+
+        auto length = buffer->length;
+        this->writer->submit(buffer);
+
+        if (length > 0 && this->onProgress)
+        {
+            this->onProgress(length);
+        }
+
+        if (end)
+        {
+            return true;
+        }
+    }
+}
+
+bool CFlashEngine::writeDecoded(ISource &source, const std::vector<IDecoder *> &decoders)
+{
+    // The output of every decoder is the input of the next, the last one writes
+    std::function<bool(size_t index, const uint8_t *data, size_t length)> feed;
+    feed = [this, &decoders, &feed](size_t index, const uint8_t *data, size_t length) {
+        if (index == decoders.size())
+        {
+            if (!this->writer->write(data, length))
+            {
+                return false;
+            }
+
+            if (this->onProgress)
+            {
+                this->onProgress(length);
+            }
+
+            return true;
+        }
+
+        return decoders[index]->feed(data, length, [index, &feed](const uint8_t *output, size_t outputLength) {
+            return feed(index + 1, output, outputLength);
+        });
+    };
+
+    std::vector<uint8_t> buffer(SPI_FLASH_SEC_SIZE);
+
+    while (true)
+    {
+        auto read = source.read(buffer.data(), buffer.size());
+
+        if (read < 0)
+        {
+            return false;
+        }
+
+        if (read == 0)
+        {
+            break;
+        }
+
+        if (!feed(0, buffer.data(), read))
+        {
+            return false;
+        }
+    }
+
+    for (auto decoder : decoders)
+    {
+        if (!decoder->isDone())
+        {
+            ESP_LOGE(TAG, "Decoded data of %s is incomplete", source.getName());
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool CFlashEngine::write(ISource &source, const CRegion &region, const std::vector<IDecoder *> &decoders)
+{
+    if (!this->writer || !this->writer->beginRegion(region.first, region.second))
+    {
+        return false;
+    }
+
+    // Decoded data has no relation to the offsets in the source
+    bool result = decoders.empty() ? source.open(region.first, region.second) : source.open(0, -1);
+
+    if (result)
+    {
+        result = decoders.empty() ? this->writeRaw(source) : this->writeDecoded(source, decoders);
+    }
+
+    source.close();
+
+    if (!result)
+    {
+        ESP_LOGE(TAG, "Could not write %s to `%s`", source.getName(), this->partition.getLabel());
+    }
+
+    return result;
+}
+
+bool CFlashEngine::finish()
+{
+    return !this->writer || this->writer->finish();
+}
+
+bool CFlashEngine::verify()
+{
+    if (this->verifier != nullptr && !this->verifier->verify())
+    {
+        return false;
+    }
+
+    return this->partition.end();
+}
+
+const CPartitionWriter::CStatistics &CFlashEngine::getStatistics() const
+{
+    return this->writer ? this->writer->getStatistics() : NO_STATISTICS;
+}
+
+} // namespace Fri3d::Apps::Ota
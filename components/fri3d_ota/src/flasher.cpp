@@ -1,17 +1,34 @@
-#include "esp_crt_bundle.h"
-#include "esp_https_ota.h"
-#include "esp_log.h"
+#include <algorithm>
+#include <optional>
+#include <string>
+#include <vector>
 
-// Declare ESP-IDF internal structs
-#include "esp_https_ota_handle.h"
+#include "esp_app_desc.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "mbedtls/sha256.h"
+#include "spi_flash_mmap.h"
 
+#include "fri3d_private/flash_engine.hpp"
 #include "fri3d_private/flasher.hpp"
+#include "fri3d_private/http_source.hpp"
+#include "fri3d_private/image_verifier.hpp"
+#include "fri3d_private/inflater.hpp"
+#include "fri3d_private/mirrors.hpp"
+#include "fri3d_private/patcher.hpp"
+#include "fri3d_private/settings.hpp"
 
 namespace Fri3d::Apps::Ota
 {
 
 static const char *TAG = "Fri3d::Apps::Ota::CFlasher";
 
+// How often the progress of a download is persisted, so it can be resumed after a reboot
+static const size_t RESUME_CHECKPOINT_SIZE = 256 * 1024;
+
+std::mutex CFlasher::totalsMutex;
+CUpdateStatistics CFlasher::totals = {};
+
 CFlasher::CFlasher()
 {
     esp_log_level_set(TAG, static_cast<esp_log_level_t>(LOG_LOCAL_LEVEL));
@@ -19,17 +36,78 @@ CFlasher::CFlasher()
 
 std::string CFlasher::persist()
 {
-    ESP_ERROR_CHECK(esp_ota_mark_app_valid_cancel_rollback());
+    auto running = esp_ota_get_running_partition();
+
+    // Only a freshly flashed image needs to be marked valid, which saves a flash write on every other boot
+    esp_ota_img_states_t state;
+    if (esp_ota_get_state_partition(running, &state) == ESP_OK && state == ESP_OTA_IMG_PENDING_VERIFY)
+    {
+        ESP_LOGI(TAG, "Marking %s as valid", running->label);
+        ESP_ERROR_CHECK(esp_ota_mark_app_valid_cancel_rollback());
+    }
+
+    return running->label;
+}
+
+const esp_partition_t *CFlasher::getUpdatePartition()
+{
+    auto partition = esp_ota_get_next_update_partition(nullptr);
+
+    // By default, IDF will switch to ota_2 after ota_1, which we don't want, so we reset it here
+    if (partition->subtype > ESP_PARTITION_SUBTYPE_APP_OTA_1)
+    {
+        partition = esp_partition_find_first(ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_APP_OTA_0, nullptr);
+    }
+
+    return partition;
+}
+
+void CFlasher::resetStatistics()
+{
+    std::lock_guard lock(CFlasher::totalsMutex);
+    CFlasher::totals = {};
+}
+
+CUpdateStatistics CFlasher::getStatistics()
+{
+    std::lock_guard lock(CFlasher::totalsMutex);
+    return CFlasher::totals;
+}
+
+void CFlasher::record(const CUpdateStatistics &image, const char *label)
+{
+    image.print(label);
+
+    std::lock_guard lock(CFlasher::totalsMutex);
+    CFlasher::totals += image;
+}
+
+bool CFlasher::activate(const esp_partition_t &partition)
+{
+    if (ESP_OK != esp_ota_set_boot_partition(&partition))
+    {
+        ESP_LOGE(TAG, "Could not activate `%s`", partition.label);
+        return false;
+    }
 
-    return esp_ota_get_running_partition()->label;
+    return true;
 }
 
-bool CFlasher::flash(const CImage &image)
+bool CFlasher::flash(
+    Application::Hardware::IHttp &http,
+    const CImage &image,
+    IFlashStatus &status,
+    const CFlashThrottle &throttle)
 {
-    return CFlasher::flash(image, nullptr);
+    return CFlasher::flash(http, image, nullptr, status, throttle);
 }
 
-bool CFlasher::flash(const CImage &image, const char *partitionName)
+bool CFlasher::flash(
+    Application::Hardware::IHttp &http,
+    const CImage &image,
+    const char *partitionName,
+    IFlashStatus &status,
+    const CFlashThrottle &throttle)
 {
     const esp_partition_t *partition = nullptr;
 
@@ -44,212 +122,439 @@ bool CFlasher::flash(const CImage &image, const char *partitionName)
         }
     }
 
-    // Configure the HTTP client
-    esp_http_client_config_t httpConfig({});
+    bool result = false;
 
-    httpConfig.url = image.url.c_str();
-    httpConfig.timeout_ms = 5000;
-    httpConfig.crt_bundle_attach = esp_crt_bundle_attach;
-    httpConfig.keep_alive_enable = true;
-    httpConfig.buffer_size_tx = 4096;
-    httpConfig.buffer_size = 4096;
+    if (partition == nullptr)
+    {
+        // The main firmware is written to the next OTA partition and activated afterwards, which verifies the image
+        auto target = CFlasher::getUpdatePartition();
+        CAppPartition backend(*target, false);
 
-    // Show a dialog
-    Application::LVGL::CWaitDialog dialog("");
-    dialog.show();
+        if (!image.patches.empty())
+        {
+            result = CFlasher::flashPatch(http, image, backend, status, throttle) && CFlasher::activate(*target);
 
-    bool result = false;
+            if (!result)
+            {
+                ESP_LOGW(TAG, "Delta update not possible, flashing the complete image");
+            }
+        }
 
-    if (partition == nullptr || partition->type == ESP_PARTITION_TYPE_APP)
+        if (!result)
+        {
+            result = CFlasher::flashImage(http, image, backend, status, throttle) && CFlasher::activate(*target);
+        }
+    }
+    else if (partition->type == ESP_PARTITION_TYPE_APP)
     {
-        result = CFlasher::flashOta(image, partition, httpConfig, dialog);
+        // Other app partitions are not activated here, so without an image hash the app image itself is checked
+        CAppPartition backend(*partition, !image.hash);
+        result = CFlasher::flashImage(http, image, backend, status, throttle);
     }
     else
     {
-        result = CFlasher::flashRaw(image, *partition, httpConfig, dialog);
+        CFlashPartition backend(*partition);
+        result = CFlasher::flashImage(http, image, backend, status, throttle);
     }
 
-    dialog.setProgress(100.0f);
+    status.setProgress(100.0f);
 
     return result;
 }
 
-bool CFlasher::flashOta(
-    const CImage &image,
-    const esp_partition_t *partition,
-    esp_http_client_config_t &httpConfig,
-    Application::LVGL::CWaitDialog &dialog)
+bool CFlasher::hashPartition(IPartition &partition, size_t length, CHash &hash)
 {
-    esp_https_ota_config_t otaConfig({});
-    otaConfig.http_config = &httpConfig;
+    std::vector<uint8_t> buffer(SPI_FLASH_SEC_SIZE);
 
-    esp_https_ota_handle_t otaHandle = nullptr;
-    if (ESP_OK != esp_https_ota_begin(&otaConfig, &otaHandle))
+    mbedtls_sha256_context context;
+    mbedtls_sha256_init(&context);
+    mbedtls_sha256_starts(&context, 0);
+
+    bool result = true;
+    for (size_t offset = 0; offset < length && result; offset += buffer.size())
     {
-        ESP_LOGE(TAG, "Could not initialize OTA");
-        return false;
+        auto size = std::min(buffer.size(), length - offset);
+        result = partition.read(offset, buffer.data(), size);
+        mbedtls_sha256_update(&context, buffer.data(), size);
     }
 
-    // If you get a compile error here, it's probably because you updated IDF and didn't check and update
-    // ./include/esp_https_ota_handle.h yet
-    auto ota = static_cast<esp_https_ota_handle *>(otaHandle);
+    mbedtls_sha256_finish(&context, hash.data());
+    mbedtls_sha256_free(&context);
 
-    if (partition != nullptr)
-    {
-        ota->update_partition = partition;
-    }
-    else
+    return result;
+}
+
+bool CFlasher::findChangedBlocks(
+    const CImage &image,
+    IPartition &partition,
+    IFlashStatus &status,
+    CRegions &regions)
+{
+    std::vector<uint8_t> buffer(SPI_FLASH_SEC_SIZE);
+
+    // The image and all of its blocks are hashed in a single pass over the flash
+    mbedtls_sha256_context imageContext;
+    mbedtls_sha256_init(&imageContext);
+    mbedtls_sha256_starts(&imageContext, 0);
+
+    bool result = true;
+    auto size = static_cast<size_t>(image.size);
+    auto blockSize = static_cast<size_t>(image.blockSize);
+
+    for (size_t block = 0; block < image.blocks.size() && result; block++)
     {
-        // By default, IDF will switch to ota_2 after ota_1, which we don't want, so we reset it here
-        if (ota->update_partition->subtype > ESP_PARTITION_SUBTYPE_APP_OTA_1)
+        auto blockStart = block * blockSize;
+        auto blockEnd = std::min(blockStart + blockSize, size);
+
+        mbedtls_sha256_context blockContext;
+        mbedtls_sha256_init(&blockContext);
+        mbedtls_sha256_starts(&blockContext, 0);
+
+        for (size_t offset = blockStart; offset < blockEnd && result; offset += buffer.size())
+        {
+            auto length = std::min(buffer.size(), blockEnd - offset);
+            result = partition.read(offset, buffer.data(), length);
+            mbedtls_sha256_update(&blockContext, buffer.data(), length);
+            mbedtls_sha256_update(&imageContext, buffer.data(), length);
+        }
+
+        CHash hash;
+        mbedtls_sha256_finish(&blockContext, hash.data());
+        mbedtls_sha256_free(&blockContext);
+
+        if (hash != image.blocks[block])
         {
-            ota->update_partition =
-                esp_partition_find_first(ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_APP_OTA_0, nullptr);
+            // Consecutive blocks are downloaded with a single request
+            if (!regions.empty() && regions.back().first + regions.back().second == blockStart)
+            {
+                regions.back().second += static_cast<int>(blockEnd - blockStart);
+            }
+            else
+            {
+                regions.emplace_back(blockStart, static_cast<int>(blockEnd - blockStart));
+            }
         }
+
+        status.setProgress(static_cast<float>(blockEnd) / static_cast<float>(size) * 100.0f);
     }
 
-    setStatusFlashing(image, dialog);
+    CHash hash;
+    mbedtls_sha256_finish(&imageContext, hash.data());
+    mbedtls_sha256_free(&imageContext);
 
-    ESP_LOGI(TAG, "Starting OTA update on partition `%s`", ota->update_partition->label);
+    if (result && image.hash && hash == *image.hash)
+    {
+        regions.clear();
+    }
 
-    auto total = esp_https_ota_get_image_size(otaHandle);
-    if (total != image.size)
+    return result;
+}
+
+void CFlasher::updateProgress(
+    CProgress &progress,
+    size_t length,
+    IFlashStatus &status,
+    CUpdateStatistics &statistics)
+{
+    progress.downloaded += static_cast<int>(length);
+
+    if (progress.total > 0)
     {
-        ESP_LOGE(TAG, "Server reported image size (%d) does not match metadata image size (%d)", total, image.size);
+        float percentage = static_cast<float>(progress.downloaded) / static_cast<float>(progress.total) * 100.0f;
+
+        // Logged for every buffer, which slows the download down when the console is on
+        ESP_LOGD(
+            TAG,
+            "Download size: %d - bytes read: %d - progress: %03.2f",
+            progress.total,
+            progress.downloaded,
+            percentage);
+
+        auto start = esp_timer_get_time();
+        status.setProgress(percentage);
+        statistics.ui += esp_timer_get_time() - start;
+        statistics.progressUpdates++;
     }
+}
+
+bool CFlasher::flashPatch(
+    Application::Hardware::IHttp &http,
+    const CImage &image,
+    IPartition &partition,
+    IFlashStatus &status,
+    const CFlashThrottle &throttle)
+{
+    auto start = esp_timer_get_time();
+
+    const char *version = esp_app_get_description()->version;
+    auto patch = std::find_if(
+        image.patches.begin(),
+        image.patches.end(),
+        [version](const CImage::CPatch &item) { return item.from == version; });
 
-    while (ESP_ERR_HTTPS_OTA_IN_PROGRESS == esp_https_ota_perform(otaHandle))
+    if (patch == image.patches.end())
     {
-        auto read = esp_https_ota_get_image_len_read(otaHandle);
-        float progress = static_cast<float>(read) / static_cast<float>(total) * 100.0f;
-        ESP_LOGI(TAG, "Image size: %d - bytes read: %d - progress: %03.2f", total, read, progress);
-        dialog.setProgress(progress);
+        ESP_LOGI(TAG, "No patch available from %s", version);
+        return false;
     }
 
-    if (!esp_https_ota_is_complete_data_received(otaHandle))
+    CUpdateStatistics statistics = {};
+
+    // The same version doesn't guarantee the same binary, local builds for example
+    CFlashPartition running(*esp_ota_get_running_partition());
+    CHash hash;
+    bool matches = patch->fromSize > 0 && static_cast<size_t>(patch->fromSize) <= running.getSize() &&
+                   CFlasher::hashPartition(running, patch->fromSize, hash) && hash == patch->fromHash;
+
+    statistics.check = esp_timer_get_time() - start;
+
+    if (!matches)
     {
-        ESP_LOGE(TAG, "Complete data was not received.");
-        esp_https_ota_abort(otaHandle);
+        ESP_LOGW(TAG, "Running firmware does not match the source of the patch");
+        statistics.total = statistics.check;
+        CFlasher::record(statistics, partition.getLabel());
         return false;
     }
 
-    if (partition != nullptr)
+    CFlasher::setStatusFlashing(image, status);
+
+    ESP_LOGI(TAG, "Patching `%s` into `%s` from %s", running.getLabel(), partition.getLabel(), patch->url.data());
+
+    // Patches are only published with the release
+    CMirrors mirrors(patch->url, {});
+    CHttpSource source(http, mirrors, -1);
+
+    // The patch is decompressed first, when needed, and then applied
+    std::optional<CInflater> inflater;
+    std::vector<IDecoder *> decoders;
+    if (patch->encoding == CImage::Zlib)
+    {
+        inflater.emplace();
+        decoders.push_back(&*inflater);
+    }
+
+    CPatcher patcher(
+        [&running](size_t offset, uint8_t *data, size_t length) { return running.read(offset, data, length); },
+        patch->fromSize);
+    decoders.push_back(&patcher);
+
+    CProgress progress = {.downloaded = 0, .total = image.size};
+
+    // The patched image is hashed as it is written
+    CImageVerifier verifier(image);
+    CFlashEngine engine(partition, &verifier, nullptr, [&progress, &status, &statistics](size_t length) {
+        CFlasher::updateProgress(progress, length, status, statistics);
+    });
+    engine.setThrottle(throttle);
+
+    bool result = engine.begin() && engine.write(source, CRegion(0, image.size), decoders);
+    result = engine.finish() && result;
+
+    // A failed patch is followed by the complete image, which is counted instead
+    statistics.images = result ? 1 : 0;
+    statistics.total = esp_timer_get_time() - start;
+    statistics.download = source.getStatistics();
+    statistics.decompress = inflater ? inflater->getDuration() : 0;
+    statistics.add(engine.getStatistics(), verifier.getStatistics());
+    CFlasher::record(statistics, partition.getLabel());
+
+    if (result && !engine.verify())
     {
-        // THIS IS A VERY DIRTY HACK: by changing the state we trick `esp_https_ota_finish` to not write the next boot
-        // partition
-        //
-        // This will only work as long as ESP_HTTPS_OTA_IN_PROGRESS does the same as ESP_HTTPS_OTA_SUCCESS except for
-        // the boot partition step
-        ota->state = ESP_HTTPS_OTA_IN_PROGRESS;
+        ESP_LOGE(TAG, "Verification of the patched `%s` failed", partition.getLabel());
+        result = false;
     }
 
-    return (ESP_OK == esp_https_ota_finish(otaHandle));
+    return result;
 }
 
-bool CFlasher::flashRaw(
+bool CFlasher::flashImage(
+    Application::Hardware::IHttp &http,
     const CImage &image,
-    const esp_partition_t &partition,
-    esp_http_client_config_t &httpConfig,
-    Application::LVGL::CWaitDialog &dialog)
+    IPartition &partition,
+    IFlashStatus &status,
+    const CFlashThrottle &throttle)
 {
-    RawUserData userData =
-        {.partition = partition, .size = image.size, .contentLength = -2, .dialog = dialog, .written = 0};
+    auto start = esp_timer_get_time();
 
-    httpConfig.user_data = &userData;
+    CUpdateStatistics statistics = {};
+    statistics.images = 1;
 
-    httpConfig.event_handler = [](esp_http_client_event_t *event) -> esp_err_t {
-        RawUserData &data = *static_cast<RawUserData *>(event->user_data);
+    CRegions regions;
+    bool partial = false;
+
+    if (!image.blocks.empty())
+    {
+        CFlasher::setStatusChecking(image, status);
 
-        switch (event->event_id)
+        if (!CFlasher::findChangedBlocks(image, partition, status, regions))
         {
-        case HTTP_EVENT_ERROR:
-            ESP_LOGW(TAG, "HTTP_EVENT_ERROR");
-            return ESP_FAIL;
-            break;
-        case HTTP_EVENT_ON_DATA:
-            if (data.contentLength == -2)
-            {
-                // We haven't fetched the content length yet
-                data.contentLength = static_cast<int>(esp_http_client_get_content_length(event->client));
-
-                if (data.contentLength > 0)
-                {
-                    if (data.contentLength > data.size)
-                    {
-                        ESP_LOGE(
-                            TAG,
-                            "Server reported image size (%d) does not match metadata image size (%d)",
-                            data.contentLength,
-                            data.size);
-                    }
-                    else
-                    {
-                        ESP_LOGW(TAG, "Server did not report image size.");
-                    }
-                }
-            }
+            ESP_LOGW(TAG, "Could not read `%s`, flashing the complete image", partition.getLabel());
+            regions.clear();
+            regions.emplace_back(0, image.size);
+        }
+        else if (regions.empty())
+        {
+            ESP_LOGI(TAG, "`%s` is already up to date", partition.getLabel());
+            statistics.check = statistics.total = esp_timer_get_time() - start;
+            CFlasher::record(statistics, partition.getLabel());
+            return true;
+        }
+        else if (image.encoding != CImage::Raw)
+        {
+            // Blocks can't be requested separately from a compressed stream
+            regions.clear();
+            regions.emplace_back(0, image.size);
+        }
+        else
+        {
+            partial = regions.size() > 1 || regions.front().second != image.size;
+        }
+    }
+    else
+    {
+        CHash hash;
+        if (image.hash && CFlasher::hashPartition(partition, image.size, hash) && hash == *image.hash)
+        {
+            ESP_LOGI(TAG, "`%s` is already up to date", partition.getLabel());
+            statistics.check = statistics.total = esp_timer_get_time() - start;
+            CFlasher::record(statistics, partition.getLabel());
+            return true;
+        }
 
-            if (ESP_OK != esp_partition_write(&data.partition, data.written, event->data, event->data_len))
-            {
-                ESP_LOGE(TAG, "Error while writing to flash");
-                return ESP_FAIL;
-            }
+        regions.emplace_back(0, image.size);
+    }
+
+    CFlasher::setStatusFlashing(image, status);
 
-            data.written += event->data_len;
+    // Complete raw images can continue where a previous attempt stopped, also after a reboot. Images with block
+    // hashes don't need this: the blocks that were already flashed are skipped anyway.
+    bool resumable = image.encoding == CImage::Raw && image.size > 0 && !partial;
+    size_t resumed = 0;
+
+    CImageVerifier verifier(image);
+
+    // Only the part that was flashed before the interruption is read back, to continue the hash of the image
+    if (resumable && CFlasher::canResume(image, partition) &&
+        verifier.resume(partition, Settings::resumeOffset.get()))
+    {
+        resumed = Settings::resumeOffset.get();
+        ESP_LOGI(TAG, "Resuming `%s` at %d bytes", partition.getLabel(), resumed);
+
+        regions.front() = CRegion(resumed, image.size - static_cast<int>(resumed));
+    }
+
+    statistics.check = esp_timer_get_time() - start;
+
+    CProgress progress = {.downloaded = static_cast<int>(resumed), .total = static_cast<int>(resumed)};
+    for (const auto &region : regions)
+    {
+        progress.total += std::max(region.second, 0);
+    }
+
+    // Progress is persisted from the writer thread, once it is really in flash
+    size_t checkpoint = resumed;
+    CPartitionWriter::COnWritten onWritten = nullptr;
+
+    if (resumable)
+    {
+        Settings::resumeUrl.set(std::string(image.url));
+        Settings::resumePartition.set(partition.getLabel());
+        Settings::resumeSize.set(image.size);
+        Settings::resumeOffset.set(static_cast<int32_t>(resumed));
+
+        onWritten = [&checkpoint, &partition](size_t offset) {
+            if (offset >= checkpoint + RESUME_CHECKPOINT_SIZE)
             {
-                float progress = static_cast<float>(data.written) / static_cast<float>(data.size) * 100.0f;
-                ESP_LOGI(TAG, "Image size: %d - bytes read: %d - progress: %03.2f", data.size, data.written, progress);
-                data.dialog.setProgress(progress);
+                // The sector the writer is in will be erased again when resuming
+                checkpoint = offset / partition.getEraseSize() * partition.getEraseSize();
+                Settings::resumeOffset.set(static_cast<int32_t>(checkpoint));
             }
+        };
+    }
 
-            break;
-        default:
-            break;
-        }
-        return ESP_OK;
-    };
+    ESP_LOGI(
+        TAG,
+        "Starting update of `%s`, writing %d bytes in %d parts",
+        partition.getLabel(),
+        progress.total,
+        regions.size());
+
+    // The probes open the connection the download continues on, so they count as connecting
+    auto selecting = esp_timer_get_time();
+    CMirrors mirrors(image.url, image.mirrors);
+    mirrors.select(http, progress.total);
+    auto selected = esp_timer_get_time() - selecting;
+
+    // Raw images are read by offset, so single blocks can be requested. Compressed ones are always read completely.
+    CHttpSource source(http, mirrors, image.encoding == CImage::Raw ? image.size : -1);
+
+    std::optional<CInflater> inflater;
+    std::vector<IDecoder *> decoders;
+    if (image.encoding == CImage::Zlib)
+    {
+        inflater.emplace();
+        decoders.push_back(&*inflater);
+    }
+
+    // Downloading happens on this thread, erasing, writing and hashing on the writer's thread
+    CFlashEngine engine(partition, &verifier, onWritten, [&progress, &status, &statistics](size_t length) {
+        CFlasher::updateProgress(progress, length, status, statistics);
+    });
+    engine.setThrottle(throttle);
 
-    CFlasher::setStatusErasing(partition, dialog);
-    auto step = (partition.size / 100 / partition.erase_size) * partition.erase_size;
-    for (uint32_t i = 0; i <= partition.size; i += step)
+    bool result = engine.begin();
+    for (const auto &region : regions)
     {
-        esp_partition_erase_range(&partition, i, i + step);
-        float progress = static_cast<float>(i) / static_cast<float>(partition.size) * 100.0f;
-        ESP_LOGI(TAG, "Erasing `%s` %lu %lu - progress: %03.2f", partition.label, i, partition.size, progress);
-        dialog.setProgress(progress);
+        result = result && engine.write(source, region, decoders);
     }
 
-    CFlasher::setStatusFlashing(image, dialog);
+    result = engine.finish() && result;
 
-    esp_http_client_handle_t client = esp_http_client_init(&httpConfig);
+    statistics.total = esp_timer_get_time() - start;
+    statistics.download = source.getStatistics();
+    statistics.download.connect += selected;
+    statistics.decompress = inflater ? inflater->getDuration() : 0;
+    statistics.add(engine.getStatistics(), verifier.getStatistics());
+    CFlasher::record(statistics, partition.getLabel());
 
-    ESP_LOGI(TAG, "Starting Raw OTA update on partition `%s`", partition.label);
+    // A failed download can be resumed later, but flashed data that doesn't verify can't
+    bool completed = result;
 
-    if (ESP_OK != esp_http_client_perform(client) || 200 != esp_http_client_get_status_code(client))
+    // Checked before the partition is activated or its version is stored, without reading it back
+    if (result && !engine.verify())
     {
-        ESP_LOGE(TAG, "Could not download from %s", httpConfig.url);
-        return false;
+        ESP_LOGE(TAG, "Verification of `%s` failed", partition.getLabel());
+        result = false;
+    }
+
+    if (resumable && completed)
+    {
+        Settings::resumeUrl.set("");
+        Settings::resumeOffset.set(0);
     }
 
-    esp_http_client_cleanup(client);
+    return result;
+}
 
-    // httpConfig should no longer be used, but still, clear pointers to things that will disappear
-    httpConfig.user_data = nullptr;
-    httpConfig.event_handler = nullptr;
+bool CFlasher::canResume(const CImage &image, IPartition &partition)
+{
+    auto offset = Settings::resumeOffset.get();
 
-    return true;
+    return Settings::resumeUrl.get() == image.url && Settings::resumePartition.get() == partition.getLabel() &&
+           Settings::resumeSize.get() == image.size && offset > 0 && offset < image.size &&
+           offset % partition.getEraseSize() == 0;
 }
 
-void CFlasher::setStatusFlashing(const CImage &image, Application::LVGL::CWaitDialog &dialog)
+void CFlasher::setStatusFlashing(const CImage &image, IFlashStatus &status)
 {
-    std::string dialogText = std::string("Flashing ") + CImage::typeToUIString.at(image.imageType) + "...";
-    dialog.setStatus(dialogText.c_str());
+    std::string text = std::string("Flashing ") + CImage::typeToUIString.at(image.imageType) + "...";
+    status.setStatus(text.c_str());
 }
 
-void CFlasher::setStatusErasing(const esp_partition_t &partition, Application::LVGL::CWaitDialog &dialog)
+void CFlasher::setStatusChecking(const CImage &image, IFlashStatus &status)
 {
-    std::string dialogText = std::string("Erasing ") + partition.label + "...";
-    dialog.setStatus(dialogText.c_str());
+    std::string text = std::string("Checking ") + CImage::typeToUIString.at(image.imageType) + "...";
+    status.setStatus(text.c_str());
 }
 
 } // namespace Fri3d::Apps::Ota
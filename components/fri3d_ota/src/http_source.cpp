@@ -0,0 +1,281 @@
+#include <string>
+
+#include "esp_http_client.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "fri3d_private/http_source.hpp"
+
+namespace Fri3d::Apps::Ota
+{
+
+static const char *TAG = "Fri3d::Apps::Ota::CHttpSource";
+
+CHttpSource::CHttpSource(Application::Hardware::IHttp &http, CMirrors &mirrors, int size)
+    : http(http)
+    , mirrors(mirrors)
+    , size(size)
+    , offset(0)
+    , length(-1)
+    , received(0)
+    , interrupted(false)
+    , statistics()
+{
+    esp_log_level_set(TAG, static_cast<esp_log_level_t>(LOG_LOCAL_LEVEL));
+}
+
+CHttpSource::~CHttpSource()
+{
+    this->close();
+}
+
+CHttpSource::CResult CHttpSource::request()
+{
+    const auto &url = this->mirrors.getUrl();
+    auto handle = this->client->get();
+
+    esp_http_client_set_url(handle, url.c_str());
+
+    // After an interruption, only the remainder is requested
+    auto start = this->offset + this->received;
+    bool ranged = start > 0 || (this->length >= 0 && static_cast<int>(this->offset) + this->length != this->size);
+
+    if (ranged)
+    {
+        auto range = std::string("bytes=") + std::to_string(start) + "-";
+        if (this->length >= 0)
+        {
+            range += std::to_string(this->offset + this->length - 1);
+        }
+        esp_http_client_set_header(handle, "Range", range.c_str());
+    }
+    else
+    {
+        esp_http_client_delete_header(handle, "Range");
+    }
+
+    this->statistics.requests++;
+
+    auto now = esp_timer_get_time();
+    auto opened = ESP_OK == esp_http_client_open(handle, 0);
+    this->statistics.connect += esp_timer_get_time() - now;
+
+    if (!opened)
+    {
+        ESP_LOGW(TAG, "Could not connect for %s", url.c_str());
+        return Interrupted;
+    }
+
+    now = esp_timer_get_time();
+    auto contentLength = static_cast<int>(esp_http_client_fetch_headers(handle));
+    this->statistics.response += esp_timer_get_time() - now;
+
+    if (contentLength < 0)
+    {
+        ESP_LOGW(TAG, "Could not fetch the headers for %s", url.c_str());
+        return Interrupted;
+    }
+
+    this->policy.update(*this->client);
+
+    auto status = esp_http_client_get_status_code(handle);
+    if (CRetryPolicy::isBusy(status))
+    {
+        ESP_LOGW(TAG, "Server is busy (status %d) for %s", status, url.c_str());
+        return Interrupted;
+    }
+
+    if (status >= 500)
+    {
+        ESP_LOGW(TAG, "Server error %d for %s", status, url.c_str());
+        return Interrupted;
+    }
+
+    // A server that ignores the range would send us the complete file
+    if (status != (ranged ? 206 : 200))
+    {
+        ESP_LOGE(TAG, "Could not download from %s (status %d)", url.c_str(), status);
+        return Failed;
+    }
+
+    auto expected = this->length - static_cast<int>(this->received);
+    if (this->length > 0 && contentLength > 0 && contentLength != expected)
+    {
+        if (ranged)
+        {
+            ESP_LOGE(TAG, "Server did not honor the range request for %s", url.c_str());
+            return Failed;
+        }
+
+        ESP_LOGE(TAG, "Server reported size (%d) does not match the expected size (%d)", contentLength, expected);
+    }
+
+    return Connected;
+}
+
+bool CHttpSource::connect()
+{
+    while (true)
+    {
+        const auto &url = this->mirrors.getUrl();
+
+        // Idle connections stay in the pool, so consecutive requests to the same server share one
+        this->client.reset();
+        this->client.emplace(this->http.acquire(url));
+        if (!*this->client)
+        {
+            this->client.reset();
+            return false;
+        }
+        CRetryPolicy::watch(*this->client);
+
+        this->mirrors.start();
+        auto result = this->request();
+
+        if (result == Connected)
+        {
+            this->interrupted = false;
+            return true;
+        }
+
+        this->disconnect(false);
+
+        if (result == Failed)
+        {
+            return false;
+        }
+
+        // Another server is tried right away, the retry policy only comes in when there is none left
+        if (!this->mirrors.failover() && !this->wait(url.c_str()))
+        {
+            return false;
+        }
+    }
+}
+
+bool CHttpSource::reconnect()
+{
+    const auto &url = this->mirrors.getUrl();
+    ESP_LOGW(TAG, "Download of %s interrupted after %d bytes", url.c_str(), this->received);
+
+    this->disconnect(false);
+
+    if (!this->mirrors.failover() && !this->wait(url.c_str()))
+    {
+        return false;
+    }
+
+    return this->connect();
+}
+
+bool CHttpSource::wait(const char *url)
+{
+    auto start = esp_timer_get_time();
+    auto result = this->policy.wait(url);
+    this->statistics.backoff += esp_timer_get_time() - start;
+
+    return result;
+}
+
+void CHttpSource::disconnect(bool success)
+{
+    if (!this->client)
+    {
+        return;
+    }
+
+    this->mirrors.finish(success);
+
+    // After a complete response the connection stays open for the next request
+    if (!success)
+    {
+        esp_http_client_close(this->client->get());
+    }
+
+    this->client.reset();
+}
+
+bool CHttpSource::open(size_t offset, int length)
+{
+    this->close();
+
+    this->offset = offset;
+    this->length = length;
+    this->received = 0;
+    this->policy = CRetryPolicy();
+
+    return this->connect();
+}
+
+int CHttpSource::read(uint8_t *data, size_t length)
+{
+    while (true)
+    {
+        if (!this->client)
+        {
+            return -1;
+        }
+
+        auto handle = this->client->get();
+
+        if (!this->interrupted && esp_http_client_is_complete_data_received(handle))
+        {
+            this->disconnect(true);
+            return 0;
+        }
+
+        int read = -1;
+        if (!this->interrupted)
+        {
+            auto start = esp_timer_get_time();
+            read = esp_http_client_read(handle, reinterpret_cast<char *>(data), length);
+            this->statistics.receive += esp_timer_get_time() - start;
+        }
+
+        if (read > 0)
+        {
+            this->received += read;
+            this->statistics.received += read;
+
+            // The download got further than before the last failure, only failures in a row use up the retries
+            if (this->policy.getAttempt() > 0)
+            {
+                this->policy.reset();
+            }
+
+            // Too slow counts as interrupted, the download continues from another server after this part
+            this->interrupted = !this->mirrors.onReceived(read);
+
+            return read;
+        }
+
+        if (read == 0 && esp_http_client_is_complete_data_received(handle))
+        {
+            this->disconnect(true);
+            return 0;
+        }
+
+        // The connection dropped, whatever we got so far is valid
+        if (!this->reconnect())
+        {
+            return -1;
+        }
+    }
+}
+
+void CHttpSource::close()
+{
+    this->disconnect(false);
+}
+
+const char *CHttpSource::getName() const
+{
+    return this->mirrors.getUrl().c_str();
+}
+
+const CDownloadStatistics &CHttpSource::getStatistics() const
+{
+    return this->statistics;
+}
+
+} // namespace Fri3d::Apps::Ota
@@ -0,0 +1,234 @@
+#include <algorithm>
+#include <vector>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "spi_flash_mmap.h"
+
+#include "fri3d_private/image_verifier.hpp"
+
+namespace Fri3d::Apps::Ota
+{
+
+static const char *TAG = "Fri3d::Apps::Ota::CImageVerifier";
+
+CImageVerifier::CImageVerifier(const CImage &image)
+    : image(image)
+    , imageContext()
+    , imagePosition(0)
+    , imageContiguous(true)
+    , blockContext()
+    , blockIndex(0)
+    , blockPosition(0)
+    , blockActive(false)
+    , unverified(0)
+    , blocksValid(true)
+    , statistics()
+{
+    esp_log_level_set(TAG, static_cast<esp_log_level_t>(LOG_LOCAL_LEVEL));
+
+    // The SHA accelerator is used by mbedtls when CONFIG_MBEDTLS_HARDWARE_SHA is enabled, which is the default
+    mbedtls_sha256_init(&this->imageContext);
+    mbedtls_sha256_starts(&this->imageContext, 0);
+    mbedtls_sha256_init(&this->blockContext);
+}
+
+CImageVerifier::~CImageVerifier()
+{
+    mbedtls_sha256_free(&this->imageContext);
+    mbedtls_sha256_free(&this->blockContext);
+}
+
+bool CImageVerifier::resume(IPartition &partition, size_t offset)
+{
+    if (!this->image.hash)
+    {
+        // Blocks that are only partly written are not verified, so there is nothing to do for them
+        this->imagePosition = offset;
+        return true;
+    }
+
+    std::vector<uint8_t> buffer(SPI_FLASH_SEC_SIZE);
+
+    for (size_t position = 0; position < offset; position += buffer.size())
+    {
+        auto length = std::min(buffer.size(), offset - position);
+        if (!partition.read(position, buffer.data(), length))
+        {
+            ESP_LOGE(TAG, "Could not read `%s` at %d", partition.getLabel(), position);
+
+            // Start over from the beginning of the image
+            mbedtls_sha256_starts(&this->imageContext, 0);
+            this->imagePosition = 0;
+            return false;
+        }
+
+        this->updateImage(position, buffer.data(), length);
+        this->statistics.hashed += length;
+    }
+
+    return true;
+}
+
+void CImageVerifier::updateImage(size_t offset, const uint8_t *data, size_t length)
+{
+    if (!this->image.hash || !this->imageContiguous)
+    {
+        return;
+    }
+
+    if (offset != this->imagePosition)
+    {
+        // Only part of the image is written, the blocks have to do
+        this->imageContiguous = false;
+        return;
+    }
+
+    auto start = esp_timer_get_time();
+    mbedtls_sha256_update(&this->imageContext, data, length);
+    this->statistics.duration += static_cast<uint32_t>(esp_timer_get_time() - start);
+
+    this->imagePosition += length;
+}
+
+void CImageVerifier::finishBlock()
+{
+    CHash hash;
+    mbedtls_sha256_finish(&this->blockContext, hash.data());
+    this->blockActive = false;
+
+    if (hash != this->image.blocks[this->blockIndex])
+    {
+        ESP_LOGE(TAG, "Block %d does not match its hash", this->blockIndex);
+        this->blocksValid = false;
+        this->unverified += this->blockPosition;
+    }
+}
+
+void CImageVerifier::updateBlocks(size_t offset, const uint8_t *data, size_t length)
+{
+    if (this->image.blocks.empty() || this->image.blockSize <= 0)
+    {
+        return;
+    }
+
+    auto blockSize = static_cast<size_t>(this->image.blockSize);
+    auto size = static_cast<size_t>(this->image.size);
+
+    while (length > 0)
+    {
+        auto index = offset / blockSize;
+        auto blockStart = index * blockSize;
+        auto blockEnd = std::min(blockStart + blockSize, size);
+
+        if (index >= this->image.blocks.size() || offset >= size)
+        {
+            // Beyond the image, nothing to compare with
+            this->unverified += length;
+            return;
+        }
+
+        auto part = std::min(length, blockEnd - offset);
+
+        if (offset == blockStart)
+        {
+            if (this->blockActive)
+            {
+                // The previous block was left incomplete
+                this->unverified += this->blockPosition;
+                this->blockActive = false;
+            }
+
+            mbedtls_sha256_starts(&this->blockContext, 0);
+            this->blockIndex = index;
+            this->blockPosition = 0;
+            this->blockActive = true;
+        }
+
+        if (this->blockActive && this->blockIndex == index && blockStart + this->blockPosition == offset)
+        {
+            auto start = esp_timer_get_time();
+            mbedtls_sha256_update(&this->blockContext, data, part);
+            this->statistics.duration += static_cast<uint32_t>(esp_timer_get_time() - start);
+
+            this->blockPosition += part;
+
+            if (blockStart + this->blockPosition == blockEnd)
+            {
+                this->finishBlock();
+            }
+        }
+        else
+        {
+            // Started halfway a block, after resuming for example
+            this->unverified += part;
+        }
+
+        offset += part;
+        data += part;
+        length -= part;
+    }
+}
+
+void CImageVerifier::update(size_t offset, const uint8_t *data, size_t length)
+{
+    if (!this->image.hash && this->image.blocks.empty())
+    {
+        return;
+    }
+
+    this->updateImage(offset, data, length);
+    this->updateBlocks(offset, data, length);
+    this->statistics.hashed += length;
+}
+
+bool CImageVerifier::verify()
+{
+    if (this->blockActive)
+    {
+        this->unverified += this->blockPosition;
+        this->blockActive = false;
+    }
+
+    if (this->image.hash && this->imageContiguous && this->imagePosition == static_cast<size_t>(this->image.size))
+    {
+        CHash hash;
+        mbedtls_sha256_finish(&this->imageContext, hash.data());
+
+        if (hash != *this->image.hash)
+        {
+            ESP_LOGE(TAG, "Image does not match its hash");
+            return false;
+        }
+
+        return true;
+    }
+
+    if (!this->image.blocks.empty())
+    {
+        // The blocks that were not written were compared with the partition before flashing
+        if (!this->blocksValid || this->unverified > 0)
+        {
+            ESP_LOGE(TAG, "%d bytes could not be verified", this->unverified);
+            return false;
+        }
+
+        return true;
+    }
+
+    if (this->image.hash)
+    {
+        ESP_LOGE(TAG, "Only %d of %d bytes of the image were hashed", this->imagePosition, this->image.size);
+        return false;
+    }
+
+    // Nothing to verify against
+    return true;
+}
+
+const CImageVerifier::CStatistics &CImageVerifier::getStatistics() const
+{
+    return this->statistics;
+}
+
+} // namespace Fri3d::Apps::Ota
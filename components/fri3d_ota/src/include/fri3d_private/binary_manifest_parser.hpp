@@ -0,0 +1,127 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "fri3d_private/firmware.hpp"
+#include "fri3d_private/manifest_parser.hpp"
+
+namespace Fri3d::Apps::Ota
+{
+
+/**
+ * @brief parser for the binary versions manifest, as written by tools/binary_manifest.py
+ *
+ * The manifest starts with the magic "F3DM" and a format version byte, followed by records until an END record. A
+ * record is a type byte, the length of its payload as a varint (LEB128) and the payload:
+ *
+ * - END (0x00): no payload, the manifest is complete
+ * - STRING (0x01): UTF-8 text, appended to the string table. Strings are referenced by their index in this table and
+ *   are always defined before the first record that uses them.
+ * - FIRMWARE (0x02): u8 flags (bit 0: beta, bit 1: rollout, bit 2: mirrors), version, varint image count and the
+ *   images. Followed by varint rollout start and varint rollout window if bit 1 is set and, if bit 2 is set, for every
+ *   image a varint mirror count and the base URLs of its mirrors as strings.
+ *
+ * Unknown record types are skipped. Every image is:
+ *
+ * - u8 type (CImage::ImageType), version, url, varint size + 1 (0 when unknown), u8 encoding (CImage::Encoding)
+ * - u8 flags, followed by the 32 byte SHA-256 if bit 0 is set and by varint block size, varint block count and the
+ *   32 byte hash of every block if bit 1 is set
+ * - varint patch count and the patches: string from, varint from size, 32 byte from hash, url, varint size + 1 and u8
+ *   encoding
+ *
+ * A version is its full text as a string, followed by u8 flags. Bit 0 is set when it was parsed by the tool, in which
+ * case varint major, minor and patch follow, then the prerelease string if bit 1 is set and the metadata string if
+ * bit 2 is set. A url is two strings, the part up to and including the last '/' and the rest.
+ *
+ * The string table and the lists of the firmwares are kept in an arena the firmwares share, strings are not copied
+ * again for every firmware that uses them. Besides that only the record being parsed is kept in memory.
+ */
+class CBinaryManifestParser : public IManifestParser
+{
+public:
+    static const size_t HeaderSize = 5;
+    static const size_t MaxRecordSize = 64 * 1024;
+
+    /**
+     * @return true if the data is the start of a binary manifest instead of a JSON one
+     */
+    static bool isBinary(const char *data, size_t length);
+
+private:
+    enum State
+    {
+        Header,
+        RecordType,
+        RecordLength,
+        RecordPayload,
+        Done,
+        Failed
+    };
+
+    // Reads the fields of a complete record, every read fails at the end of it
+    class CCursor
+    {
+    private:
+        const CBinaryManifestParser &parser;
+        const uint8_t *data;
+        const uint8_t *end;
+
+    public:
+        CCursor(const CBinaryManifestParser &parser, const std::vector<uint8_t> &record);
+
+        bool readByte(uint8_t &value);
+        bool readVarint(uint32_t &value);
+        bool readHash(CHash &hash);
+        bool readString(std::string_view &value);
+        bool readVersion(CVersion &version);
+        bool readUrl(std::string_view &url);
+        // Size + 1, 0 for unknown
+        bool readSize(int &size);
+    };
+
+    COnFirmware onFirmware;
+    State state;
+
+    std::array<uint8_t, HeaderSize> header;
+    size_t headerLength;
+
+    uint8_t recordType;
+    uint32_t recordLength;
+    int recordLengthShift;
+    std::vector<uint8_t> record;
+
+    std::shared_ptr<CManifestArena> arena;
+    std::vector<std::string_view> strings;
+
+    // Every image of the firmware being read, for the mirrors at the end. Unknown images are nullptr.
+    std::vector<CImage *> images;
+    // Lists of the image being read, they only go to the arena when they are complete
+    std::vector<std::string_view> mirrors;
+    std::vector<CImage::CPatch> patches;
+
+    size_t firmwareCount;
+    size_t offset;
+
+    bool step(const uint8_t *data, size_t length, size_t &used);
+    bool endRecord();
+    bool parseFirmware();
+    bool parseImage(CCursor &cursor, CImage &image, bool &known);
+    bool fail(const char *reason);
+
+public:
+    /**
+     * @param onFirmware called for every valid firmware in the manifest, in document order
+     */
+    explicit CBinaryManifestParser(COnFirmware onFirmware);
+
+    bool feed(const char *data, size_t length) override;
+    [[nodiscard]] bool isDone() const override;
+    [[nodiscard]] size_t getFirmwareCount() const override;
+};
+
+} // namespace Fri3d::Apps::Ota
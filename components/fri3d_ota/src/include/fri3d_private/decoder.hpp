@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace Fri3d::Apps::Ota
+{
+
+/**
+ * @brief turns a stream as it is downloaded into the data that is flashed, decoders can be chained
+ */
+class IDecoder
+{
+public:
+    typedef std::function<bool(const uint8_t *data, size_t length)> COutput;
+
+    virtual ~IDecoder() = default;
+
+    /**
+     * @brief decode the next part of the stream
+     *
+     * @param output called with every decoded part, return false to abort
+     *
+     * @returns false if the data is invalid or the output aborted
+     */
+    virtual bool feed(const uint8_t *data, size_t length, const COutput &output) = 0;
+
+    /**
+     * @return true when the complete stream was decoded
+     */
+    [[nodiscard]] virtual bool isDone() const = 0;
+};
+
+} // namespace Fri3d::Apps::Ota
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#include "fri3d_private/partition.hpp"
+
+namespace Fri3d::Apps::Ota
+{
+
+/**
+ * @brief a partition backed by a file, to run the flash engine on a host
+ *
+ * Writes behave like NOR flash: they can only clear bits, so data written to an area that wasn't erased ends up
+ * corrupted just like on the badge. Apart from logging this class does not depend on ESP-IDF.
+ */
+class CFilePartition : public IPartition
+{
+private:
+    std::string path;
+    std::string label;
+    size_t size;
+    size_t eraseSize;
+    FILE *file;
+
+public:
+    /**
+     * @param path file that holds the contents, it is created filled with 0xff when it doesn't exist
+     */
+    CFilePartition(std::string path, std::string label, size_t size, size_t eraseSize = 4096);
+    ~CFilePartition() override;
+
+    CFilePartition(const CFilePartition &) = delete;
+    CFilePartition &operator=(const CFilePartition &) = delete;
+
+    [[nodiscard]] const char *getLabel() const override;
+    [[nodiscard]] size_t getSize() const override;
+    [[nodiscard]] size_t getEraseSize() const override;
+
+    bool begin() override;
+    bool read(size_t offset, void *data, size_t length) override;
+    bool erase(size_t offset, size_t length) override;
+    bool write(size_t offset, const void *data, size_t length) override;
+    bool end() override;
+};
+
+} // namespace Fri3d::Apps::Ota
@@ -1,14 +1,23 @@
 #pragma once
 
-#include <map>
-#include <string>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string_view>
 #include <vector>
 
+#include "fri3d_private/manifest_arena.hpp"
 #include "fri3d_private/version.hpp"
 
 namespace Fri3d::Apps::Ota
 {
 
+typedef std::array<uint8_t, 32> CHash;
+
 struct CImage
 {
     enum ImageType
@@ -21,31 +30,199 @@ struct CImage
         VFS
     };
 
-    typedef const std::map<std::string, ImageType> StringToTypeMap;
-    static StringToTypeMap jsonStringToType;
+    static const size_t TypeCount = VFS + 1;
+
+    enum Encoding
+    {
+        Raw,
+        Zlib
+    };
 
-    typedef const std::map<ImageType, std::string> TypeToStringMap;
-    static TypeToStringMap typeToUIString;
+    static const size_t EncodingCount = Zlib + 1;
 
+    // Delta patch to this image from an older version
+    struct CPatch
+    {
+        // Full version text of the source, as in its app description
+        std::string_view from;
+        int fromSize;
+        CHash fromHash;
+        std::string_view url;
+        int size;
+        Encoding encoding;
+    };
+
+    // Indexed by type and encoding
+    static const std::array<const char *, TypeCount> typeToJsonString;
+    static const std::array<const char *, TypeCount> typeToUIString;
+    static const std::array<const char *, EncodingCount> encodingToJsonString;
+
+    // The strings, lists and patches are in the arena of the firmware
     ImageType imageType;
     CVersion version;
-    std::string url;
+    std::string_view url;
+    // Base URLs of mirrors that serve the same file as url, under the same name
+    std::span<const std::string_view> mirrors;
+    // Size of the image once decoded
     int size;
+    Encoding encoding;
+
+    // Optional SHA-256 of the complete image
+    std::optional<CHash> hash;
+    // Optional SHA-256 of every block of blockSize bytes, the last block can be shorter
+    int blockSize;
+    std::span<const CHash> blocks;
+
+    // Only for the main image
+    std::span<const CPatch> patches;
+
+    /**
+     * @returns false if the text is not the name of a type in the manifest
+     */
+    static bool parseType(const char *text, ImageType &type);
+
+    /**
+     * @returns false if the text is not the name of an encoding in the manifest
+     */
+    static bool parseEncoding(const char *text, Encoding &encoding);
+
+    /**
+     * @brief drop the hashes and patches that can't be used
+     *
+     * @returns false if the block hashes were dropped because they don't match the image
+     */
+    bool sanitize();
 
     friend bool operator<(const CImage &l, const CImage &r);
 };
 
-struct CFirmware
+/**
+ * @brief the images of a firmware, at most one of every type
+ *
+ * Iterating gives the images that are present, ordered by type.
+ */
+class CImages
 {
-    typedef std::map<CImage::ImageType, CImage> CImages;
+private:
+    std::array<CImage, CImage::TypeCount> images;
+    // Bit per type that is present
+    uint32_t present;
+
+public:
+    class CIterator
+    {
+    private:
+        const CImages *images;
+        size_t index;
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = CImage;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const CImage *;
+        using reference = const CImage &;
+
+        CIterator(const CImages *images, size_t index);
+
+        reference operator*() const;
+        pointer operator->() const;
+        CIterator &operator++();
+        CIterator operator++(int);
+        bool operator==(const CIterator &other) const;
+    };
+
+    CImages();
+
+    [[nodiscard]] bool contains(CImage::ImageType type) const;
 
+    /**
+     * @brief the image has to be present, see contains()
+     */
+    [[nodiscard]] const CImage &at(CImage::ImageType type) const;
+    CImage &at(CImage::ImageType type);
+
+    /**
+     * @brief add the image, or replace the one of the same type
+     */
+    CImage &set(const CImage &image);
+
+    [[nodiscard]] size_t size() const;
+    [[nodiscard]] bool empty() const;
+
+    [[nodiscard]] CIterator begin() const;
+    [[nodiscard]] CIterator end() const;
+};
+
+struct CFirmware
+{
     CVersion version;
     bool beta;
     CImages images;
+    // Memory of the strings, lists and patches of the images
+    std::shared_ptr<const CManifestArena> arena;
+
+    // Optional rollout set by the server: badges spread their downloads over rolloutWindow seconds, starting at
+    // rolloutStart in seconds since the epoch. A window of 0 means everyone can update right away.
+    int64_t rolloutStart;
+    uint32_t rolloutWindow;
+
+    /**
+     * @return server time at which this badge may start downloading the firmware, the same for every check
+     */
+    [[nodiscard]] int64_t getSlot() const;
 
     friend bool operator<(const CFirmware &l, const CFirmware &r);
 };
 
 typedef std::vector<CFirmware> CFirmwares;
 
+/**
+ * @brief firmwares in the order to show them, without copying them
+ *
+ * The firmwares it points to have to stay where they are for as long as the list is used.
+ */
+class CFirmwareList
+{
+private:
+    std::vector<const CFirmware *> items;
+
+public:
+    class CIterator
+    {
+    private:
+        std::vector<const CFirmware *>::const_iterator item;
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = CFirmware;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const CFirmware *;
+        using reference = const CFirmware &;
+
+        explicit CIterator(std::vector<const CFirmware *>::const_iterator item);
+
+        reference operator*() const;
+        pointer operator->() const;
+        CIterator &operator++();
+        CIterator operator++(int);
+        bool operator==(const CIterator &other) const;
+    };
+
+    void clear();
+    void add(const CFirmware &firmware);
+
+    /**
+     * @brief newest first
+     */
+    void sort();
+
+    [[nodiscard]] size_t size() const;
+    [[nodiscard]] bool empty() const;
+    [[nodiscard]] const CFirmware &front() const;
+    const CFirmware &operator[](size_t index) const;
+
+    [[nodiscard]] CIterator begin() const;
+    [[nodiscard]] CIterator end() const;
+};
+
 } // namespace Fri3d::Apps::Ota
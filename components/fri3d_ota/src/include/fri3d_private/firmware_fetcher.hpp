@@ -1,8 +1,14 @@
 #pragma once
 
+#include <memory>
+#include <mutex>
 #include <string>
 
+#include "fri3d_application/hardware_http.hpp"
+#include "fri3d_application/nvs_manager.hpp"
 #include "fri3d_private/firmware.hpp"
+#include "fri3d_private/manifest_parser.hpp"
+#include "fri3d_private/update_statistics.hpp"
 
 namespace Fri3d::Apps::Ota
 {
@@ -10,17 +16,99 @@ namespace Fri3d::Apps::Ota
 class CFirmwareFetcher
 {
 private:
+    // A downloaded manifest and the validators the server sent with it
+    struct CCacheEntry
+    {
+        // Left empty when the manifest doesn't fit the cache
+        std::string manifest;
+        std::string eTag;
+        std::string modified;
+    };
+
+    // Where the time of a refresh went, in microseconds
+    struct CTiming
+    {
+        CDownloadStatistics download;
+        // Feeding the manifest to the parser while it comes in
+        int64_t parse;
+    };
+
+    // The cache is shared by all fetchers, so only one of them checks with the server at a time
+    static std::mutex refreshMutex;
+
+    // In the order of the manifest, the lists point into it
     CFirmwares firmwares;
-    CFirmwares official;
+    CFirmwareList all;
+    CFirmwareList official;
+    // The list was confirmed with the server, it's not just the cached copy
+    bool fresh;
+    // The cache in NVS holds the manifest the list was confirmed with
+    bool cached;
+
+    static std::unique_ptr<IManifestParser> createParser(
+        const char *data,
+        size_t length,
+        const IManifestParser::COnFirmware &onFirmware);
+
+    /**
+     * @brief download the manifest and feed it to a parser for its format while it comes in
+     *
+     * Sends the validators of the cached manifest, so the server can answer that nothing changed.
+     *
+     * @param parser receives the parser that was used
+     * @param cache receives the manifest and its validators
+     * @param timing the time spent is added to this
+     * @returns size of the manifest, 0 when it was not modified since it was cached, negative on failure
+     */
+    int fetch(
+        Application::Hardware::IHttp &http,
+        std::unique_ptr<IManifestParser> &parser,
+        CCacheEntry &cache,
+        CTiming &timing);
 
-    static std::string fetch();
-    bool parse(const char *json);
+    [[nodiscard]] bool parse(const std::string &manifest);
+    [[nodiscard]] bool parseCache(Application::INvsManager &nvs);
+    /**
+     * @brief replace the cached manifest, or remove it when the new one can't be stored
+     *
+     * @return true if the cache now holds the manifest of the server
+     */
+    static bool store(Application::INvsManager &nvs, const CCacheEntry &cache);
+    void sort();
 
 public:
     CFirmwareFetcher();
 
-    [[nodiscard]] bool refresh();
-    [[nodiscard]] const CFirmwares &getFirmwares(bool beta) const;
+    /**
+     * @brief read the versions from the manifest cached in NVS, without going online
+     *
+     * @param fresh the cache was recently checked with the server
+     */
+    bool load(Application::INvsManager &nvs, bool fresh);
+
+    /**
+     * @brief check the server for new versions, the cached manifest is used when it was not modified
+     *
+     * @param showDialog show a wait dialog, not for checks in the background
+     */
+    [[nodiscard]] bool refresh(Application::Hardware::IHttp &http, Application::INvsManager &nvs, bool showDialog);
+
+    void clear();
+
+    /**
+     * @return the firmwares, newest first. Valid until the next load(), refresh() or clear().
+     */
+    [[nodiscard]] const CFirmwareList &getFirmwares(bool beta) const;
+
+    /**
+     * @return true if the versions were checked with the server, false if they only come from the cache
+     */
+    [[nodiscard]] bool isFresh() const;
+
+    /**
+     * @return true if the last refresh() left the manifest of the server in the cache, so load() shows the same
+     */
+    [[nodiscard]] bool isCached() const;
 };
 
 } // namespace Fri3d::Apps::Ota
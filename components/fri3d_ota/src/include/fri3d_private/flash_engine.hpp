@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "fri3d_private/decoder.hpp"
+#include "fri3d_private/image_verifier.hpp"
+#include "fri3d_private/partition.hpp"
+#include "fri3d_private/partition_writer.hpp"
+#include "fri3d_private/source.hpp"
+
+namespace Fri3d::Apps::Ota
+{
+
+/**
+ * @brief streams data from a source, through decoders, into a partition
+ *
+ * This is the only path data takes to flash, for app and data partitions alike. The source is read on the calling
+ * thread while the writer erases, writes and verifies on its own. None of the parts depend on where the data comes
+ * from or goes to, so the engine runs on a host with a CFileSource or CMemorySource and a CFilePartition as well.
+ */
+class CFlashEngine
+{
+public:
+    // Offset and length of a part of the image, a negative length means it is unknown
+    typedef std::pair<size_t, int> CRegion;
+
+    /**
+     * @brief called with the number of bytes of the decoded image that were handed to the writer
+     */
+    typedef std::function<void(size_t length)> COnProgress;
+
+private:
+    IPartition &partition;
+    IVerifier *verifier;
+    CPartitionWriter::COnWritten onWritten;
+    COnProgress onProgress;
+    CFlashThrottle throttle;
+
+    std::optional<CPartitionWriter> writer;
+
+    bool writeRaw(ISource &source);
+    bool writeDecoded(ISource &source, const std::vector<IDecoder *> &decoders);
+
+public:
+    /**
+     * @param verifier optional, gets everything that is written
+     * @param onWritten optional, see CPartitionWriter
+     */
+    CFlashEngine(
+        IPartition &partition,
+        IVerifier *verifier,
+        CPartitionWriter::COnWritten onWritten = nullptr,
+        COnProgress onProgress = nullptr);
+    ~CFlashEngine();
+
+    CFlashEngine(const CFlashEngine &) = delete;
+    CFlashEngine &operator=(const CFlashEngine &) = delete;
+
+    /**
+     * @brief limit how the flash is used while writing, before begin()
+     */
+    void setThrottle(const CFlashThrottle &value);
+
+    /**
+     * @brief prepare the partition and start the writer
+     */
+    bool begin();
+
+    /**
+     * @brief write a region of the image
+     *
+     * Without decoders, the region is read from the same offset in the source. With decoders, the source is read
+     * completely and passed through every decoder in turn, the output of the last one is written to the region.
+     */
+    bool write(ISource &source, const CRegion &region, const std::vector<IDecoder *> &decoders = {});
+
+    /**
+     * @brief wait for everything to be written
+     *
+     * @returns true if all data was written successfully
+     */
+    bool finish();
+
+    /**
+     * @brief check the result with the verifier and the partition, after finish()
+     */
+    bool verify();
+
+    [[nodiscard]] const CPartitionWriter::CStatistics &getStatistics() const;
+};
+
+} // namespace Fri3d::Apps::Ota
@@ -1,40 +1,114 @@
 #pragma once
 
-#include "esp_http_client.h"
+#include <mutex>
+#include <string>
+#include <vector>
+
 #include "esp_ota_ops.h"
 
-#include "fri3d_application/lvgl/wait_dialog.hpp"
+#include "fri3d_application/hardware_http.hpp"
 #include "fri3d_private/firmware.hpp"
+#include "fri3d_private/flash_engine.hpp"
+#include "fri3d_private/partition.hpp"
+#include "fri3d_private/update_statistics.hpp"
 
 namespace Fri3d::Apps::Ota
 {
 
+/**
+ * @brief where CFlasher reports what it is doing, a dialog in the foreground or an indicator in the background
+ */
+class IFlashStatus
+{
+public:
+    virtual ~IFlashStatus() = default;
+
+    virtual void setStatus(const char *status) = 0;
+    virtual void setProgress(float value) = 0;
+};
+
 class CFlasher
 {
 private:
-    static bool flashOta(
+    typedef CFlashEngine::CRegion CRegion;
+    typedef std::vector<CRegion> CRegions;
+
+    // Progress in bytes of the decoded image
+    struct CProgress
+    {
+        int downloaded;
+        int total;
+    };
+
+    // Summed over the images flashed since the last reset
+    static std::mutex totalsMutex;
+    static CUpdateStatistics totals;
+
+    static void updateProgress(
+        CProgress &progress,
+        size_t length,
+        IFlashStatus &status,
+        CUpdateStatistics &statistics);
+
+    /**
+     * @brief add the statistics of an image to the ones of the update and log them
+     */
+    static void record(const CUpdateStatistics &image, const char *label);
+
+    /**
+     * @brief download the image and write it to the partition, only the parts that changed when it has block hashes
+     */
+    static bool flashImage(
+        Application::Hardware::IHttp &http,
         const CImage &image,
-        const esp_partition_t *partition,
-        esp_http_client_config_t &httpConfig,
-        Application::LVGL::CWaitDialog &dialog);
+        IPartition &partition,
+        IFlashStatus &status,
+        const CFlashThrottle &throttle);
 
-    static bool flashRaw(
+    /**
+     * @brief apply a delta patch from the running firmware, if the manifest has one for it
+     *
+     * @returns false when there is no usable patch or applying it failed, the complete image should be flashed then
+     */
+    static bool flashPatch(
+        Application::Hardware::IHttp &http,
         const CImage &image,
-        const esp_partition_t &partition,
-        esp_http_client_config_t &httpConfig,
-        Application::LVGL::CWaitDialog &dialog);
+        IPartition &partition,
+        IFlashStatus &status,
+        const CFlashThrottle &throttle);
 
-    struct RawUserData
-    {
-        const esp_partition_t &partition;
-        int size;
-        int contentLength;
-        Application::LVGL::CWaitDialog &dialog;
-        size_t written;
-    };
+    /**
+     * @brief compare the block hashes of the image with the current contents of the partition
+     *
+     * @param[out] regions the parts of the image that differ, empty when the partition is up to date
+     *
+     * @returns false if the partition could not be read
+     */
+    static bool findChangedBlocks(
+        const CImage &image,
+        IPartition &partition,
+        IFlashStatus &status,
+        CRegions &regions);
+
+    /**
+     * @return true if a previous download of the image to the partition was interrupted and can be continued
+     */
+    static bool canResume(const CImage &image, IPartition &partition);
+
+    static bool hashPartition(IPartition &partition, size_t length, CHash &hash);
+
+    /**
+     * @return the OTA partition the main firmware should be flashed to
+     */
+    static const esp_partition_t *getUpdatePartition();
 
-    static void setStatusFlashing(const CImage &image, Application::LVGL::CWaitDialog &dialog);
-    static void setStatusErasing(const esp_partition_t &partition, Application::LVGL::CWaitDialog &dialog);
+    /**
+     * @brief boot the given OTA partition on the next restart, this verifies the image
+     */
+    static bool activate(const esp_partition_t &partition);
+
+    static void setStatusFlashing(const CImage &image, IFlashStatus &status);
+    static void setStatusChecking(const CImage &image, IFlashStatus &status);
 
 public:
     CFlasher();
@@ -46,22 +120,47 @@ public:
      */
     static std::string persist();
 
+    /**
+     * @brief forget the statistics of earlier updates, before flashing the first image
+     */
+    static void resetStatistics();
+
+    /**
+     * @return where the time went, summed over the images flashed since the last reset
+     */
+    static CUpdateStatistics getStatistics();
+
     /**
      * @brief flash the image to one of the two main firmware partitions
+     * @param http pool to take the connection from, so consecutive images share it
      * @param image
+     * @param status
+     * @param throttle limits on erasing and writing, to keep the UI smoother during the update
      *
      * @returns true on success
      */
-    static bool flash(const CImage &image);
+    static bool flash(
+        Application::Hardware::IHttp &http,
+        const CImage &image,
+        IFlashStatus &status,
+        const CFlashThrottle &throttle = {});
 
     /**
      * @brief flash the image to the specified partition
+     * @param http pool to take the connection from, so consecutive images share it
      * @param image
      * @param partitionName can be nullptr, in which case main firmware partitions are used
+     * @param status
+     * @param throttle
      *
      * @returns true on success
      */
-    static bool flash(const CImage &image, const char *partitionName);
+    static bool flash(
+        Application::Hardware::IHttp &http,
+        const CImage &image,
+        const char *partitionName,
+        IFlashStatus &status,
+        const CFlashThrottle &throttle = {});
 };
 
 } // namespace Fri3d::Apps::Ota
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#include "fri3d_application/hardware_http.hpp"
+#include "fri3d_private/mirrors.hpp"
+#include "fri3d_private/retry_policy.hpp"
+#include "fri3d_private/source.hpp"
+#include "fri3d_private/update_statistics.hpp"
+
+namespace Fri3d::Apps::Ota
+{
+
+/**
+ * @brief downloads from the pooled HTTP clients, from the fastest of the mirrors
+ *
+ * After transient errors, or when the server is busy or too slow, the download continues with a Range request for the
+ * remainder. The next mirror is tried first, the retry policy decides once there is none left. Every request that
+ * delivers data starts the retries over. A server that doesn't honor the range fails the download instead of
+ * corrupting it.
+ */
+class CHttpSource : public ISource
+{
+private:
+    enum CResult
+    {
+        Connected,
+        // Transient error, the download can be continued from where it stopped
+        Interrupted,
+        Failed
+    };
+
+    Application::Hardware::IHttp &http;
+    CMirrors &mirrors;
+    int size;
+
+    std::optional<Application::Hardware::CHttpClient> client;
+    CRetryPolicy policy;
+
+    size_t offset;
+    int length;
+    // Bytes received since open(), over all requests
+    size_t received;
+    bool interrupted;
+
+    CDownloadStatistics statistics;
+
+    CResult request();
+    bool connect();
+    bool reconnect();
+    // Pauses as the retry policy says, the time is counted as backoff
+    bool wait(const char *url);
+    void disconnect(bool success);
+
+public:
+    /**
+     * @param size of the complete file, negative when unknown. Only parts of it are requested with a Range header.
+     */
+    CHttpSource(Application::Hardware::IHttp &http, CMirrors &mirrors, int size);
+    ~CHttpSource() override;
+
+    CHttpSource(const CHttpSource &) = delete;
+    CHttpSource &operator=(const CHttpSource &) = delete;
+
+    bool open(size_t offset, int length) override;
+    int read(uint8_t *data, size_t length) override;
+    void close() override;
+    [[nodiscard]] const char *getName() const override;
+
+    /**
+     * @return time spent connecting, waiting and receiving, over everything downloaded since construction
+     */
+    [[nodiscard]] const CDownloadStatistics &getStatistics() const;
+};
+
+} // namespace Fri3d::Apps::Ota
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "mbedtls/sha256.h"
+
+#include "fri3d_private/firmware.hpp"
+#include "fri3d_private/partition.hpp"
+
+namespace Fri3d::Apps::Ota
+{
+
+/**
+ * @brief checks the data the flash engine writes
+ */
+class IVerifier
+{
+public:
+    virtual ~IVerifier() = default;
+
+    /**
+     * @brief check data that was written to the partition at offset, called from the writer thread
+     */
+    virtual void update(size_t offset, const uint8_t *data, size_t length) = 0;
+
+    /**
+     * @return true if everything that was written is correct
+     */
+    virtual bool verify() = 0;
+};
+
+/**
+ * @brief checks an image against the hashes in the manifest while it is written, so it never has to be read back
+ *
+ * The data is fed in the order it is written to the partition. When it covers the complete image from its start, the
+ * image hash is checked. Otherwise, for images with block hashes, every block that is written has to be complete and
+ * match its hash; the blocks that are not written were already found to be up to date before flashing.
+ */
+class CImageVerifier : public IVerifier
+{
+public:
+    struct CStatistics
+    {
+        // Bytes hashed, including the part read back from flash after resuming
+        size_t hashed;
+        // Time spent hashing, in microseconds
+        uint32_t duration;
+    };
+
+private:
+    const CImage &image;
+
+    mbedtls_sha256_context imageContext;
+    // Offset the next data has to be at for the image hash, it is given up after a gap
+    size_t imagePosition;
+    bool imageContiguous;
+
+    mbedtls_sha256_context blockContext;
+    size_t blockIndex;
+    size_t blockPosition;
+    bool blockActive;
+    // Bytes of blocks that were written but not found to match
+    size_t unverified;
+    bool blocksValid;
+
+    CStatistics statistics;
+
+    void updateImage(size_t offset, const uint8_t *data, size_t length);
+    void updateBlocks(size_t offset, const uint8_t *data, size_t length);
+    void finishBlock();
+
+public:
+    explicit CImageVerifier(const CImage &image);
+    ~CImageVerifier() override;
+
+    CImageVerifier(const CImageVerifier &) = delete;
+    CImageVerifier &operator=(const CImageVerifier &) = delete;
+
+    /**
+     * @brief hash the part of the image that was flashed before a download was interrupted
+     *
+     * @returns false if the partition could not be read
+     */
+    bool resume(IPartition &partition, size_t offset);
+
+    void update(size_t offset, const uint8_t *data, size_t length) override;
+
+    /**
+     * @return true if everything that was written matches the hashes of the image
+     */
+    bool verify() override;
+
+    [[nodiscard]] const CStatistics &getStatistics() const;
+};
+
+} // namespace Fri3d::Apps::Ota
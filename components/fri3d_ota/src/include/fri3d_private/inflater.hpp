@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "rom/miniz.h"
+
+#include "fri3d_private/decoder.hpp"
+
+namespace Fri3d::Apps::Ota
+{
+
+/**
+ * @brief streaming zlib decompression with the inflate implementation in ROM
+ *
+ * Memory use is bounded: the decompressor state and a 32 KB dictionary, independent of the size of the image.
+ */
+class CInflater : public IDecoder
+{
+private:
+    std::unique_ptr<tinfl_decompressor> decompressor;
+    std::vector<uint8_t> dictionary;
+    size_t dictionaryOffset;
+    bool done;
+
+    // Time spent decompressing, in microseconds
+    uint32_t duration;
+
+public:
+    CInflater();
+
+    /**
+     * @brief decompress the next part of the stream
+     *
+     * @param output called with every decompressed part, return false to abort
+     *
+     * @returns false if the data is corrupt or the output aborted
+     */
+    bool feed(const uint8_t *data, size_t length, const COutput &output) override;
+
+    /**
+     * @return true when the complete stream, including its checksum, was decompressed
+     */
+    [[nodiscard]] bool isDone() const override;
+
+    [[nodiscard]] uint32_t getDuration() const;
+};
+
+} // namespace Fri3d::Apps::Ota
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace Fri3d::Apps::Ota
+{
+
+/**
+ * @brief receives the contents of a JSON document from CJsonReader, in document order
+ */
+class IJsonHandler
+{
+public:
+    virtual void onStartObject() = 0;
+    virtual void onEndObject() = 0;
+    virtual void onStartArray() = 0;
+    virtual void onEndArray() = 0;
+
+    /**
+     * @brief the key of the next value in the current object
+     */
+    virtual void onKey(const char *key, size_t length) = 0;
+
+    virtual void onString(const char *value, size_t length) = 0;
+    virtual void onNumber(double value) = 0;
+    virtual void onBool(bool value) = 0;
+    virtual void onNull() = 0;
+};
+
+/**
+ * @brief incremental JSON tokenizer with fixed memory use
+ *
+ * The document can be fed in parts of any size, for example straight from the network, and is passed on to the handler
+ * without building a tree. Strings and numbers are collected in a buffer of MaxTokenSize bytes, nesting is limited to
+ * MaxDepth levels. Strings are passed on null terminated, without their quotes and with escapes resolved. \u escapes
+ * outside of the Basic Multilingual Plane are not supported.
+ *
+ * Apart from logging this class does not depend on ESP-IDF.
+ */
+class CJsonReader
+{
+public:
+    static const size_t MaxTokenSize = 512;
+    static const size_t MaxDepth = 32;
+
+private:
+    enum State
+    {
+        Value,
+        ArrayValueOrEnd,
+        ObjectKeyOrEnd,
+        ObjectKey,
+        Colon,
+        AfterValue,
+        String,
+        StringEscape,
+        StringUnicode,
+        Number,
+        Literal,
+        Done,
+        Failed
+    };
+
+    IJsonHandler &handler;
+    State state;
+
+    // One bit per level, set for objects and cleared for arrays
+    uint32_t containers;
+    size_t depth;
+
+    std::array<char, MaxTokenSize> token;
+    size_t tokenLength;
+    bool tokenIsKey;
+
+    // Remainder of `true`, `false` or `null` that is still expected
+    const char *literal;
+    uint16_t unicode;
+    int unicodeDigits;
+
+    size_t offset;
+
+    bool step(char c);
+    bool append(char c);
+    bool appendUnicode();
+    bool push(bool object);
+    bool pop(bool object);
+    bool endValue();
+    bool endNumber();
+    bool endLiteral();
+    bool fail(const char *reason);
+
+public:
+    explicit CJsonReader(IJsonHandler &handler);
+
+    /**
+     * @brief process the next part of the document
+     *
+     * @returns false if the document is invalid or exceeds the limits
+     */
+    bool feed(const char *data, size_t length);
+
+    /**
+     * @return true when the complete top level value was read
+     */
+    [[nodiscard]] bool isDone() const;
+};
+
+} // namespace Fri3d::Apps::Ota
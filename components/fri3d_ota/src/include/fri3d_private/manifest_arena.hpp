@@ -0,0 +1,81 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace Fri3d::Apps::Ota
+{
+
+/**
+ * @brief memory for the strings and lists of a parsed manifest
+ *
+ * Everything is allocated from a few large chunks instead of one heap block per string, and is only released with
+ * the arena. The firmwares of a manifest share it, so their views stay valid for as long as any of them is kept.
+ * Strings are stored with a terminating NUL, so the data() of their views can be logged and passed on as C strings.
+ */
+class CManifestArena
+{
+private:
+    static const size_t ChunkSize = 4096;
+
+    std::vector<std::unique_ptr<uint8_t[]>> chunks;
+    uint8_t *next;
+    size_t available;
+    size_t size;
+
+    void *allocate(size_t length, size_t alignment);
+
+public:
+    CManifestArena();
+
+    CManifestArena(const CManifestArena &) = delete;
+    CManifestArena &operator=(const CManifestArena &) = delete;
+
+    std::string_view store(const char *data, size_t length);
+
+    /**
+     * @brief store the concatenation of both strings, for URLs that are split in the manifest
+     */
+    std::string_view store(std::string_view first, std::string_view second);
+
+    template <typename T> std::span<T> allocate(size_t count)
+    {
+        static_assert(std::is_trivially_destructible_v<T>, "the arena doesn't run destructors");
+
+        if (count == 0)
+        {
+            return {};
+        }
+
+        auto items = static_cast<T *>(this->allocate(count * sizeof(T), alignof(T)));
+        for (size_t i = 0; i < count; i++)
+        {
+            new (&items[i]) T();
+        }
+
+        return {items, count};
+    }
+
+    template <typename T> std::span<const T> copy(std::span<const T> items)
+    {
+        auto result = this->allocate<T>(items.size());
+        std::copy(items.begin(), items.end(), result.begin());
+
+        return result;
+    }
+
+    /**
+     * @return bytes allocated, including what is left unused at the end of the chunks
+     */
+    [[nodiscard]] size_t getSize() const;
+};
+
+} // namespace Fri3d::Apps::Ota
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "fri3d_private/firmware.hpp"
+#include "fri3d_private/json_reader.hpp"
+
+namespace Fri3d::Apps::Ota
+{
+
+/**
+ * @brief streaming parser for the versions manifest
+ *
+ * The manifest is fed in parts as it is downloaded and every firmware is handed out as soon as it is complete.
+ */
+class IManifestParser
+{
+public:
+    typedef std::function<void(CFirmware &&firmware)> COnFirmware;
+
+    virtual ~IManifestParser() = default;
+
+    /**
+     * @brief parse the next part of the manifest
+     *
+     * @returns false if the manifest is invalid
+     */
+    virtual bool feed(const char *data, size_t length) = 0;
+
+    /**
+     * @return true when the complete manifest was parsed
+     */
+    [[nodiscard]] virtual bool isDone() const = 0;
+
+    /**
+     * @return number of firmwares handed out
+     */
+    [[nodiscard]] virtual size_t getFirmwareCount() const = 0;
+};
+
+/**
+ * @brief parser for the JSON versions manifest
+ *
+ * The strings and lists of the firmwares go to an arena they share. Besides that and the firmware being built, memory
+ * use is fixed: nothing else of the manifest is kept.
+ */
+class CManifestParser : public IManifestParser, private IJsonHandler
+{
+private:
+    // What the current value in the document is part of
+    enum Context
+    {
+        Root,
+        Firmware,
+        Images,
+        Image,
+        Mirrors,
+        Blocks,
+        Patches,
+        Patch,
+        // Anything we don't know, including everything nested in it
+        Skip
+    };
+
+    static const size_t MaxKeySize = 16;
+
+    COnFirmware onFirmware;
+    CJsonReader reader;
+
+    std::array<Context, CJsonReader::MaxDepth> contexts;
+    size_t depth;
+
+    // Key of the current value, truncated keys are never known ones
+    std::array<char, MaxKeySize> key;
+
+    std::shared_ptr<CManifestArena> arena;
+
+    CFirmware firmware;
+    bool hasFirmwareVersion;
+    bool hasImages;
+
+    CImage image;
+    bool validType;
+    bool hasImageVersion;
+    bool hasUrl;
+    bool validEncoding;
+    bool hasBlockSize;
+    bool hasBlocks;
+    bool validBlocks;
+
+    // Lists of the image being built, they only go to the arena when the image is kept
+    std::vector<std::string_view> mirrors;
+    std::vector<CHash> blocks;
+    std::vector<CImage::CPatch> patches;
+
+    CImage::CPatch patch;
+    // Bit mask of the required fields of the patch that were found
+    uint32_t patchFields;
+    bool validPatch;
+
+    size_t firmwareCount;
+
+    [[nodiscard]] Context getContext() const;
+    [[nodiscard]] bool isKey(const char *name) const;
+    void enter(Context context);
+
+    /**
+     * @brief handle a value of the wrong type for the current key
+     */
+    void invalidate();
+
+    void startFirmware();
+    void endFirmware();
+    void startImage();
+    void endImage();
+    void startPatch();
+    void endPatch();
+
+    void onStartObject() override;
+    void onEndObject() override;
+    void onStartArray() override;
+    void onEndArray() override;
+    void onKey(const char *key, size_t length) override;
+    void onString(const char *value, size_t length) override;
+    void onNumber(double value) override;
+    void onBool(bool value) override;
+    void onNull() override;
+
+public:
+    /**
+     * @param onFirmware called for every valid firmware in the manifest, in document order
+     */
+    explicit CManifestParser(COnFirmware onFirmware);
+
+    bool feed(const char *data, size_t length) override;
+    [[nodiscard]] bool isDone() const override;
+    [[nodiscard]] size_t getFirmwareCount() const override;
+
+    static bool parseHash(const char *text, CHash &hash);
+};
+
+} // namespace Fri3d::Apps::Ota
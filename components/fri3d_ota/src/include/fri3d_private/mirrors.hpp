@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "fri3d_application/hardware_http.hpp"
+
+namespace Fri3d::Apps::Ota
+{
+
+/**
+ * @brief the servers an image can be downloaded from, fastest first
+ *
+ * The url of the image is always a candidate, the mirrors of the image serve the same file name under their own base
+ * URL. select() probes every candidate with a one byte Range request and orders them by latency, plus the time the
+ * rest of the image would take at the throughput measured for them earlier. While downloading, a candidate that stays
+ * below FRI3D_OTA_MIRROR_MIN_RATE is given up for the next one, which continues with a Range request. Candidates the
+ * probe couldn't reach are skipped, after the last one the download goes back to the best.
+ *
+ * Statistics per base URL are kept for as long as the badge runs, see printStatistics().
+ */
+class CMirrors
+{
+private:
+    struct CCandidate
+    {
+        std::string url;
+        // Where the statistics are kept, the url up to and including the last '/'
+        std::string base;
+        bool reachable;
+        uint32_t latency;
+    };
+
+    struct CStatistics
+    {
+        uint32_t probes;
+        // Of the last probe, in ms
+        uint32_t latency;
+        uint64_t bytes;
+        // Time spent on requests, in us
+        int64_t duration;
+        // Requests that failed or were given up because they were too slow
+        uint32_t failures;
+    };
+
+    static std::mutex statisticsMutex;
+    static std::map<std::string, CStatistics> statistics;
+
+    std::vector<CCandidate> candidates;
+    size_t current;
+
+    int64_t requestStart;
+    int64_t windowStart;
+    size_t windowBytes;
+
+    static std::string getBase(const std::string &url);
+
+    /**
+     * @return bytes per second received from the base earlier, 0 when unknown
+     */
+    static uint32_t getThroughput(const std::string &base);
+
+    bool probe(Application::Hardware::IHttp &http, CCandidate &candidate);
+
+    // Another reachable candidate than the current one
+    [[nodiscard]] bool hasAlternative() const;
+
+public:
+    /**
+     * @param url where the image is published
+     * @param mirrors base URLs of the mirrors
+     */
+    CMirrors(std::string_view url, std::span<const std::string_view> mirrors);
+
+    /**
+     * @brief order the candidates, fastest first. Does nothing without mirrors.
+     *
+     * @param size of the download, negative when unknown
+     */
+    void select(Application::Hardware::IHttp &http, int size);
+
+    [[nodiscard]] const std::string &getUrl() const;
+
+    /**
+     * @brief continue with the next reachable candidate after the current one failed
+     *
+     * @returns false if there is none left, the best candidate is current again then and is retried after a pause
+     */
+    bool failover();
+
+    /**
+     * @brief a request to the current candidate is sent
+     */
+    void start();
+
+    /**
+     * @brief data of the current request was received
+     *
+     * @returns false when the candidate is too slow and there is another one to continue with
+     */
+    bool onReceived(size_t length);
+
+    /**
+     * @brief the current request ended
+     */
+    void finish(bool success);
+
+    /**
+     * @brief print the statistics of all base URLs to the console
+     */
+    static void printStatistics();
+};
+
+} // namespace Fri3d::Apps::Ota
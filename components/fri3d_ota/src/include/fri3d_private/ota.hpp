@@ -7,6 +7,8 @@
 #include "fri3d_application/app.hpp"
 #include "fri3d_application/thread.hpp"
 #include "fri3d_private/firmware_fetcher.hpp"
+#include "fri3d_private/prefetcher.hpp"
+#include "fri3d_private/update_job.hpp"
 
 namespace Fri3d::Apps::Ota
 {
@@ -20,6 +22,8 @@ EVENT_CREATE_TYPES_START()
     UpdatePreview,
     UpdateFirmware,
     CancelUpdate,
+    UpdateFinished,
+    Restart,
 EVENT_CREATE_TYPES_END()
 EVENT_CREATE_END();
 // clang-format on
@@ -31,8 +35,11 @@ private:
     CVersion currentFirmware;
     lv_obj_t *screen;
     CFirmwareFetcher fetcher;
+    CPrefetcher prefetcher;
     CFirmware selectedFirmware;
     bool showBeta;
+    bool updateInBackground;
+    CUpdateJob job;
 
     std::optional<bool> updateMain;
     std::optional<bool> updateMicroPython;
@@ -42,6 +49,7 @@ private:
     void hide();
     void showVersions();
     void showUpdate();
+    void showJob();
 
     static void onClickExit(lv_event_t *event);
     static void onClickFetchVersions(lv_event_t *event);
@@ -50,14 +58,20 @@ private:
     static void onClickUpdate(lv_event_t *event);
     static void onVersionChange(lv_event_t *event);
     static void onCheckboxBetaToggle(lv_event_t *event);
+    static void onCheckboxBackgroundToggle(lv_event_t *event);
+    static void onClickRestart(lv_event_t *event);
 
     void onEvent(const OtaEvent &event) override;
 
     std::string drop_down_options; // all the options from available_versions concatenated with '\n' as separator
 
+    void loadCurrentVersions();
+
     bool ensureWifi();
+    void waitForSlot();
     void fetchFirmwares();
-    void updateFirmware();
+    void updateFirmware(bool background);
+    void finishUpdate(bool result);
     void handleNewAppVersion(uint16_t activeVersion);
 
     static void onImageCheckboxToggle(lv_event_t *event);
@@ -68,15 +82,19 @@ private:
         bool enabled = true);
 
     void onSystemStart() override;
+    void onSystemStop() override;
 
 public:
     COta();
 
+    void preload() override;
     void init() override;
     void deinit() override;
 
     [[nodiscard]] const char *getName() const override;
     [[nodiscard]] bool getVisible() const override;
+    [[nodiscard]] bool getReclaimable() const override;
+    [[nodiscard]] bool getHighlighted() const override;
 
     void activate() override;
     void deactivate() override;
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_partition.h"
+
+namespace Fri3d::Apps::Ota
+{
+
+/**
+ * @brief where the flash engine writes an image to
+ *
+ * Like NOR flash, data can only be written to erased areas. The engine erases what it is about to write itself.
+ */
+class IPartition
+{
+public:
+    virtual ~IPartition() = default;
+
+    [[nodiscard]] virtual const char *getLabel() const = 0;
+    [[nodiscard]] virtual size_t getSize() const = 0;
+    [[nodiscard]] virtual size_t getEraseSize() const = 0;
+
+    /**
+     * @brief prepare for writing, nothing is erased yet
+     */
+    virtual bool begin() = 0;
+
+    virtual bool read(size_t offset, void *data, size_t length) = 0;
+
+    /**
+     * @param offset and length have to be aligned to the erase size
+     */
+    virtual bool erase(size_t offset, size_t length) = 0;
+
+    virtual bool write(size_t offset, const void *data, size_t length) = 0;
+
+    /**
+     * @brief finish writing and check what was written, as far as the partition knows how
+     */
+    virtual bool end() = 0;
+};
+
+/**
+ * @brief a data partition in flash
+ */
+class CFlashPartition : public IPartition
+{
+protected:
+    const esp_partition_t &partition;
+
+public:
+    explicit CFlashPartition(const esp_partition_t &partition);
+
+    [[nodiscard]] const char *getLabel() const override;
+    [[nodiscard]] size_t getSize() const override;
+    [[nodiscard]] size_t getEraseSize() const override;
+
+    bool begin() override;
+    bool read(size_t offset, void *data, size_t length) override;
+    bool erase(size_t offset, size_t length) override;
+    bool write(size_t offset, const void *data, size_t length) override;
+    bool end() override;
+};
+
+/**
+ * @brief an app partition in flash, which can check the app image once it is written
+ *
+ * The image is checked with esp_image_verify(), the same check esp_ota_end() does. esp_ota_begin() itself is not
+ * used: it either erases the complete partition or only while writing sequentially, which rules out skipping the blocks
+ * that didn't change and resuming an interrupted download.
+ */
+class CAppPartition : public CFlashPartition
+{
+private:
+    bool verifyImage;
+
+public:
+    /**
+     * @param verifyImage check the image in end(), not needed when the image hash was checked or when the partition is
+     * activated afterwards, which checks it again
+     */
+    CAppPartition(const esp_partition_t &partition, bool verifyImage);
+
+    bool end() override;
+};
+
+} // namespace Fri3d::Apps::Ota
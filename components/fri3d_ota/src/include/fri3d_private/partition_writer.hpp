@@ -0,0 +1,165 @@
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "fri3d_private/image_verifier.hpp"
+#include "fri3d_private/partition.hpp"
+
+namespace Fri3d::Apps::Ota
+{
+
+/**
+ * @brief limits on how a CPartitionWriter uses the flash
+ *
+ * Reads from flash, and so all code and constant data that is not in RAM, stall while it is erased or written. The
+ * defaults are the fastest, lower values keep the UI running smoother.
+ */
+struct CFlashThrottle
+{
+    // Percentage of the time the flash may be busy, below 100 the writer pauses after every erase and write
+    int dutyCycle = 100;
+    // Largest part erased in one go, a 64 KB block erase takes a few times longer than a 4 KB sector
+    size_t eraseSize = 64 * 1024;
+};
+
+/**
+ * @brief writes a stream of buffers to a partition from a separate thread
+ *
+ * While the caller downloads into one buffer, the other one is written to flash. Data is written to regions of the
+ * partition, which are erased in blocks just ahead of the write cursor so erasing overlaps with the download as well.
+ * Nothing outside a region is ever erased. The thread runs at the priority of the caller.
+ */
+class CPartitionWriter
+{
+public:
+    struct CBuffer
+    {
+        std::vector<uint8_t> data;
+        size_t length;
+        // Where to write the data and where the region ends, set by acquire()
+        size_t offset;
+        size_t regionEnd;
+    };
+
+    typedef std::function<void(size_t offset)> COnWritten;
+
+    struct CStatistics
+    {
+        // All times in microseconds, measured on the writer thread
+        uint32_t erase;
+        uint32_t write;
+        // Time the writer was waiting for data
+        uint32_t idle;
+        // Time the writer paused to keep the duty cycle
+        uint32_t rest;
+        // Bytes
+        size_t erased;
+        size_t written;
+    };
+
+private:
+    IPartition &partition;
+
+    // The region currently being written, only accessed by the caller
+    size_t regionEnd;
+    size_t position;
+    // Buffer being filled by write()
+    CBuffer *current;
+
+    // Only accessed by the writer thread
+    size_t erased;
+    size_t written;
+    size_t eraseLimit;
+
+    std::array<CBuffer, 2> buffers;
+    std::deque<CBuffer *> empty;
+    std::deque<CBuffer *> full;
+    std::mutex buffersMutex;
+    std::condition_variable buffersChanged;
+
+    bool finishing;
+    bool failed;
+
+    CStatistics statistics;
+    COnWritten onWritten;
+    IVerifier *verifier;
+    CFlashThrottle throttle;
+
+    std::thread thread;
+    void run();
+
+    bool ensureErased(size_t end);
+
+    /**
+     * @brief pause after the flash was busy for the given time, so it is busy at most the duty cycle of the throttle
+     */
+    void rest(int64_t busy);
+
+public:
+    /**
+     * @param onWritten called from the writer thread with the offset up to which the region is written
+     * @param verifier gets all data from the writer thread once it is written, so hashing overlaps with the download
+     * @param throttle how much the writer may stall code running from flash
+     */
+    explicit CPartitionWriter(
+        IPartition &partition,
+        COnWritten onWritten = nullptr,
+        IVerifier *verifier = nullptr,
+        const CFlashThrottle &throttle = {});
+    ~CPartitionWriter();
+
+    CPartitionWriter(const CPartitionWriter &) = delete;
+    CPartitionWriter &operator=(const CPartitionWriter &) = delete;
+
+    /**
+     * @brief start writing a new region, the following buffers are written from its start onwards
+     *
+     * @param start offset in the partition, has to be aligned to a sector
+     * @param length length of the data that will be written, or a negative value when unknown
+     *
+     * @return false if the region does not fit in the partition
+     */
+    bool beginRegion(size_t start, int length);
+
+    /**
+     * @brief wait for an empty buffer to download into
+     *
+     * @return the buffer, or nullptr when writing failed
+     */
+    CBuffer *acquire();
+
+    /**
+     * @brief hand a filled buffer over to the writer, an empty buffer is returned to the pool
+     */
+    void submit(CBuffer *buffer);
+
+    /**
+     * @brief copy data into the buffers, for when the data can't be downloaded into them directly
+     *
+     * @return false when writing failed
+     */
+    bool write(const uint8_t *data, size_t length);
+
+    /**
+     * @brief submit the data collected by write() that does not fill a complete buffer yet
+     */
+    void flush();
+
+    /**
+     * @brief wait for all submitted buffers to be written
+     *
+     * @return true if everything was written successfully
+     */
+    bool finish();
+
+    [[nodiscard]] const CStatistics &getStatistics() const;
+};
+
+} // namespace Fri3d::Apps::Ota
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "fri3d_private/decoder.hpp"
+
+namespace Fri3d::Apps::Ota
+{
+
+/**
+ * @brief streaming application of a binary delta patch
+ *
+ * The patch rebuilds the target image from parts of a source image and new data. All values are little endian:
+ *
+ *     header:  "F3DP"  u32 source size  u32 target size
+ *     COPY:    0x01    u32 source offset  u32 length
+ *     DATA:    0x02    u32 length  <length bytes>
+ *     END:     0x00
+ *
+ * Apart from logging this class does not depend on ESP-IDF: the source and the output are provided as callbacks, so it
+ * works with a flash partition on the badge as well as with plain files.
+ */
+class CPatcher : public IDecoder
+{
+public:
+    typedef std::function<bool(size_t offset, uint8_t *data, size_t length)> CSource;
+
+private:
+    enum State
+    {
+        Header,
+        Operation,
+        CopyArguments,
+        DataLength,
+        Data,
+        Done,
+        Failed
+    };
+
+    static const size_t HeaderSize = 12;
+    static const size_t CopyArgumentsSize = 8;
+    static const size_t DataLengthSize = 4;
+
+    CSource source;
+    size_t sourceSize;
+    size_t targetSize;
+    size_t written;
+
+    State state;
+    // Collects the fixed size fields, which can be split over multiple calls to feed()
+    std::array<uint8_t, HeaderSize> field;
+    size_t fieldLength;
+    size_t remaining;
+
+    std::vector<uint8_t> buffer;
+
+    static uint32_t readU32(const uint8_t *data);
+
+    size_t getFieldSize() const;
+    bool collect(const uint8_t *&data, size_t &length);
+    bool handleField(const COutput &output);
+    bool copy(size_t offset, size_t length, const COutput &output);
+    bool fail(const char *reason);
+
+public:
+    /**
+     * @param source reads from the source image
+     * @param sourceSize size of the source image, COPY operations can't go beyond it
+     */
+    CPatcher(CSource source, size_t sourceSize);
+
+    /**
+     * @brief apply the next part of the patch
+     *
+     * @param output called with every part of the target image, return false to abort
+     *
+     * @returns false if the patch is invalid or the source or output failed
+     */
+    bool feed(const uint8_t *data, size_t length, const COutput &output) override;
+
+    /**
+     * @return true when the complete patch was applied
+     */
+    [[nodiscard]] bool isDone() const override;
+
+    /**
+     * @return size of the target image, 0 until the header was read
+     */
+    [[nodiscard]] size_t getTargetSize() const;
+};
+
+} // namespace Fri3d::Apps::Ota
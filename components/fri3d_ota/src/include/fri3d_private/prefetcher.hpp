@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#include "fri3d_application/hardware_manager.hpp"
+#include "fri3d_application/nvs_manager.hpp"
+#include "fri3d_private/version.hpp"
+
+namespace Fri3d::Apps::Ota
+{
+
+/**
+ * @brief refreshes the cached versions manifest in the background while wifi is connected
+ *
+ * The first check is shortly after boot, later ones every FRI3D_OTA_PREFETCH_INTERVAL minutes. Both are spread
+ * randomly, so badges that were turned on together don't keep asking the server at the same moment. Wifi is never
+ * turned on for this and no checks are done while paused.
+ */
+class CPrefetcher
+{
+private:
+    Application::IHardwareManager *hardware;
+    Application::INvsManager *nvs;
+    CVersion current;
+
+    std::thread thread;
+    std::mutex stoppingMutex;
+    std::condition_variable stoppingChanged;
+    bool stopping;
+
+    std::atomic<bool> paused;
+    std::atomic<bool> updateAvailable;
+    // Rollout slot of the available update
+    std::atomic<int64_t> updateSlot;
+    // Time of the last successful check, 0 before the first one
+    std::atomic<int64_t> lastCheck;
+
+    /**
+     * @return a random duration between base and base + spread
+     */
+    static std::chrono::milliseconds jitter(std::chrono::milliseconds base, std::chrono::milliseconds spread);
+
+    /**
+     * @return false when the prefetcher is stopped while sleeping
+     */
+    bool sleep(std::chrono::milliseconds duration);
+
+    bool check();
+    void run();
+
+public:
+    CPrefetcher();
+    ~CPrefetcher();
+
+    CPrefetcher(const CPrefetcher &) = delete;
+    CPrefetcher &operator=(const CPrefetcher &) = delete;
+
+    /**
+     * @param current version of the running firmware, to compare the newest release against
+     */
+    void start(
+        Application::IHardwareManager &hardware,
+        Application::INvsManager &nvs,
+        const CVersion &current);
+    void stop();
+
+    /**
+     * @brief skip checks, for example while the OTA app itself is in use
+     */
+    void setPaused(bool value);
+
+    /**
+     * @return true if the last check found an official release newer than the running firmware and the rollout slot
+     * of this badge for it has started
+     */
+    [[nodiscard]] bool getUpdateAvailable() const;
+
+    /**
+     * @return true if the cached manifest was checked with the server during the last interval and is still what the
+     * server sent, false when the last check could not store it
+     */
+    [[nodiscard]] bool getRecent() const;
+};
+
+} // namespace Fri3d::Apps::Ota
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <chrono>
+
+#include "fri3d_application/hardware_http.hpp"
+
+namespace Fri3d::Apps::Ota
+{
+
+/**
+ * @brief decides when and whether to try a request to the update server again
+ *
+ * After a failure the wait doubles from FRI3D_OTA_RETRY_DELAY up to FRI3D_OTA_RETRY_MAX_DELAY, each time moved randomly
+ * so badges that failed together don't retry together. A Retry-After from the server is waited out first, unless it is
+ * longer than FRI3D_OTA_RETRY_MAX_DELAY, then we give up. Only failures in a row count, reset() starts over as soon as
+ * a request gets somewhere.
+ */
+class CRetryPolicy
+{
+private:
+    int retries;
+    int attempt;
+    // Requested by the server in the last response, 0 if it didn't
+    std::chrono::milliseconds retryAfter;
+
+    [[nodiscard]] std::chrono::milliseconds getDelay() const;
+
+public:
+    /**
+     * @param retries number of attempts after the first one
+     */
+    explicit CRetryPolicy(int retries = CONFIG_FRI3D_OTA_RETRIES);
+
+    /**
+     * @brief watch the response headers that update() needs, before the first request is sent
+     */
+    static void watch(Application::Hardware::CHttpClient &client);
+
+    /**
+     * @return true if the server is overloaded and asks to come back later (429 and 503)
+     */
+    static bool isBusy(int status);
+
+    /**
+     * @brief take the Date and Retry-After headers of the last response into account
+     */
+    void update(const Application::Hardware::CHttpClient &client);
+
+    /**
+     * @brief sleep until the next attempt
+     *
+     * @param what shown in the log
+     *
+     * @returns false when there are no attempts left or the server asked us to wait too long
+     */
+    bool wait(const char *what);
+
+    /**
+     * @brief start over with the first delay and all attempts, after a request made progress
+     */
+    void reset();
+
+    [[nodiscard]] int getAttempt() const;
+};
+
+} // namespace Fri3d::Apps::Ota
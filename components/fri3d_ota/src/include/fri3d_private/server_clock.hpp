@@ -0,0 +1,46 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace Fri3d::Apps::Ota
+{
+
+/**
+ * @brief the time of the update server, as learned from the Date header of its responses
+ *
+ * The badge has no clock of its own, so anything the server schedules in absolute time (Retry-After dates, rollout
+ * slots) is measured against this. The last Date header seen is kept together with the uptime it was received at.
+ */
+class CServerClock
+{
+private:
+    // Server time minus uptime, in seconds
+    static std::atomic<int64_t> offset;
+    static std::atomic<bool> known;
+
+public:
+    /**
+     * @brief parse an IMF-fixdate as sent in HTTP headers, "Sun, 06 Nov 1994 08:49:37 GMT"
+     *
+     * @param[out] time seconds since the epoch
+     *
+     * @returns false if the text is not a valid date
+     */
+    static bool parse(const std::string &text, int64_t &time);
+
+    /**
+     * @brief set the clock from the Date header of a response, invalid dates are ignored
+     */
+    static void update(const std::string &date);
+
+    /**
+     * @param[out] time current server time in seconds since the epoch
+     *
+     * @returns false if no server has told us the time yet
+     */
+    static bool now(int64_t &time);
+};
+
+} // namespace Fri3d::Apps::Ota
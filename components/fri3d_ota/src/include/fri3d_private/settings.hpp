@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "fri3d_application/settings.hpp"
+
+namespace Fri3d::Apps::Ota::Settings
+{
+
+// These live in the system namespace, as the other firmwares read them
+
+/**
+ * @brief number of the OTA partition we booted from, MicroPython can only read i32
+ */
+extern Application::CSetting<int32_t> bootPartition;
+
+/**
+ * @brief version of the OTA application, used to force an update after changes to the partition layout or images
+ */
+extern Application::CSetting<uint16_t> appVersion;
+
+// Versions of the other firmwares, as flashed by us
+extern Application::CSetting<std::string> microPython;
+extern Application::CSetting<std::string> retroGoLauncher;
+extern Application::CSetting<std::string> retroGoCore;
+extern Application::CSetting<std::string> retroGoPRBoom;
+extern Application::CSetting<std::string> vfs;
+
+// These are private to us
+
+/**
+ * @brief namespace of the settings only used by the OTA app
+ */
+inline constexpr const char *OTA_NAMESPACE = "fri3d.ota";
+
+// Progress of an interrupted download of a complete image, so it can be resumed after a reboot
+extern Application::CSetting<std::string> resumeUrl;
+extern Application::CSetting<std::string> resumePartition;
+extern Application::CSetting<int32_t> resumeSize;
+// Bytes of the image that are written to flash, always a multiple of the erase size
+extern Application::CSetting<int32_t> resumeOffset;
+
+/**
+ * @brief key of the blob with the last versions manifest, as it was downloaded
+ */
+inline constexpr const char *MANIFEST_KEY = "manifest";
+
+// Validators the server sent with the cached manifest, for conditional requests
+extern Application::CSetting<std::string> manifestETag;
+extern Application::CSetting<std::string> manifestModified;
+
+} // namespace Fri3d::Apps::Ota::Settings
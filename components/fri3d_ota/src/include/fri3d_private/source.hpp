@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+namespace Fri3d::Apps::Ota
+{
+
+/**
+ * @brief where the flash engine reads an image, patch or compressed stream from
+ *
+ * Sources recover from transient errors themselves, a read only fails when there is no way to continue.
+ */
+class ISource
+{
+public:
+    virtual ~ISource() = default;
+
+    /**
+     * @brief start reading from offset onwards
+     *
+     * @param length number of bytes that will be read, negative to read until the end
+     *
+     * @returns false if the data can't be read
+     */
+    virtual bool open(size_t offset, int length) = 0;
+
+    /**
+     * @return number of bytes read, 0 at the end of the data or negative on an error
+     */
+    virtual int read(uint8_t *data, size_t length) = 0;
+
+    virtual void close() = 0;
+
+    /**
+     * @return what is read, for logging
+     */
+    [[nodiscard]] virtual const char *getName() const = 0;
+};
+
+/**
+ * @brief reads from a buffer in memory, which has to stay around as long as the source
+ */
+class CMemorySource : public ISource
+{
+private:
+    const uint8_t *data;
+    size_t size;
+    size_t position;
+    size_t end;
+
+public:
+    CMemorySource(const uint8_t *data, size_t size);
+
+    bool open(size_t offset, int length) override;
+    int read(uint8_t *data, size_t length) override;
+    void close() override;
+    [[nodiscard]] const char *getName() const override;
+};
+
+/**
+ * @brief reads from a file, on the SD card or VFS of the badge or on a host
+ */
+class CFileSource : public ISource
+{
+private:
+    std::string path;
+    FILE *file;
+    // Bytes left to read, negative until the end of the file
+    int remaining;
+
+public:
+    explicit CFileSource(std::string path);
+    ~CFileSource() override;
+
+    CFileSource(const CFileSource &) = delete;
+    CFileSource &operator=(const CFileSource &) = delete;
+
+    bool open(size_t offset, int length) override;
+    int read(uint8_t *data, size_t length) override;
+    void close() override;
+    [[nodiscard]] const char *getName() const override;
+};
+
+} // namespace Fri3d::Apps::Ota
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "fri3d_application/hardware_http.hpp"
+#include "fri3d_application/lvgl/status_indicator.hpp"
+#include "fri3d_application/lvgl/wait_dialog.hpp"
+#include "fri3d_private/firmware.hpp"
+#include "fri3d_private/flasher.hpp"
+
+namespace Fri3d::Apps::Ota
+{
+
+/**
+ * @brief shows the progress of an update in the foreground
+ */
+class CDialogStatus : public IFlashStatus
+{
+private:
+    Application::LVGL::CWaitDialog &dialog;
+
+public:
+    explicit CDialogStatus(Application::LVGL::CWaitDialog &dialog);
+
+    void setStatus(const char *status) override;
+    void setProgress(float value) override;
+};
+
+/**
+ * @brief flashes the selected images of a release, either right away or as a job in the background
+ *
+ * In the background the job runs just above idle, keeps the flash busy at most FRI3D_OTA_BACKGROUND_DUTY percent of
+ * the time and erases at most FRI3D_OTA_BACKGROUND_ERASE_SIZE in one go, so the launcher and other apps stay usable.
+ * A status indicator over every screen shows its progress.
+ * The job never restarts the badge, that is left to the user.
+ */
+class CUpdateJob
+{
+public:
+    enum State
+    {
+        Idle,
+        Running,
+        Finished,
+        Failed,
+    };
+
+    // The images to flash, Retro-Go covers all of its images
+    struct CSelection
+    {
+        bool main;
+        bool microPython;
+        bool retroGo;
+        bool vfs;
+    };
+
+    /**
+     * @brief called from the thread of the job once all images are flashed, stop() waits for it to return
+     */
+    typedef std::function<void(bool result)> COnFinished;
+
+private:
+    // Shows the progress in the indicator, the status texts don't fit
+    class CIndicatorStatus : public IFlashStatus
+    {
+    private:
+        Application::LVGL::CStatusIndicator &indicator;
+
+    public:
+        explicit CIndicatorStatus(Application::LVGL::CStatusIndicator &indicator);
+
+        void setStatus(const char *status) override;
+        void setProgress(float value) override;
+    };
+
+    Application::Hardware::IHttp *http;
+    CFirmware firmware;
+    CSelection selection;
+    COnFinished onFinished;
+
+    Application::LVGL::CStatusIndicator indicator;
+
+    std::thread thread;
+    std::mutex stoppingMutex;
+    std::condition_variable stoppingChanged;
+    bool stopping;
+
+    std::atomic<State> state;
+
+    /**
+     * @return false when the job is stopped before the rollout slot of this badge started
+     */
+    bool waitForSlot();
+
+    void run();
+
+public:
+    CUpdateJob();
+    ~CUpdateJob();
+
+    CUpdateJob(const CUpdateJob &) = delete;
+    CUpdateJob &operator=(const CUpdateJob &) = delete;
+
+    /**
+     * @brief flash the selected images of the firmware on the calling thread
+     *
+     * @returns true if all images were flashed successfully
+     */
+    static bool flash(
+        Application::Hardware::IHttp &http,
+        const CFirmware &firmware,
+        const CSelection &selection,
+        IFlashStatus &status,
+        const CFlashThrottle &throttle = {});
+
+    /**
+     * @brief flash the selected images of the firmware in the background, after the rollout slot of this badge
+     *
+     * @return false if a job is already running
+     */
+    bool start(
+        Application::Hardware::IHttp &http,
+        const CFirmware &firmware,
+        const CSelection &selection,
+        COnFinished onFinished);
+
+    /**
+     * @brief cancel the job if it is still waiting for its slot, otherwise wait for it to finish
+     *
+     * A partition that is half written can't be used, so flashing is never interrupted.
+     */
+    void stop();
+
+    /**
+     * @brief forget the result of the last job and hide the indicator
+     */
+    void reset();
+
+    [[nodiscard]] State getState() const;
+};
+
+} // namespace Fri3d::Apps::Ota
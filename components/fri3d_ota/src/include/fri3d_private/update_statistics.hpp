@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "fri3d_private/image_verifier.hpp"
+#include "fri3d_private/partition_writer.hpp"
+
+namespace Fri3d::Apps::Ota
+{
+
+/**
+ * @brief where the time of a download goes on the HTTP side, all times in microseconds
+ */
+struct CDownloadStatistics
+{
+    // Opening requests: the TCP and TLS handshakes on a new connection, only sending the request on a reused one
+    int64_t connect;
+    // Waiting for the status and headers of the responses
+    int64_t response;
+    // Reading the bodies, which includes decrypting them
+    int64_t receive;
+    // Pausing before a retry, after an error or for a busy server
+    int64_t backoff;
+    size_t received;
+    uint32_t requests;
+
+    CDownloadStatistics &operator+=(const CDownloadStatistics &other);
+};
+
+/**
+ * @brief where the time of an update goes, per stage and summed over its images, all times in microseconds
+ *
+ * Downloading, decoding and showing the progress happen on the updating thread, while the writer erases, writes and
+ * hashes on its own. The stages of the two threads overlap, so they don't add up to the total: the slower side decides
+ * it, and the time the writer waited for data shows how much slower the download was.
+ */
+struct CUpdateStatistics
+{
+    uint32_t images;
+    int64_t total;
+    // Reading the partition before the download, to find the blocks that changed or an image that is up to date
+    int64_t check;
+    CDownloadStatistics download;
+    int64_t decompress;
+    // Writer thread
+    int64_t erase;
+    int64_t write;
+    int64_t hash;
+    int64_t idle;
+    int64_t rest;
+    size_t erased;
+    size_t written;
+    size_t hashed;
+    // Updating the progress in the dialog or indicator
+    int64_t ui;
+    uint32_t progressUpdates;
+
+    /**
+     * @brief add the statistics of the writer and the verifier of one image
+     */
+    void add(const CPartitionWriter::CStatistics &writer, const CImageVerifier::CStatistics &verifier);
+
+    CUpdateStatistics &operator+=(const CUpdateStatistics &other);
+
+    /**
+     * @brief log the time of every stage, with the throughput of the ones that move data
+     */
+    void print(const char *title) const;
+};
+
+} // namespace Fri3d::Apps::Ota
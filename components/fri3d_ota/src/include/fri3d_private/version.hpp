@@ -1,31 +1,71 @@
 #pragma once
 
-#include <map>
-#include <string>
-#include <vector>
-
-#include "semver.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
 
 namespace Fri3d::Apps::Ota
 {
 
+/**
+ * @brief a semantic version, kept inline so copies don't allocate
+ *
+ * Major, minor and patch are packed in one integer together with a flag for releases, which come after their
+ * prereleases. Two versions are ordered with a single comparison of these keys, unless they only differ in their
+ * prerelease. Metadata is kept in the text but, as semver says, not compared.
+ */
 struct CVersion
 {
-    // Note that there is no synchronization between the two members
-    std::string text;
-    semver_t semver;
+    // The same as the version in the app description of ESP-IDF, including the terminating NUL
+    static const size_t MaxLength = 32;
+
+private:
+    std::array<char, MaxLength> text;
+    // Major, minor and patch, saturated to fit, and the release flag
+    uint64_t key;
+    uint32_t major;
+    uint32_t minor;
+    uint32_t patch;
+    // Position of the prerelease in text, the length is 0 when there is none
+    uint8_t prereleaseStart;
+    uint8_t prereleaseLength;
+
+    void setText(const char *version);
+    void setParts(uint32_t major, uint32_t minor, uint32_t patch);
+    bool parse();
+    [[nodiscard]] bool isLarge() const;
+
+    static int comparePrerelease(const CVersion &l, const CVersion &r);
 
+public:
     CVersion();
-    CVersion(const CVersion &other);
+
+    /**
+     * @param version is truncated to MaxLength - 1 characters
+     */
     explicit CVersion(const char *version);
 
-    ~CVersion();
+    /**
+     * @brief a version that was already parsed, for example by the tool that wrote the manifest
+     *
+     * @param prerelease can be nullptr, the same as the one in version
+     * @param metadata can be nullptr
+     */
+    CVersion(const char *version, int major, int minor, int patch, const char *prerelease, const char *metadata);
 
     [[nodiscard]] CVersion simplify() const;
-    bool empty() const;
+    [[nodiscard]] bool empty() const;
+
+    /**
+     * @return the version as it was given, always NUL terminated
+     */
+    [[nodiscard]] const char *getText() const;
+
+    /**
+     * @return negative, 0 or positive when l is older, the same or newer than r
+     */
+    static int compare(const CVersion &l, const CVersion &r);
 
-    CVersion &operator=(const CVersion &other);
-    CVersion &operator=(CVersion &&other) noexcept;
     friend bool operator<(const CVersion &l, const CVersion &r);
     friend bool operator>(const CVersion &l, const CVersion &r);
     bool operator==(const CVersion &other) const;
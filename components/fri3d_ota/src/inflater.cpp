@@ -0,0 +1,89 @@
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "fri3d_private/inflater.hpp"
+
+namespace Fri3d::Apps::Ota
+{
+
+static const char *TAG = "Fri3d::Apps::Ota::CInflater";
+
+CInflater::CInflater()
+    : decompressor(std::make_unique<tinfl_decompressor>())
+    , dictionary(TINFL_LZ_DICT_SIZE)
+    , dictionaryOffset(0)
+    , done(false)
+    , duration(0)
+{
+    esp_log_level_set(TAG, static_cast<esp_log_level_t>(LOG_LOCAL_LEVEL));
+
+    tinfl_init(this->decompressor.get());
+}
+
+bool CInflater::feed(const uint8_t *data, size_t length, const COutput &output)
+{
+    while (!this->done)
+    {
+        size_t in = length;
+        size_t out = this->dictionary.size() - this->dictionaryOffset;
+
+        auto start = esp_timer_get_time();
+
+        // The dictionary doubles as the output buffer, it wraps around when full
+        auto status = tinfl_decompress(
+            this->decompressor.get(),
+            data,
+            &in,
+            this->dictionary.data(),
+            this->dictionary.data() + this->dictionaryOffset,
+            &out,
+            TINFL_FLAG_PARSE_ZLIB_HEADER | TINFL_FLAG_COMPUTE_ADLER32 | TINFL_FLAG_HAS_MORE_INPUT);
+
+        this->duration += static_cast<uint32_t>(esp_timer_get_time() - start);
+
+        data += in;
+        length -= in;
+
+        if (out > 0 && !output(this->dictionary.data() + this->dictionaryOffset, out))
+        {
+            return false;
+        }
+
+        this->dictionaryOffset = (this->dictionaryOffset + out) & (this->dictionary.size() - 1);
+
+        if (status < TINFL_STATUS_DONE)
+        {
+            ESP_LOGE(TAG, "Corrupt compressed data (%d)", status);
+            return false;
+        }
+
+        if (status == TINFL_STATUS_DONE)
+        {
+            this->done = true;
+        }
+        else if (status == TINFL_STATUS_NEEDS_MORE_INPUT && length == 0)
+        {
+            // Wait for the next part of the stream
+            return true;
+        }
+    }
+
+    if (length > 0)
+    {
+        ESP_LOGW(TAG, "Ignoring %d bytes after the end of the compressed data", length);
+    }
+
+    return true;
+}
+
+bool CInflater::isDone() const
+{
+    return this->done;
+}
+
+uint32_t CInflater::getDuration() const
+{
+    return this->duration;
+}
+
+} // namespace Fri3d::Apps::Ota
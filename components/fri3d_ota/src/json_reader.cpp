@@ -0,0 +1,389 @@
+#include <cstdlib>
+
+#include "esp_log.h"
+
+#include "fri3d_private/json_reader.hpp"
+
+namespace Fri3d::Apps::Ota
+{
+
+static const char *TAG = "Fri3d::Apps::Ota::CJsonReader";
+
+static bool isWhitespace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static bool isNumber(char c)
+{
+    return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+}
+
+CJsonReader::CJsonReader(IJsonHandler &handler)
+    : handler(handler)
+    , state(Value)
+    , containers(0)
+    , depth(0)
+    , token()
+    , tokenLength(0)
+    , tokenIsKey(false)
+    , literal(nullptr)
+    , unicode(0)
+    , unicodeDigits(0)
+    , offset(0)
+{
+    esp_log_level_set(TAG, static_cast<esp_log_level_t>(LOG_LOCAL_LEVEL));
+}
+
+bool CJsonReader::feed(const char *data, size_t length)
+{
+    for (size_t i = 0; i < length && this->state != Failed; i++, this->offset++)
+    {
+        this->step(data[i]);
+    }
+
+    return this->state != Failed;
+}
+
+bool CJsonReader::isDone() const
+{
+    return this->state == Done;
+}
+
+bool CJsonReader::fail(const char *reason)
+{
+    ESP_LOGE(TAG, "Invalid JSON at offset %d: %s", this->offset, reason);
+    this->state = Failed;
+
+    return false;
+}
+
+bool CJsonReader::append(char c)
+{
+    // Keep room for a terminator
+    if (this->tokenLength + 1 == this->token.size())
+    {
+        return this->fail("token too long");
+    }
+
+    this->token[this->tokenLength++] = c;
+    return true;
+}
+
+bool CJsonReader::appendUnicode()
+{
+    auto code = this->unicode;
+
+    if (code < 0x80)
+    {
+        return this->append(static_cast<char>(code));
+    }
+
+    if (code < 0x800)
+    {
+        return this->append(static_cast<char>(0xc0 | (code >> 6))) &&
+               this->append(static_cast<char>(0x80 | (code & 0x3f)));
+    }
+
+    return this->append(static_cast<char>(0xe0 | (code >> 12))) &&
+           this->append(static_cast<char>(0x80 | ((code >> 6) & 0x3f))) &&
+           this->append(static_cast<char>(0x80 | (code & 0x3f)));
+}
+
+bool CJsonReader::push(bool object)
+{
+    if (this->depth == MaxDepth)
+    {
+        return this->fail("nested too deep");
+    }
+
+    if (object)
+    {
+        this->containers |= 1u << this->depth;
+    }
+    else
+    {
+        this->containers &= ~(1u << this->depth);
+    }
+
+    this->depth++;
+
+    if (object)
+    {
+        this->handler.onStartObject();
+        this->state = ObjectKeyOrEnd;
+    }
+    else
+    {
+        this->handler.onStartArray();
+        this->state = ArrayValueOrEnd;
+    }
+
+    return true;
+}
+
+bool CJsonReader::pop(bool object)
+{
+    if (this->depth == 0 || ((this->containers >> (this->depth - 1)) & 1u) != (object ? 1u : 0u))
+    {
+        return this->fail(object ? "unexpected }" : "unexpected ]");
+    }
+
+    this->depth--;
+
+    if (object)
+    {
+        this->handler.onEndObject();
+    }
+    else
+    {
+        this->handler.onEndArray();
+    }
+
+    return this->endValue();
+}
+
+bool CJsonReader::endValue()
+{
+    this->state = this->depth == 0 ? Done : AfterValue;
+    return true;
+}
+
+bool CJsonReader::endNumber()
+{
+    this->token[this->tokenLength] = '\0';
+
+    char *end;
+    double value = strtod(this->token.data(), &end);
+    if (end != this->token.data() + this->tokenLength)
+    {
+        return this->fail("invalid number");
+    }
+
+    this->handler.onNumber(value);
+    return this->endValue();
+}
+
+bool CJsonReader::endLiteral()
+{
+    switch (this->token[0])
+    {
+    case 't':
+        this->handler.onBool(true);
+        break;
+    case 'f':
+        this->handler.onBool(false);
+        break;
+    default:
+        this->handler.onNull();
+        break;
+    }
+
+    return this->endValue();
+}
+
+bool CJsonReader::step(char c)
+{
+    switch (this->state)
+    {
+    case ArrayValueOrEnd:
+        if (isWhitespace(c))
+        {
+            return true;
+        }
+        if (c == ']')
+        {
+            return this->pop(false);
+        }
+        this->state = Value;
+        return this->step(c);
+
+    case Value:
+        if (isWhitespace(c))
+        {
+            return true;
+        }
+
+        this->tokenLength = 0;
+
+        if (c == '{' || c == '[')
+        {
+            return this->push(c == '{');
+        }
+        if (c == '"')
+        {
+            this->tokenIsKey = false;
+            this->state = String;
+            return true;
+        }
+        if (c == '-' || (c >= '0' && c <= '9'))
+        {
+            this->state = Number;
+            return this->append(c);
+        }
+        if (c == 't' || c == 'f' || c == 'n')
+        {
+            this->literal = c == 't' ? "rue" : (c == 'f' ? "alse" : "ull");
+            this->state = Literal;
+            return this->append(c);
+        }
+        return this->fail("expected a value");
+
+    case ObjectKeyOrEnd:
+        if (c == '}')
+        {
+            return this->pop(true);
+        }
+        [[fallthrough]];
+
+    case ObjectKey:
+        if (isWhitespace(c))
+        {
+            return true;
+        }
+        if (c != '"')
+        {
+            return this->fail("expected a key");
+        }
+        this->tokenLength = 0;
+        this->tokenIsKey = true;
+        this->state = String;
+        return true;
+
+    case Colon:
+        if (isWhitespace(c))
+        {
+            return true;
+        }
+        if (c != ':')
+        {
+            return this->fail("expected :");
+        }
+        this->state = Value;
+        return true;
+
+    case AfterValue:
+        if (isWhitespace(c))
+        {
+            return true;
+        }
+        if (c == ',')
+        {
+            this->state = (this->containers >> (this->depth - 1)) & 1u ? ObjectKey : Value;
+            return true;
+        }
+        if (c == '}' || c == ']')
+        {
+            return this->pop(c == '}');
+        }
+        return this->fail("expected , or the end of a container");
+
+    case String:
+        if (c == '"')
+        {
+            this->token[this->tokenLength] = '\0';
+
+            if (this->tokenIsKey)
+            {
+                this->handler.onKey(this->token.data(), this->tokenLength);
+                this->state = Colon;
+                return true;
+            }
+
+            this->handler.onString(this->token.data(), this->tokenLength);
+            return this->endValue();
+        }
+        if (c == '\\')
+        {
+            this->state = StringEscape;
+            return true;
+        }
+        if (static_cast<unsigned char>(c) < 0x20)
+        {
+            return this->fail("control character in string");
+        }
+        return this->append(c);
+
+    case StringEscape:
+        this->state = String;
+        switch (c)
+        {
+        case '"':
+        case '\\':
+        case '/':
+            return this->append(c);
+        case 'b':
+            return this->append('\b');
+        case 'f':
+            return this->append('\f');
+        case 'n':
+            return this->append('\n');
+        case 'r':
+            return this->append('\r');
+        case 't':
+            return this->append('\t');
+        case 'u':
+            this->unicode = 0;
+            this->unicodeDigits = 0;
+            this->state = StringUnicode;
+            return true;
+        default:
+            return this->fail("invalid escape");
+        }
+
+    case StringUnicode:
+        if (c >= '0' && c <= '9')
+        {
+            this->unicode = (this->unicode << 4) | (c - '0');
+        }
+        else if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f')
+        {
+            this->unicode = (this->unicode << 4) | ((c | 0x20) - 'a' + 10);
+        }
+        else
+        {
+            return this->fail("invalid unicode escape");
+        }
+
+        if (++this->unicodeDigits < 4)
+        {
+            return true;
+        }
+
+        this->state = String;
+        return this->appendUnicode();
+
+    case Number:
+        if (isNumber(c))
+        {
+            return this->append(c);
+        }
+        // Numbers have no end marker, the character after it belongs to the next token
+        return this->endNumber() && this->step(c);
+
+    case Literal:
+        if (c != *this->literal)
+        {
+            return this->fail("invalid literal");
+        }
+        if (*++this->literal == '\0')
+        {
+            return this->endLiteral();
+        }
+        return true;
+
+    case Done:
+        if (isWhitespace(c))
+        {
+            return true;
+        }
+        return this->fail("data after the end of the document");
+
+    case Failed:
+        return false;
+    }
+
+    return false;
+}
+
+} // namespace Fri3d::Apps::Ota
@@ -0,0 +1,68 @@
+#include "fri3d_private/manifest_arena.hpp"
+
+namespace Fri3d::Apps::Ota
+{
+
+CManifestArena::CManifestArena()
+    : next(nullptr)
+    , available(0)
+    , size(0)
+{
+}
+
+void *CManifestArena::allocate(size_t length, size_t alignment)
+{
+    auto padding = (alignment - reinterpret_cast<uintptr_t>(this->next) % alignment) % alignment;
+
+    if (this->next == nullptr || padding + length > this->available)
+    {
+        // Large allocations get a chunk of their own, so the rest of the current one isn't wasted
+        if (length + alignment > ChunkSize / 4)
+        {
+            this->chunks.emplace_back(new uint8_t[length + alignment]);
+            this->size += length + alignment;
+
+            auto data = this->chunks.back().get();
+            return data + (alignment - reinterpret_cast<uintptr_t>(data) % alignment) % alignment;
+        }
+
+        this->chunks.emplace_back(new uint8_t[ChunkSize]);
+        this->size += ChunkSize;
+        this->next = this->chunks.back().get();
+        this->available = ChunkSize;
+
+        padding = (alignment - reinterpret_cast<uintptr_t>(this->next) % alignment) % alignment;
+    }
+
+    auto result = this->next + padding;
+    this->next += padding + length;
+    this->available -= padding + length;
+
+    return result;
+}
+
+std::string_view CManifestArena::store(const char *data, size_t length)
+{
+    auto text = static_cast<char *>(this->allocate(length + 1, 1));
+    memcpy(text, data, length);
+    text[length] = '\0';
+
+    return {text, length};
+}
+
+std::string_view CManifestArena::store(std::string_view first, std::string_view second)
+{
+    auto text = static_cast<char *>(this->allocate(first.size() + second.size() + 1, 1));
+    memcpy(text, first.data(), first.size());
+    memcpy(text + first.size(), second.data(), second.size());
+    text[first.size() + second.size()] = '\0';
+
+    return {text, first.size() + second.size()};
+}
+
+size_t CManifestArena::getSize() const
+{
+    return this->size;
+}
+
+} // namespace Fri3d::Apps::Ota
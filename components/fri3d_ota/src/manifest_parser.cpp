@@ -0,0 +1,481 @@
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+#include "esp_log.h"
+
+#include "fri3d_private/manifest_parser.hpp"
+
+namespace Fri3d::Apps::Ota
+{
+
+static const char *TAG = "Fri3d::Apps::Ota::CManifestParser";
+
+// Required fields of a patch
+static const uint32_t PATCH_FROM = 1 << 0;
+static const uint32_t PATCH_FROM_SIZE = 1 << 1;
+static const uint32_t PATCH_FROM_HASH = 1 << 2;
+static const uint32_t PATCH_URL = 1 << 3;
+static const uint32_t PATCH_REQUIRED = PATCH_FROM | PATCH_FROM_SIZE | PATCH_FROM_HASH | PATCH_URL;
+
+CManifestParser::CManifestParser(COnFirmware onFirmware)
+    : onFirmware(std::move(onFirmware))
+    , reader(*this)
+    , contexts()
+    , depth(0)
+    , key()
+    , arena(std::make_shared<CManifestArena>())
+    , hasFirmwareVersion(false)
+    , hasImages(false)
+    , validType(false)
+    , hasImageVersion(false)
+    , hasUrl(false)
+    , validEncoding(false)
+    , hasBlockSize(false)
+    , hasBlocks(false)
+    , validBlocks(false)
+    , mirrors()
+    , blocks()
+    , patches()
+    , patchFields(0)
+    , validPatch(false)
+    , firmwareCount(0)
+{
+    esp_log_level_set(TAG, static_cast<esp_log_level_t>(LOG_LOCAL_LEVEL));
+}
+
+bool CManifestParser::feed(const char *data, size_t length)
+{
+    return this->reader.feed(data, length);
+}
+
+bool CManifestParser::isDone() const
+{
+    return this->reader.isDone();
+}
+
+size_t CManifestParser::getFirmwareCount() const
+{
+    return this->firmwareCount;
+}
+
+bool CManifestParser::parseHash(const char *text, CHash &hash)
+{
+    if (strlen(text) != hash.size() * 2)
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < hash.size(); i++)
+    {
+        char byte[3] = {text[i * 2], text[i * 2 + 1], '\0'};
+        char *end;
+
+        hash[i] = static_cast<uint8_t>(strtoul(byte, &end, 16));
+        if (end != byte + 2)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+CManifestParser::Context CManifestParser::getContext() const
+{
+    return this->depth == 0 ? Skip : this->contexts[this->depth - 1];
+}
+
+bool CManifestParser::isKey(const char *name) const
+{
+    return strcmp(this->key.data(), name) == 0;
+}
+
+void CManifestParser::enter(Context context)
+{
+    this->contexts[this->depth++] = context;
+}
+
+void CManifestParser::startFirmware()
+{
+    this->firmware = CFirmware();
+    this->firmware.arena = this->arena;
+    this->firmware.beta = false;
+    this->firmware.rolloutStart = 0;
+    this->firmware.rolloutWindow = 0;
+    this->hasFirmwareVersion = false;
+    this->hasImages = false;
+}
+
+void CManifestParser::endFirmware()
+{
+    if (!this->hasFirmwareVersion || !this->hasImages)
+    {
+        return;
+    }
+
+    if (!this->firmware.images.contains(CImage::Main))
+    {
+        ESP_LOGW(TAG, "Firmware %s does not contain at least `main` image", this->firmware.version.getText());
+        return;
+    }
+
+    this->firmwareCount++;
+    this->onFirmware(std::move(this->firmware));
+}
+
+void CManifestParser::startImage()
+{
+    this->image = CImage();
+    // Logged before the url is known
+    this->image.url = "";
+    this->image.size = -1;
+    this->image.blockSize = 0;
+    this->image.encoding = CImage::Raw;
+    this->mirrors.clear();
+    this->blocks.clear();
+    this->patches.clear();
+
+    this->validType = false;
+    this->hasImageVersion = false;
+    this->hasUrl = false;
+    this->validEncoding = true;
+    this->hasBlockSize = false;
+    this->hasBlocks = false;
+    this->validBlocks = true;
+}
+
+void CManifestParser::endImage()
+{
+    if (!this->validType || !this->hasImageVersion || !this->hasUrl)
+    {
+        return;
+    }
+
+    if (!this->validEncoding)
+    {
+        ESP_LOGW(TAG, "Skipping %s, unsupported encoding", this->image.url.data());
+        return;
+    }
+
+    // Block hashes need both fields and are only usable when all of them could be parsed
+    bool validBlocks = this->validBlocks || !this->hasBlocks;
+    if (!this->hasBlockSize || !this->hasBlocks || !validBlocks)
+    {
+        this->blocks.clear();
+    }
+
+    this->image.mirrors = this->mirrors;
+    this->image.blocks = this->blocks;
+    this->image.patches = this->patches;
+
+    if (!this->image.sanitize() || !validBlocks)
+    {
+        ESP_LOGW(TAG, "Ignoring invalid block hashes for %s", this->image.url.data());
+    }
+
+    // Only what sanitize() kept is copied
+    this->image.mirrors = this->arena->copy(this->image.mirrors);
+    this->image.blocks = this->arena->copy(this->image.blocks);
+    this->image.patches = this->arena->copy(this->image.patches);
+
+    this->firmware.images.set(this->image);
+}
+
+void CManifestParser::startPatch()
+{
+    this->patch = CImage::CPatch();
+    this->patch.size = -1;
+    this->patch.encoding = CImage::Raw;
+    this->patchFields = 0;
+    this->validPatch = true;
+}
+
+void CManifestParser::endPatch()
+{
+    if (!this->validPatch || (this->patchFields & PATCH_REQUIRED) != PATCH_REQUIRED)
+    {
+        ESP_LOGW(TAG, "Ignoring invalid patch for %s", this->image.url.data());
+        return;
+    }
+
+    this->patches.push_back(this->patch);
+}
+
+void CManifestParser::invalidate()
+{
+    // Only fields that make the image or patch unusable when they have the wrong type, others are ignored
+    switch (this->getContext())
+    {
+    case Image:
+        if (this->isKey("encoding"))
+        {
+            this->validEncoding = false;
+        }
+        break;
+    case Blocks:
+        this->validBlocks = false;
+        break;
+    case Patch:
+        if (this->isKey("encoding"))
+        {
+            this->validPatch = false;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void CManifestParser::onStartObject()
+{
+    auto parent = this->getContext();
+
+    if (parent == Root)
+    {
+        this->startFirmware();
+        this->enter(Firmware);
+    }
+    else if (parent == Images)
+    {
+        this->startImage();
+        this->enter(Image);
+    }
+    else if (parent == Patches)
+    {
+        this->startPatch();
+        this->enter(Patch);
+    }
+    else
+    {
+        this->invalidate();
+        this->enter(Skip);
+    }
+}
+
+void CManifestParser::onEndObject()
+{
+    auto context = this->contexts[--this->depth];
+
+    if (context == Firmware)
+    {
+        this->endFirmware();
+    }
+    else if (context == Image)
+    {
+        this->endImage();
+    }
+    else if (context == Patch)
+    {
+        this->endPatch();
+    }
+}
+
+void CManifestParser::onStartArray()
+{
+    auto parent = this->getContext();
+
+    if (this->depth == 0)
+    {
+        this->enter(Root);
+    }
+    else if (parent == Firmware && this->isKey("images"))
+    {
+        this->hasImages = true;
+        this->enter(Images);
+    }
+    else if (parent == Image && this->isKey("mirrors"))
+    {
+        this->enter(Mirrors);
+    }
+    else if (parent == Image && this->isKey("blocks"))
+    {
+        this->hasBlocks = true;
+        this->enter(Blocks);
+    }
+    else if (parent == Image && this->isKey("patches"))
+    {
+        this->enter(Patches);
+    }
+    else
+    {
+        this->invalidate();
+        this->enter(Skip);
+    }
+}
+
+void CManifestParser::onEndArray()
+{
+    this->depth--;
+}
+
+void CManifestParser::onKey(const char *key, size_t length)
+{
+    if (length >= this->key.size())
+    {
+        this->key[0] = '\0';
+        return;
+    }
+
+    memcpy(this->key.data(), key, length + 1);
+}
+
+void CManifestParser::onString(const char *value, size_t length)
+{
+    switch (this->getContext())
+    {
+    case Firmware:
+        if (this->isKey("version"))
+        {
+            this->firmware.version = CVersion(value);
+            this->hasFirmwareVersion = true;
+        }
+        break;
+
+    case Image:
+        if (this->isKey("type"))
+        {
+            this->validType = CImage::parseType(value, this->image.imageType);
+        }
+        else if (this->isKey("version"))
+        {
+            this->image.version = CVersion(value);
+            this->hasImageVersion = true;
+        }
+        else if (this->isKey("url"))
+        {
+            this->image.url = this->arena->store(value, length);
+            this->hasUrl = true;
+        }
+        else if (this->isKey("encoding"))
+        {
+            this->validEncoding = CImage::parseEncoding(value, this->image.encoding);
+        }
+        else if (this->isKey("sha256"))
+        {
+            CHash hash;
+            if (CManifestParser::parseHash(value, hash))
+            {
+                this->image.hash = hash;
+            }
+        }
+        break;
+
+    case Mirrors:
+        this->mirrors.push_back(this->arena->store(value, length));
+        break;
+
+    case Blocks:
+    {
+        CHash hash;
+        if (CManifestParser::parseHash(value, hash))
+        {
+            this->blocks.push_back(hash);
+        }
+        else
+        {
+            this->validBlocks = false;
+        }
+        break;
+    }
+
+    case Patch:
+        if (this->isKey("from"))
+        {
+            this->patch.from = this->arena->store(value, length);
+            this->patchFields |= PATCH_FROM;
+        }
+        else if (this->isKey("fromSha256"))
+        {
+            if (CManifestParser::parseHash(value, this->patch.fromHash))
+            {
+                this->patchFields |= PATCH_FROM_HASH;
+            }
+        }
+        else if (this->isKey("url"))
+        {
+            this->patch.url = this->arena->store(value, length);
+            this->patchFields |= PATCH_URL;
+        }
+        else if (this->isKey("encoding"))
+        {
+            this->validPatch = CImage::parseEncoding(value, this->patch.encoding) && this->validPatch;
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+void CManifestParser::onNumber(double value)
+{
+    switch (this->getContext())
+    {
+    case Firmware:
+        if (this->isKey("rolloutStart"))
+        {
+            this->firmware.rolloutStart = static_cast<int64_t>(value);
+        }
+        else if (this->isKey("rolloutWindow") && value >= 0)
+        {
+            this->firmware.rolloutWindow = static_cast<uint32_t>(value);
+        }
+        break;
+
+    case Image:
+        if (this->isKey("size"))
+        {
+            this->image.size = static_cast<int>(value);
+        }
+        else if (this->isKey("blockSize"))
+        {
+            this->image.blockSize = static_cast<int>(value);
+            this->hasBlockSize = true;
+        }
+        else
+        {
+            this->invalidate();
+        }
+        break;
+
+    case Patch:
+        if (this->isKey("fromSize"))
+        {
+            this->patch.fromSize = static_cast<int>(value);
+            this->patchFields |= PATCH_FROM_SIZE;
+        }
+        else if (this->isKey("size"))
+        {
+            this->patch.size = static_cast<int>(value);
+        }
+        else
+        {
+            this->invalidate();
+        }
+        break;
+
+    default:
+        this->invalidate();
+        break;
+    }
+}
+
+void CManifestParser::onBool(bool value)
+{
+    if (this->getContext() == Firmware && this->isKey("beta"))
+    {
+        this->firmware.beta = value;
+    }
+    else
+    {
+        this->invalidate();
+    }
+}
+
+void CManifestParser::onNull()
+{
+    this->invalidate();
+}
+
+} // namespace Fri3d::Apps::Ota
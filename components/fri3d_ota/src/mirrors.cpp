@@ -0,0 +1,277 @@
+#include <algorithm>
+#include <cstdio>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "fri3d_private/mirrors.hpp"
+
+namespace Fri3d::Apps::Ota
+{
+
+static const char *TAG = "Fri3d::Apps::Ota::CMirrors";
+
+// Throughput is judged over this period, so a short hiccup doesn't cause a failover
+static const int64_t WINDOW_DURATION = 3 * 1000000;
+
+std::mutex CMirrors::statisticsMutex;
+std::map<std::string, CMirrors::CStatistics> CMirrors::statistics;
+
+CMirrors::CMirrors(std::string_view url, std::span<const std::string_view> mirrors)
+    : current(0)
+    , requestStart(0)
+    , windowStart(0)
+    , windowBytes(0)
+{
+    esp_log_level_set(TAG, static_cast<esp_log_level_t>(LOG_LOCAL_LEVEL));
+
+    std::string target(url);
+    this->candidates.push_back({.url = target, .base = CMirrors::getBase(target), .reachable = true, .latency = 0});
+
+    auto name = url.substr(url.rfind('/') + 1);
+    for (const auto &mirror : mirrors)
+    {
+        std::string base(mirror);
+        if (!base.ends_with('/'))
+        {
+            base += '/';
+        }
+
+        auto candidate = base;
+        candidate += name;
+        this->candidates.push_back({.url = candidate, .base = base, .reachable = true, .latency = 0});
+    }
+}
+
+std::string CMirrors::getBase(const std::string &url)
+{
+    return url.substr(0, url.rfind('/') + 1);
+}
+
+uint32_t CMirrors::getThroughput(const std::string &base)
+{
+    std::lock_guard lock(CMirrors::statisticsMutex);
+
+    auto item = CMirrors::statistics.find(base);
+    if (item == CMirrors::statistics.end() || item->second.duration <= 0)
+    {
+        return 0;
+    }
+
+    return static_cast<uint32_t>(item->second.bytes * 1000000 / item->second.duration);
+}
+
+bool CMirrors::probe(Application::Hardware::IHttp &http, CCandidate &candidate)
+{
+    auto client = http.acquire(candidate.url);
+    if (!client || !client.setHeader("Range", "bytes=0-0"))
+    {
+        return false;
+    }
+
+    // Includes the handshakes when there is no open connection yet, the download will reuse it
+    auto start = esp_timer_get_time();
+
+    bool result = ESP_OK == esp_http_client_open(client.get(), 0) && esp_http_client_fetch_headers(client.get()) >= 0;
+    auto status = result ? esp_http_client_get_status_code(client.get()) : 0;
+
+    candidate.latency = static_cast<uint32_t>((esp_timer_get_time() - start) / 1000);
+
+    if (status == 206)
+    {
+        // Read the single byte, so the connection can be used again
+        char data[16];
+        while (esp_http_client_read(client.get(), data, sizeof(data)) > 0)
+        {
+        }
+    }
+    else
+    {
+        // Also a server that ignores the range, rather than receiving the complete image
+        esp_http_client_close(client.get());
+    }
+
+    result = status == 200 || status == 206;
+
+    std::lock_guard lock(CMirrors::statisticsMutex);
+    auto &statistics = CMirrors::statistics[candidate.base];
+    statistics.probes++;
+    statistics.latency = candidate.latency;
+    if (!result)
+    {
+        statistics.failures++;
+    }
+
+    return result;
+}
+
+void CMirrors::select(Application::Hardware::IHttp &http, int size)
+{
+    if (this->candidates.size() < 2)
+    {
+        return;
+    }
+
+    for (auto &candidate : this->candidates)
+    {
+        candidate.reachable = this->probe(http, candidate);
+    }
+
+    auto getScore = [size](const CCandidate &candidate) {
+        int64_t score = candidate.latency;
+        auto throughput = CMirrors::getThroughput(candidate.base);
+
+        if (size > 0 && throughput > 0)
+        {
+            score += static_cast<int64_t>(size) * 1000 / throughput;
+        }
+
+        return score;
+    };
+
+    // Unreachable candidates go last, the origin first among them for when none was reachable
+    std::stable_sort(
+        this->candidates.begin(),
+        this->candidates.end(),
+        [&getScore](const CCandidate &l, const CCandidate &r) {
+            if (l.reachable != r.reachable)
+            {
+                return l.reachable;
+            }
+
+            return l.reachable && getScore(l) < getScore(r);
+        });
+
+    this->current = 0;
+
+    for (const auto &candidate : this->candidates)
+    {
+        ESP_LOGI(
+            TAG,
+            "%s: %s, %lu ms",
+            candidate.base.c_str(),
+            candidate.reachable ? "reachable" : "unreachable",
+            candidate.latency);
+    }
+}
+
+const std::string &CMirrors::getUrl() const
+{
+    return this->candidates[this->current].url;
+}
+
+bool CMirrors::failover()
+{
+    // Candidates the probe couldn't reach are skipped, they are only there for when none was reachable
+    for (auto next = this->current + 1; next < this->candidates.size(); next++)
+    {
+        if (this->candidates[next].reachable)
+        {
+            this->current = next;
+            ESP_LOGW(TAG, "Continuing from %s", this->candidates[next].base.c_str());
+
+            return true;
+        }
+    }
+
+    // All were tried, start over from the best one once the retry policy allows, the origin when none was reachable
+    auto best = std::find_if(
+        this->candidates.begin(),
+        this->candidates.end(),
+        [](const CCandidate &candidate) { return candidate.reachable; });
+    this->current = best != this->candidates.end() ? best - this->candidates.begin() : 0;
+
+    return false;
+}
+
+bool CMirrors::hasAlternative() const
+{
+    for (size_t index = 0; index < this->candidates.size(); index++)
+    {
+        if (index != this->current && this->candidates[index].reachable)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void CMirrors::start()
+{
+    this->requestStart = esp_timer_get_time();
+    this->windowStart = this->requestStart;
+    this->windowBytes = 0;
+}
+
+bool CMirrors::onReceived(size_t length)
+{
+    {
+        std::lock_guard lock(CMirrors::statisticsMutex);
+        CMirrors::statistics[this->candidates[this->current].base].bytes += length;
+    }
+
+    this->windowBytes += length;
+
+    auto now = esp_timer_get_time();
+    auto elapsed = now - this->windowStart;
+
+    if (elapsed < WINDOW_DURATION)
+    {
+        return true;
+    }
+
+    auto rate = static_cast<uint32_t>(this->windowBytes * 1000000 / elapsed);
+    this->windowStart = now;
+    this->windowBytes = 0;
+
+    // Without an alternative, slow is better than nothing
+    if (CONFIG_FRI3D_OTA_MIRROR_MIN_RATE == 0 || rate >= CONFIG_FRI3D_OTA_MIRROR_MIN_RATE * 1024 ||
+        !this->hasAlternative())
+    {
+        return true;
+    }
+
+    ESP_LOGW(TAG, "%s is too slow (%lu B/s)", this->candidates[this->current].base.c_str(), rate);
+    return false;
+}
+
+void CMirrors::finish(bool success)
+{
+    std::lock_guard lock(CMirrors::statisticsMutex);
+
+    auto &statistics = CMirrors::statistics[this->candidates[this->current].base];
+    statistics.duration += esp_timer_get_time() - this->requestStart;
+    if (!success)
+    {
+        statistics.failures++;
+    }
+}
+
+void CMirrors::printStatistics()
+{
+    std::lock_guard lock(CMirrors::statisticsMutex);
+
+    if (CMirrors::statistics.empty())
+    {
+        printf("Nothing downloaded yet\n");
+        return;
+    }
+
+    for (const auto &[base, statistics] : CMirrors::statistics)
+    {
+        auto throughput = statistics.duration > 0 ? statistics.bytes * 1000000 / statistics.duration : 0;
+
+        printf("%s\n", base.c_str());
+        printf(
+            "  probes %lu, last latency %lu ms, %lu kB in %lu ms (%lu kB/s), failures %lu\n",
+            statistics.probes,
+            statistics.latency,
+            static_cast<uint32_t>(statistics.bytes / 1024),
+            static_cast<uint32_t>(statistics.duration / 1000),
+            static_cast<uint32_t>(throughput / 1024),
+            statistics.failures);
+    }
+}
+
+} // namespace Fri3d::Apps::Ota
@@ -1,26 +1,25 @@
+#include <cstdio>
+#include <thread>
+
 #include "esp_log.h"
 #include "esp_ota_ops.h"
 #include "esp_system.h"
 
 #include "fri3d_application/app_manager.hpp"
+#include "fri3d_application/console.hpp"
 #include "fri3d_application/hardware_wifi.hpp"
 
 #include "fri3d_private/flasher.hpp"
+#include "fri3d_private/mirrors.hpp"
 #include "fri3d_private/ota.hpp"
+#include "fri3d_private/server_clock.hpp"
+#include "fri3d_private/settings.hpp"
 
 namespace Fri3d::Apps::Ota
 {
 
 static const char *TAG = "Fri3d::Apps::Ota::COta";
 
-static const char *NVS_BOOT_PARTITION = "boot_partition";
-static const char *NVS_APP_VERSION = "appVersion";
-static const char *NVS_MICROPYTHON = "microPython";
-static const char *NVS_RETRO_GO_LAUNCHER = "rgLauncher";
-static const char *NVS_RETRO_GO_CORE = "rgCore";
-static const char *NVS_RETRO_GO_PRBOOM = "rgPRBoom";
-static const char *NVS_VFS = "vfs";
-
 // DO NOT INCREASE WITHOUT CONSIDERING IMPLICATIONS!
 // NEVER DECREASE!
 // If you change this, also update the value in fri3d_firmware/nvs.csv
@@ -30,11 +29,18 @@ COta::COta()
     : Application::CThread<OtaEvent>(TAG)
     , screen(nullptr)
     , showBeta(false)
+    , updateInBackground(CONFIG_FRI3D_OTA_BACKGROUND)
     , updateMain(true)
 {
     esp_log_level_set(TAG, static_cast<esp_log_level_t>(LOG_LOCAL_LEVEL));
 }
 
+void COta::preload()
+{
+    // Reading the installed versions from NVS can overlap with the display initialization
+    this->loadCurrentVersions();
+}
+
 void COta::init()
 {
     ESP_LOGI(TAG, "Initializing OTA update");
@@ -45,25 +51,7 @@ void COta::init()
         lv_unlock();
     }
 
-    // If we get here, enough of the system is initialized to persist the flash
-    auto running = CFlasher::persist();
-
-    // We store the number in the name of the OTA partition because MicroPython can only read i32
-    auto nvs = this->getNvsManager().openSys();
-    ESP_ERROR_CHECK(nvs_set_i32(nvs, NVS_BOOT_PARTITION, running == "ota_0" ? 0 : 1));
-
-    // Fetch the current firmware versions
-    // The main firmware version we get from the running image
-    const esp_app_desc_t *app_desc = esp_app_get_description();
-    this->currentVersions[CImage::Main] = CVersion(app_desc->version);
-    this->currentFirmware = this->currentVersions[CImage::Main].simplify();
-
-    // The other versions we fetch from NVS
-    this->currentVersions[CImage::MicroPython] = CVersion(nvs.getString(NVS_MICROPYTHON).c_str());
-    this->currentVersions[CImage::RetroGoLauncher] = CVersion(nvs.getString(NVS_RETRO_GO_LAUNCHER).c_str());
-    this->currentVersions[CImage::RetroGoCore] = CVersion(nvs.getString(NVS_RETRO_GO_CORE).c_str());
-    this->currentVersions[CImage::RetroGoPRBoom] = CVersion(nvs.getString(NVS_RETRO_GO_PRBOOM).c_str());
-    this->currentVersions[CImage::VFS] = CVersion(nvs.getString(NVS_VFS).c_str());
+    this->loadCurrentVersions();
 }
 
 void COta::deinit()
@@ -78,6 +66,32 @@ void COta::deinit()
         this->screen = nullptr;
         lv_unlock();
     }
+
+    // Release everything we can fetch again on the next activation
+    this->fetcher.clear();
+    this->selectedFirmware = CFirmware();
+    this->currentVersions.clear();
+}
+
+void COta::loadCurrentVersions()
+{
+    if (!this->currentVersions.empty())
+    {
+        return;
+    }
+
+    // Fetch the current firmware versions
+    // The main firmware version we get from the running image
+    const esp_app_desc_t *app_desc = esp_app_get_description();
+    this->currentVersions[CImage::Main] = CVersion(app_desc->version);
+    this->currentFirmware = this->currentVersions[CImage::Main].simplify();
+
+    // The other versions we fetch from the settings
+    this->currentVersions[CImage::MicroPython] = CVersion(Settings::microPython.get().c_str());
+    this->currentVersions[CImage::RetroGoLauncher] = CVersion(Settings::retroGoLauncher.get().c_str());
+    this->currentVersions[CImage::RetroGoCore] = CVersion(Settings::retroGoCore.get().c_str());
+    this->currentVersions[CImage::RetroGoPRBoom] = CVersion(Settings::retroGoPRBoom.get().c_str());
+    this->currentVersions[CImage::VFS] = CVersion(Settings::vfs.get().c_str());
 }
 
 const char *COta::getName() const
@@ -87,8 +101,31 @@ const char *COta::getName() const
 
 void COta::activate()
 {
+    // We do our own checks while the app is open
+    this->prefetcher.setPaused(true);
+
     this->start();
-    this->showVersions();
+
+    // Show what we know right away, the server is only asked when checking or in the background
+    if (this->fetcher.getFirmwares(true).empty())
+    {
+        this->fetcher.load(this->getNvsManager(), this->prefetcher.getRecent());
+    }
+
+    // The indicator told about a failed update, the versions are shown again to retry
+    if (this->job.getState() == CUpdateJob::Failed)
+    {
+        this->job.reset();
+    }
+
+    if (this->job.getState() == CUpdateJob::Idle)
+    {
+        this->showVersions();
+    }
+    else
+    {
+        this->showJob();
+    }
 
     ESP_LOGI(TAG, "Activated");
 }
@@ -98,6 +135,12 @@ void COta::deactivate()
     this->hide();
     this->stop();
 
+    // An open TLS connection takes a good part of the heap
+    this->getHardwareManager().getHttp().closeIdle();
+
+    // A background update uses the connection itself
+    this->prefetcher.setPaused(this->job.getState() == CUpdateJob::Running);
+
     ESP_LOGI(TAG, "Deactivated");
 }
 
@@ -108,121 +151,64 @@ void COta::fetchFirmwares()
         return;
     }
 
-    if (!this->fetcher.refresh())
+    if (!this->fetcher.refresh(this->getHardwareManager().getHttp(), this->getNvsManager(), true))
     {
         ESP_LOGE(TAG, "Could not fetch versions.");
     };
 }
 
-void COta::updateFirmware()
+void COta::updateFirmware(bool background)
 {
     if (!this->ensureWifi())
     {
         return;
     }
 
-    ESP_LOGI(TAG, "Starting firmware update");
+    // All images are downloaded over the connection that fetched the versions
+    auto &http = this->getHardwareManager().getHttp();
 
-    auto nvs = this->getNvsManager().openSys();
-    bool result = true;
+    CUpdateJob::CSelection selection = {
+        .main = this->updateMain && *this->updateMain,
+        .microPython = this->updateMicroPython && *this->updateMicroPython,
+        .retroGo = this->updateRetroGo && *this->updateRetroGo,
+        .vfs = this->updateVfs && *this->updateVfs,
+    };
 
-    for (const auto &item : this->selectedFirmware.images)
+    if (background)
     {
-        switch (item.first)
-        {
-        case CImage::Main:
-            if (this->updateMain && *this->updateMain)
-            {
-                if (!CFlasher::flash(item.second))
-                {
-                    result = false;
-                    ESP_LOGE(TAG, "Error flashing main firmware.");
-                }
-            }
-            break;
-        case CImage::MicroPython:
-            if (this->updateMicroPython && *this->updateMicroPython)
-            {
-                if (CFlasher::flash(item.second, "micropython"))
-                {
-                    ESP_ERROR_CHECK(nvs_set_str(nvs, NVS_MICROPYTHON, item.second.version.text.c_str()));
-                }
-                else
-                {
-                    result = false;
-                    ESP_LOGE(TAG, "Error flashing MicroPython");
-                }
-            }
-            break;
-        case CImage::RetroGoLauncher:
-            if (this->updateRetroGo && *this->updateRetroGo)
-            {
-                if (CFlasher::flash(item.second, "launcher"))
-                {
-                    ESP_ERROR_CHECK(nvs_set_str(nvs, NVS_RETRO_GO_LAUNCHER, item.second.version.text.c_str()));
-                }
-                else
-                {
-                    result = false;
-                    ESP_LOGE(TAG, "Error flashing Retro-Go Launcher");
-                }
-            }
-            break;
-        case CImage::RetroGoCore:
-            if (this->updateRetroGo && *this->updateRetroGo)
-            {
-                if (CFlasher::flash(item.second, "retro-core"))
-                {
-                    ESP_ERROR_CHECK(nvs_set_str(nvs, NVS_RETRO_GO_CORE, item.second.version.text.c_str()));
-                }
-                else
-                {
-                    result = false;
-                    ESP_LOGE(TAG, "Error flashing Retro-Go Core");
-                }
-            }
-            break;
-        case CImage::RetroGoPRBoom:
-            if (this->updateRetroGo && *this->updateRetroGo)
-            {
-                if (CFlasher::flash(item.second, "prboom-go"))
-                {
-                    ESP_ERROR_CHECK(nvs_set_str(nvs, NVS_RETRO_GO_PRBOOM, item.second.version.text.c_str()));
-                }
-                else
-                {
-                    result = false;
-                    ESP_LOGE(TAG, "Error flashing Retro-Go Doom");
-                }
-            }
-            break;
-        case CImage::VFS:
-            if (this->updateVfs && *this->updateVfs)
-            {
-                if (CFlasher::flash(item.second, "vfs"))
-                {
-                    ESP_ERROR_CHECK(nvs_set_str(nvs, NVS_VFS, item.second.version.text.c_str()));
-                }
-                else
-                {
-                    result = false;
-                    ESP_LOGE(TAG, "Error flashing VFS");
-                }
-            }
-            break;
-        }
+        this->job.start(http, this->selectedFirmware, selection, [this](bool result) {
+            this->finishUpdate(result);
+            this->sendEvent({OtaEvent::UpdateFinished});
+        });
+
+        // The indicator shows how far it got, the badge can be used in the meantime
+        this->getAppManager().previousApp();
+        return;
     }
 
+    this->waitForSlot();
+
+    ESP_LOGI(TAG, "Starting firmware update");
+
+    Application::LVGL::CWaitDialog dialog("");
+    dialog.show();
+    CDialogStatus status(dialog);
+
+    this->finishUpdate(CUpdateJob::flash(http, this->selectedFirmware, selection, status));
+
+    esp_restart();
+}
+
+void COta::finishUpdate(bool result)
+{
     // Make sure the active app version is written, but only when all the flashes succeeded
     if (result)
     {
         ESP_LOGI(TAG, "Writing new application version to NVS");
-        ESP_ERROR_CHECK(nvs_set_u16(nvs, NVS_APP_VERSION, CURRENT_APP_VERSION));
+        Settings::appVersion.set(CURRENT_APP_VERSION);
     }
 
-    ESP_ERROR_CHECK(nvs_commit(nvs));
-
-    esp_restart();
+    this->getNvsManager().flush();
 }
 
 bool COta::getVisible() const
@@ -230,6 +216,16 @@ bool COta::getVisible() const
     return true;
 }
 
+bool COta::getReclaimable() const
+{
+    return true;
+}
+
+bool COta::getHighlighted() const
+{
+    return this->job.getState() != CUpdateJob::Idle || this->prefetcher.getUpdateAvailable();
+}
+
 void COta::hide()
 {
     lv_lock();
@@ -293,7 +289,7 @@ void COta::showVersions()
             lv_obj_set_style_text_decor(labelCurrentVersionTitle, LV_TEXT_DECOR_UNDERLINE, 0);
 
             auto labelCurrentVersion = lv_label_create(currentVersionContainer);
-            lv_label_set_text(labelCurrentVersion, this->currentFirmware.text.c_str());
+            lv_label_set_text(labelCurrentVersion, this->currentFirmware.getText());
         }
 
         if (!firmwares.empty())
@@ -321,7 +317,7 @@ void COta::showVersions()
 
             for (const auto &version : firmwares)
             {
-                lv_dropdown_add_option(dropDown, version.version.text.c_str(), LV_DROPDOWN_POS_LAST);
+                lv_dropdown_add_option(dropDown, version.version.getText(), LV_DROPDOWN_POS_LAST);
             }
 
             // Make sure the latest version is selected
@@ -371,9 +367,9 @@ void COta::showVersions()
             lv_obj_center(labelCancel);
         }
 
-        if (firmwares.empty())
+        if (!this->fetcher.isFresh())
         {
-            // Check online button
+            // Check online button, also shown when the versions only come from the cache
             auto buttonFetchVersions = lv_button_create(buttonsContainer);
             lv_group_focus_obj(buttonFetchVersions);
             lv_obj_set_flex_grow(buttonFetchVersions, 1);
@@ -383,11 +379,15 @@ void COta::showVersions()
             lv_label_set_text(labelFetchVersions, "Check");
             lv_obj_center(labelFetchVersions);
         }
-        else
+
+        if (!firmwares.empty())
         {
             // Update button
             auto buttonUpdate = lv_button_create(buttonsContainer);
-            lv_group_focus_obj(buttonUpdate);
+            if (this->fetcher.isFresh())
+            {
+                lv_group_focus_obj(buttonUpdate);
+            }
             lv_obj_set_flex_grow(buttonUpdate, 1);
             lv_obj_add_event_cb(buttonUpdate, COta::onClickPreview, LV_EVENT_CLICKED, this);
 
@@ -412,7 +412,7 @@ void COta::onImageCheckboxToggle(lv_event_t *event)
 void COta::addImageCheckbox(lv_obj_t *container, std::optional<bool> &active, CImage::ImageType imageType, bool enabled)
 {
     auto checkbox = lv_checkbox_create(container);
-    lv_checkbox_set_text(checkbox, CImage::typeToUIString.at(imageType).c_str());
+    lv_checkbox_set_text(checkbox, CImage::typeToUIString.at(imageType));
     lv_obj_set_style_text_font(checkbox, &lv_font_montserrat_10, 10);
     lv_obj_add_event_cb(checkbox, onImageCheckboxToggle, LV_EVENT_CLICKED, &active);
 
@@ -437,8 +437,8 @@ void COta::addImageCheckbox(lv_obj_t *container, std::optional<bool> &active, CI
     lv_label_set_text_fmt(
         label,
         "%s -> %s",
-        this->currentVersions[imageType].text.c_str(),
-        this->selectedFirmware.images[imageType].version.text.c_str());
+        this->currentVersions[imageType].getText(),
+        this->selectedFirmware.images.at(imageType).version.getText());
     lv_obj_set_width(label, LV_PCT(90));
     lv_obj_align(label, LV_ALIGN_RIGHT_MID, 0, 0);
     lv_obj_set_style_text_align(label, LV_TEXT_ALIGN_CENTER, 0);
@@ -497,6 +497,18 @@ void COta::showUpdate()
         }
     }
 
+    {
+        // Flash while the badge can still be used, or right away with a restart at the end
+        auto checkboxBackground = lv_checkbox_create(container);
+        lv_checkbox_set_text(checkboxBackground, "In the background");
+        lv_obj_set_style_text_font(checkboxBackground, &lv_font_montserrat_10, 0);
+        if (this->updateInBackground)
+        {
+            lv_obj_add_state(checkboxBackground, LV_STATE_CHECKED);
+        }
+        lv_obj_add_event_cb(checkboxBackground, onCheckboxBackgroundToggle, LV_EVENT_CLICKED, this);
+    }
+
     {
         // Buttons
 
@@ -540,6 +552,94 @@ void COta::showUpdate()
     lv_unlock();
 }
 
+void COta::showJob()
+{
+    auto state = this->job.getState();
+
+    if (state != CUpdateJob::Running && state != CUpdateJob::Finished)
+    {
+        this->job.reset();
+        this->showVersions();
+        return;
+    }
+
+    // Clear the screen
+    this->hide();
+
+    lv_lock();
+
+    // Vertical flex container
+    auto container = lv_obj_create(this->screen);
+    lv_obj_remove_style_all(container);
+    lv_obj_set_size(container, LV_PCT(80), LV_PCT(90));
+    lv_obj_center(container);
+    lv_obj_set_flex_flow(container, LV_FLEX_FLOW_COLUMN);
+    lv_obj_set_flex_align(container, LV_FLEX_ALIGN_SPACE_BETWEEN, LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_CENTER);
+    lv_obj_set_style_pad_row(container, 10, 0);
+
+    {
+        // Title
+        auto labelTitle = lv_label_create(container);
+        lv_label_set_text(labelTitle, "OTA Update");
+    }
+
+    {
+        auto labelState = lv_label_create(container);
+        lv_obj_set_width(labelState, LV_PCT(100));
+        lv_obj_set_flex_grow(labelState, 1);
+        lv_obj_set_style_text_align(labelState, LV_TEXT_ALIGN_CENTER, 0);
+        lv_label_set_long_mode(labelState, LV_LABEL_LONG_WRAP);
+        lv_label_set_text(
+            labelState,
+            state == CUpdateJob::Running ? "Updating in the background, the badge can be used in the meantime."
+                                         : "The update is installed, it is used after a restart.");
+    }
+
+    {
+        // Buttons
+
+        // Horizontal flex container
+        auto buttonsContainer = lv_obj_create(container);
+        lv_obj_remove_style_all(buttonsContainer);
+        lv_obj_set_style_pad_all(buttonsContainer, 3, 0);
+        lv_obj_set_size(buttonsContainer, LV_PCT(100), LV_SIZE_CONTENT);
+        lv_obj_center(buttonsContainer);
+        lv_obj_set_flex_flow(buttonsContainer, LV_FLEX_FLOW_ROW);
+        lv_obj_set_flex_align(buttonsContainer, LV_FLEX_ALIGN_SPACE_EVENLY, LV_FLEX_ALIGN_START, LV_FLEX_ALIGN_CENTER);
+        lv_obj_set_style_pad_column(buttonsContainer, 5, 0);
+
+        {
+            // Back button, the update goes on or waits for a restart
+            auto buttonBack = lv_button_create(buttonsContainer);
+            lv_obj_set_style_bg_color(buttonBack, lv_palette_main(LV_PALETTE_BLUE_GREY), LV_PART_MAIN);
+            lv_group_focus_obj(buttonBack);
+            lv_obj_set_flex_grow(buttonBack, 1);
+            lv_obj_add_event_cb(buttonBack, COta::onClickExit, LV_EVENT_CLICKED, this);
+
+            auto labelBack = lv_label_create(buttonBack);
+            lv_label_set_text(labelBack, state == CUpdateJob::Running ? "Back" : "Later");
+            lv_obj_center(labelBack);
+        }
+
+        if (state == CUpdateJob::Finished)
+        {
+            // Restart button
+            auto buttonRestart = lv_button_create(buttonsContainer);
+            lv_group_focus_obj(buttonRestart);
+            lv_obj_set_flex_grow(buttonRestart, 1);
+            lv_obj_add_event_cb(buttonRestart, COta::onClickRestart, LV_EVENT_CLICKED, this);
+
+            auto labelRestart = lv_label_create(buttonRestart);
+            lv_label_set_text(labelRestart, "Restart");
+            lv_obj_center(labelRestart);
+        }
+    }
+
+    lv_screen_load(this->screen);
+
+    lv_unlock();
+}
+
 void COta::onClickExit(lv_event_t *event)
 {
     auto self = static_cast<COta *>(lv_event_get_user_data(event));
@@ -611,7 +711,7 @@ void COta::onEvent(const OtaEvent &event)
         }
         break;
     case OtaEvent::UpdateFirmware:
-        this->updateFirmware();
+        this->updateFirmware(this->updateInBackground);
         break;
     case OtaEvent::UpdatePreview:
         this->showUpdate();
@@ -619,6 +719,15 @@ void COta::onEvent(const OtaEvent &event)
     case OtaEvent::CancelUpdate:
         this->showVersions();
         break;
+    case OtaEvent::UpdateFinished:
+        this->showJob();
+        break;
+    case OtaEvent::Restart:
+        // Make sure the job wrote its settings
+        this->job.stop();
+        this->getNvsManager().flush();
+        esp_restart();
+        break;
     }
 }
 
@@ -640,7 +749,7 @@ void COta::onVersionChange(lv_event_t *event)
 {
     auto self = static_cast<COta *>(lv_event_get_user_data(event));
     auto dropDown = static_cast<lv_obj_t *>(lv_event_get_target(event));
-    auto &versions = self->fetcher.getFirmwares(true);
+    auto &versions = self->fetcher.getFirmwares(self->showBeta);
 
     auto index = lv_dropdown_get_selected(dropDown);
 
@@ -674,6 +783,43 @@ bool COta::ensureWifi()
     return result;
 }
 
+void COta::waitForSlot()
+{
+    int64_t now;
+    if (this->selectedFirmware.rolloutWindow == 0 || !CServerClock::now(now))
+    {
+        return;
+    }
+
+    auto slot = this->selectedFirmware.getSlot();
+    if (now >= slot)
+    {
+        return;
+    }
+
+    ESP_LOGI(TAG, "Waiting %lu s for the rollout slot of this badge", static_cast<uint32_t>(slot - now));
+
+    Application::LVGL::CWaitDialog dialog("");
+    dialog.show();
+
+    auto total = static_cast<float>(slot - now);
+    char status[32];
+
+    for (auto remaining = slot - now; remaining > 0; remaining--)
+    {
+        snprintf(
+            status,
+            sizeof(status),
+            "Your turn in %lu:%02lu",
+            static_cast<uint32_t>(remaining / 60),
+            static_cast<uint32_t>(remaining % 60));
+        dialog.setStatus(status);
+        dialog.setProgress((1.0f - static_cast<float>(remaining) / total) * 100.0f);
+
+        std::this_thread::sleep_for(1s);
+    }
+}
+
 void COta::onClickCancel(lv_event_t *event)
 {
     auto self = static_cast<COta *>(lv_event_get_user_data(event));
@@ -688,9 +834,25 @@ void COta::onClickUpdate(lv_event_t *event)
     self->sendEvent({OtaEvent::UpdateFirmware});
 }
 
+void COta::onCheckboxBackgroundToggle(lv_event_t *event)
+{
+    auto self = static_cast<COta *>(lv_event_get_user_data(event));
+
+    self->updateInBackground = !self->updateInBackground;
+}
+
+void COta::onClickRestart(lv_event_t *event)
+{
+    auto self = static_cast<COta *>(lv_event_get_user_data(event));
+
+    self->sendEvent({OtaEvent::Restart});
+}
+
 void COta::handleNewAppVersion(uint16_t activeVersion)
 {
     // This function contains all necessary code to switch between app versions
+    // We run before the app was ever activated, so make sure we know what is installed
+    this->loadCurrentVersions();
 
     // First try to get the correct firmwares
     this->fetchFirmwares();
@@ -714,25 +876,24 @@ void COta::handleNewAppVersion(uint16_t activeVersion)
     this->updateRetroGo = true;
     this->updateVfs = true;
 
-    // Start update
-    this->updateFirmware();
+    // Start update, nothing else should run before it is done
+    this->updateFirmware(false);
 }
 
 void COta::onSystemStart()
 {
     CBaseApp::onSystemStart();
 
-    auto nvs = this->getNvsManager().openSys();
+    // If we get here, enough of the system is initialized to persist the flash
+    auto running = CFlasher::persist();
+
+    // We store the number in the name of the OTA partition because MicroPython can only read i32
+    // This only reaches flash when it actually changed
+    Settings::bootPartition.set(running == "ota_0" ? 0 : 1);
 
     // Check the application version, this allows for force running another update after rebooting into a firmware,
     // for example if something changed to partition layouts, the update JSON or the images to flash.
-    uint16_t activeVersion = 0;
-    esp_err_t err = nvs_get_u16(nvs, NVS_APP_VERSION, &activeVersion);
-    if (err != ESP_OK && err != ESP_ERR_NVS_NOT_FOUND)
-    {
-        ESP_LOGE(TAG, "Could not fetch application version!");
-        ESP_ERROR_CHECK(err);
-    }
+    uint16_t activeVersion = Settings::appVersion.get();
 
     if (activeVersion != CURRENT_APP_VERSION)
     {
@@ -740,6 +901,28 @@ void COta::onSystemStart()
         ESP_LOGW(TAG, "Application version mismatch, forcing update.");
         this->handleNewAppVersion(activeVersion);
     }
+
+    Application::console.registerCommand(
+        "mirrors",
+        "Print the download statistics of the update server and its mirrors",
+        [](int argc, char **argv) {
+            CMirrors::printStatistics();
+            return 0;
+        });
+
+#if CONFIG_FRI3D_OTA_PREFETCH
+    this->loadCurrentVersions();
+    this->prefetcher.start(this->getHardwareManager(), this->getNvsManager(), this->currentFirmware);
+#endif
+}
+
+void COta::onSystemStop()
+{
+    // Flashing is finished first, a half written partition can't be used
+    this->job.stop();
+    this->prefetcher.stop();
+
+    CBaseApp::onSystemStop();
 }
 
 static COta ota_impl;
@@ -0,0 +1,99 @@
+#include "esp_image_format.h"
+#include "esp_log.h"
+
+#include "fri3d_private/partition.hpp"
+
+namespace Fri3d::Apps::Ota
+{
+
+static const char *TAG = "Fri3d::Apps::Ota::CFlashPartition";
+
+CFlashPartition::CFlashPartition(const esp_partition_t &partition)
+    : partition(partition)
+{
+    esp_log_level_set(TAG, static_cast<esp_log_level_t>(LOG_LOCAL_LEVEL));
+}
+
+const char *CFlashPartition::getLabel() const
+{
+    return this->partition.label;
+}
+
+size_t CFlashPartition::getSize() const
+{
+    return this->partition.size;
+}
+
+size_t CFlashPartition::getEraseSize() const
+{
+    return this->partition.erase_size;
+}
+
+bool CFlashPartition::begin()
+{
+    return true;
+}
+
+bool CFlashPartition::read(size_t offset, void *data, size_t length)
+{
+    return esp_partition_read(&this->partition, offset, data, length) == ESP_OK;
+}
+
+bool CFlashPartition::erase(size_t offset, size_t length)
+{
+    auto result = esp_partition_erase_range(&this->partition, offset, length);
+    if (result != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Could not erase `%s` at %d: %s", this->partition.label, offset, esp_err_to_name(result));
+        return false;
+    }
+
+    return true;
+}
+
+bool CFlashPartition::write(size_t offset, const void *data, size_t length)
+{
+    auto result = esp_partition_write(&this->partition, offset, data, length);
+    if (result != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Could not write `%s` at %d: %s", this->partition.label, offset, esp_err_to_name(result));
+        return false;
+    }
+
+    return true;
+}
+
+bool CFlashPartition::end()
+{
+    return true;
+}
+
+CAppPartition::CAppPartition(const esp_partition_t &partition, bool verifyImage)
+    : CFlashPartition(partition)
+    , verifyImage(verifyImage)
+{
+}
+
+bool CAppPartition::end()
+{
+    if (!this->verifyImage)
+    {
+        return true;
+    }
+
+    const esp_partition_pos_t position = {
+        .offset = this->partition.address,
+        .size = this->partition.size,
+    };
+    esp_image_metadata_t metadata;
+
+    if (esp_image_verify(ESP_IMAGE_VERIFY, &position, &metadata) != ESP_OK)
+    {
+        ESP_LOGE(TAG, "`%s` does not contain a valid app image", this->partition.label);
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace Fri3d::Apps::Ota
@@ -0,0 +1,325 @@
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+#include "esp_log.h"
+#include "esp_pthread.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "fri3d_private/partition_writer.hpp"
+
+namespace Fri3d::Apps::Ota
+{
+
+static const char *TAG = "Fri3d::Apps::Ota::CPartitionWriter";
+
+// Erasing aligned 64 KB blocks is a lot faster than erasing the separate sectors
+static const size_t ERASE_BLOCK_SIZE = 64 * 1024;
+
+static size_t alignUp(size_t value, size_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+CPartitionWriter::CPartitionWriter(
+    IPartition &partition,
+    COnWritten onWritten,
+    IVerifier *verifier,
+    const CFlashThrottle &throttle)
+    : partition(partition)
+    , regionEnd(partition.getSize())
+    , position(0)
+    , current(nullptr)
+    , erased(0)
+    , written(0)
+    , eraseLimit(partition.getSize())
+    , finishing(false)
+    , failed(false)
+    , statistics()
+    , onWritten(std::move(onWritten))
+    , verifier(verifier)
+    , throttle(throttle)
+{
+    esp_log_level_set(TAG, static_cast<esp_log_level_t>(LOG_LOCAL_LEVEL));
+
+    this->throttle.dutyCycle = std::clamp(this->throttle.dutyCycle, 1, 100);
+    this->throttle.eraseSize = alignUp(
+        std::max(this->throttle.eraseSize, partition.getEraseSize()),
+        partition.getEraseSize());
+
+    for (auto &buffer : this->buffers)
+    {
+        buffer.data.resize(CONFIG_FRI3D_OTA_BUFFER_SIZE);
+        buffer.length = 0;
+        this->empty.push_back(&buffer);
+    }
+
+    auto config = esp_pthread_get_default_config();
+    config.thread_name = "flash";
+    // A background update should not get ahead of the UI by writing at a higher priority than it downloads
+    config.prio = static_cast<int>(uxTaskPriorityGet(nullptr));
+    esp_pthread_set_cfg(&config);
+
+    this->thread = std::thread(&CPartitionWriter::run, this);
+
+    config = esp_pthread_get_default_config();
+    esp_pthread_set_cfg(&config);
+}
+
+CPartitionWriter::~CPartitionWriter()
+{
+    this->finish();
+}
+
+bool CPartitionWriter::beginRegion(size_t start, int length)
+{
+    this->flush();
+
+    if (start % this->partition.getEraseSize() != 0 || start >= this->partition.getSize() ||
+        (length > 0 && start + length > this->partition.getSize()))
+    {
+        ESP_LOGE(TAG, "Invalid region at %d of %d bytes in `%s`", start, length, this->partition.getLabel());
+        return false;
+    }
+
+    this->position = start;
+    this->regionEnd = this->partition.getSize();
+
+    if (length > 0)
+    {
+        this->regionEnd = std::min(this->regionEnd, alignUp(start + length, this->partition.getEraseSize()));
+    }
+
+    return true;
+}
+
+bool CPartitionWriter::ensureErased(size_t end)
+{
+    end = std::min(alignUp(end, ERASE_BLOCK_SIZE), this->eraseLimit);
+
+    // Split up so code running from flash gets to run between the parts
+    while (this->erased < end)
+    {
+        auto length = std::min(end - this->erased, this->throttle.eraseSize);
+
+        auto start = esp_timer_get_time();
+        auto result = this->partition.erase(this->erased, length);
+        auto busy = esp_timer_get_time() - start;
+        this->statistics.erase += static_cast<uint32_t>(busy);
+
+        if (!result)
+        {
+            return false;
+        }
+
+        this->statistics.erased += length;
+        this->erased += length;
+
+        this->rest(busy);
+    }
+
+    return true;
+}
+
+void CPartitionWriter::rest(int64_t busy)
+{
+    if (this->throttle.dutyCycle >= 100 || busy <= 0)
+    {
+        // Still give other threads at the same priority a turn
+        std::this_thread::yield();
+        return;
+    }
+
+    auto duration = busy * (100 - this->throttle.dutyCycle) / this->throttle.dutyCycle;
+    std::this_thread::sleep_for(std::chrono::microseconds(duration));
+    this->statistics.rest += static_cast<uint32_t>(duration);
+}
+
+void CPartitionWriter::run()
+{
+    bool ok = true;
+
+    while (ok)
+    {
+        CBuffer *buffer;
+        {
+            auto start = esp_timer_get_time();
+
+            std::unique_lock lock(this->buffersMutex);
+            this->buffersChanged.wait(lock, [this]() { return !this->full.empty() || this->finishing; });
+
+            this->statistics.idle += static_cast<uint32_t>(esp_timer_get_time() - start);
+
+            if (this->full.empty())
+            {
+                break;
+            }
+
+            buffer = this->full.front();
+            this->full.pop_front();
+        }
+
+        if (buffer->offset != this->written)
+        {
+            // A new region starts, regions never overlap so everything before it is left alone
+            this->written = buffer->offset;
+            this->erased = buffer->offset;
+        }
+        this->eraseLimit = buffer->regionEnd;
+
+        if (this->written + buffer->length > this->eraseLimit)
+        {
+            ESP_LOGE(TAG, "Data does not fit in its region of `%s`", this->partition.getLabel());
+            ok = false;
+        }
+        else
+        {
+            ok = this->ensureErased(this->written + buffer->length);
+        }
+
+        if (ok)
+        {
+            auto start = esp_timer_get_time();
+            ok = this->partition.write(this->written, buffer->data.data(), buffer->length);
+            auto busy = esp_timer_get_time() - start;
+            this->statistics.write += static_cast<uint32_t>(busy);
+            this->rest(busy);
+        }
+
+        if (ok)
+        {
+            if (this->verifier != nullptr)
+            {
+                this->verifier->update(this->written, buffer->data.data(), buffer->length);
+            }
+
+            this->written += buffer->length;
+            this->statistics.written += buffer->length;
+
+            if (this->onWritten)
+            {
+                this->onWritten(this->written);
+            }
+        }
+
+        {
+            std::lock_guard lock(this->buffersMutex);
+            this->empty.push_back(buffer);
+        }
+        this->buffersChanged.notify_all();
+
+        // Erase the next block of the region while the next buffer is still being downloaded
+        ok = ok && this->ensureErased(this->written + CONFIG_FRI3D_OTA_BUFFER_SIZE);
+    }
+
+    if (!ok)
+    {
+        std::lock_guard lock(this->buffersMutex);
+        this->failed = true;
+    }
+    this->buffersChanged.notify_all();
+}
+
+CPartitionWriter::CBuffer *CPartitionWriter::acquire()
+{
+    std::unique_lock lock(this->buffersMutex);
+    this->buffersChanged.wait(lock, [this]() { return !this->empty.empty() || this->failed; });
+
+    if (this->failed)
+    {
+        return nullptr;
+    }
+
+    auto buffer = this->empty.front();
+    this->empty.pop_front();
+
+    buffer->length = 0;
+    buffer->offset = this->position;
+    buffer->regionEnd = this->regionEnd;
+
+    return buffer;
+}
+
+void CPartitionWriter::submit(CBuffer *buffer)
+{
+    {
+        std::lock_guard lock(this->buffersMutex);
+
+        if (buffer->length == 0)
+        {
+            this->empty.push_back(buffer);
+        }
+        else
+        {
+            this->full.push_back(buffer);
+            this->position += buffer->length;
+        }
+    }
+
+    this->buffersChanged.notify_all();
+}
+
+bool CPartitionWriter::write(const uint8_t *data, size_t length)
+{
+    while (length > 0)
+    {
+        if (this->current == nullptr)
+        {
+            this->current = this->acquire();
+            if (this->current == nullptr)
+            {
+                return false;
+            }
+        }
+
+        auto size = std::min(length, this->current->data.size() - this->current->length);
+        std::copy(data, data + size, this->current->data.data() + this->current->length);
+        this->current->length += size;
+        data += size;
+        length -= size;
+
+        if (this->current->length == this->current->data.size())
+        {
+            this->submit(this->current);
+            this->current = nullptr;
+        }
+    }
+
+    return true;
+}
+
+void CPartitionWriter::flush()
+{
+    if (this->current != nullptr)
+    {
+        this->submit(this->current);
+        this->current = nullptr;
+    }
+}
+
+bool CPartitionWriter::finish()
+{
+    this->flush();
+
+    {
+        std::lock_guard lock(this->buffersMutex);
+        this->finishing = true;
+    }
+    this->buffersChanged.notify_all();
+
+    if (this->thread.joinable())
+    {
+        this->thread.join();
+    }
+
+    return !this->failed;
+}
+
+const CPartitionWriter::CStatistics &CPartitionWriter::getStatistics() const
+{
+    return this->statistics;
+}
+
+} // namespace Fri3d::Apps::Ota
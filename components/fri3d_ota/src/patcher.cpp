@@ -0,0 +1,239 @@
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "esp_log.h"
+
+#include "fri3d_private/patcher.hpp"
+
+namespace Fri3d::Apps::Ota
+{
+
+static const char *TAG = "Fri3d::Apps::Ota::CPatcher";
+
+static const uint8_t MAGIC[] = {'F', '3', 'D', 'P'};
+
+static const uint8_t OP_END = 0x00;
+static const uint8_t OP_COPY = 0x01;
+static const uint8_t OP_DATA = 0x02;
+
+// Source data is copied in chunks of this size
+static const size_t COPY_CHUNK_SIZE = 4096;
+
+CPatcher::CPatcher(CSource source, size_t sourceSize)
+    : source(std::move(source))
+    , sourceSize(sourceSize)
+    , targetSize(0)
+    , written(0)
+    , state(Header)
+    , field()
+    , fieldLength(0)
+    , remaining(0)
+{
+    esp_log_level_set(TAG, static_cast<esp_log_level_t>(LOG_LOCAL_LEVEL));
+}
+
+uint32_t CPatcher::readU32(const uint8_t *data)
+{
+    return data[0] | (data[1] << 8) | (data[2] << 16) | (static_cast<uint32_t>(data[3]) << 24);
+}
+
+size_t CPatcher::getFieldSize() const
+{
+    switch (this->state)
+    {
+    case Header:
+        return HeaderSize;
+    case Operation:
+        return 1;
+    case CopyArguments:
+        return CopyArgumentsSize;
+    case DataLength:
+        return DataLengthSize;
+    default:
+        return 0;
+    }
+}
+
+bool CPatcher::collect(const uint8_t *&data, size_t &length)
+{
+    auto size = std::min(length, this->getFieldSize() - this->fieldLength);
+
+    std::copy(data, data + size, this->field.data() + this->fieldLength);
+    this->fieldLength += size;
+    data += size;
+    length -= size;
+
+    return this->fieldLength == this->getFieldSize();
+}
+
+bool CPatcher::fail(const char *reason)
+{
+    ESP_LOGE(TAG, "Invalid patch: %s", reason);
+    this->state = Failed;
+
+    return false;
+}
+
+bool CPatcher::copy(size_t offset, size_t length, const COutput &output)
+{
+    if (offset + length > this->sourceSize || offset + length < offset)
+    {
+        return this->fail("copy beyond the end of the source");
+    }
+
+    if (this->buffer.empty())
+    {
+        this->buffer.resize(COPY_CHUNK_SIZE);
+    }
+
+    while (length > 0)
+    {
+        auto size = std::min(length, this->buffer.size());
+
+        if (!this->source(offset, this->buffer.data(), size) || !output(this->buffer.data(), size))
+        {
+            this->state = Failed;
+            return false;
+        }
+
+        offset += size;
+        length -= size;
+    }
+
+    return true;
+}
+
+bool CPatcher::handleField(const COutput &output)
+{
+    const auto data = this->field.data();
+    this->fieldLength = 0;
+
+    switch (this->state)
+    {
+    case Header:
+        if (memcmp(data, MAGIC, sizeof(MAGIC)) != 0)
+        {
+            return this->fail("wrong magic");
+        }
+
+        if (CPatcher::readU32(data + 4) != this->sourceSize)
+        {
+            return this->fail("made for another source");
+        }
+
+        this->targetSize = CPatcher::readU32(data + 8);
+        this->state = Operation;
+        break;
+    case Operation:
+        switch (data[0])
+        {
+        case OP_END:
+            if (this->written != this->targetSize)
+            {
+                return this->fail("target is incomplete");
+            }
+            this->state = Done;
+            break;
+        case OP_COPY:
+            this->state = CopyArguments;
+            break;
+        case OP_DATA:
+            this->state = DataLength;
+            break;
+        default:
+            return this->fail("unknown operation");
+        }
+        break;
+    case CopyArguments:
+    {
+        auto offset = CPatcher::readU32(data);
+        auto length = CPatcher::readU32(data + 4);
+
+        if (this->written + length > this->targetSize)
+        {
+            return this->fail("copy beyond the end of the target");
+        }
+
+        if (!this->copy(offset, length, output))
+        {
+            return false;
+        }
+
+        this->written += length;
+        this->state = Operation;
+        break;
+    }
+    case DataLength:
+        this->remaining = CPatcher::readU32(data);
+
+        if (this->written + this->remaining > this->targetSize)
+        {
+            return this->fail("data beyond the end of the target");
+        }
+
+        this->state = this->remaining > 0 ? Data : Operation;
+        break;
+    default:
+        break;
+    }
+
+    return true;
+}
+
+bool CPatcher::feed(const uint8_t *data, size_t length, const COutput &output)
+{
+    while (length > 0)
+    {
+        switch (this->state)
+        {
+        case Data:
+        {
+            // New data is passed on without copying it
+            auto size = std::min(length, this->remaining);
+
+            if (!output(data, size))
+            {
+                this->state = Failed;
+                return false;
+            }
+
+            data += size;
+            length -= size;
+            this->written += size;
+            this->remaining -= size;
+
+            if (this->remaining == 0)
+            {
+                this->state = Operation;
+            }
+            break;
+        }
+        case Done:
+            ESP_LOGW(TAG, "Ignoring %d bytes after the end of the patch", length);
+            return true;
+        case Failed:
+            return false;
+        default:
+            if (this->collect(data, length) && !this->handleField(output))
+            {
+                return false;
+            }
+            break;
+        }
+    }
+
+    return this->state != Failed;
+}
+
+bool CPatcher::isDone() const
+{
+    return this->state == Done;
+}
+
+size_t CPatcher::getTargetSize() const
+{
+    return this->targetSize;
+}
+
+} // namespace Fri3d::Apps::Ota
@@ -0,0 +1,191 @@
+#include "esp_log.h"
+#include "esp_pthread.h"
+#include "esp_random.h"
+#include "esp_timer.h"
+
+#include "fri3d_private/firmware_fetcher.hpp"
+#include "fri3d_private/prefetcher.hpp"
+#include "fri3d_private/server_clock.hpp"
+
+namespace Fri3d::Apps::Ota
+{
+
+static const char *TAG = "Fri3d::Apps::Ota::CPrefetcher";
+
+using namespace std::chrono_literals;
+
+// The first check waits for the rest of the system to settle
+static const auto FIRST_DELAY = 10s;
+static const auto FIRST_SPREAD = 60s;
+
+// How soon to look again when wifi is down, the OTA app is open or the check failed
+static const auto RETRY_DELAY = 2min;
+static const auto RETRY_SPREAD = 1min;
+
+static const auto INTERVAL = std::chrono::minutes(CONFIG_FRI3D_OTA_PREFETCH_INTERVAL);
+
+CPrefetcher::CPrefetcher()
+    : hardware(nullptr)
+    , nvs(nullptr)
+    , stopping(false)
+    , paused(false)
+    , updateAvailable(false)
+    , updateSlot(0)
+    , lastCheck(0)
+{
+    esp_log_level_set(TAG, static_cast<esp_log_level_t>(LOG_LOCAL_LEVEL));
+}
+
+CPrefetcher::~CPrefetcher()
+{
+    this->stop();
+}
+
+void CPrefetcher::start(
+    Application::IHardwareManager &hardware,
+    Application::INvsManager &nvs,
+    const CVersion &current)
+{
+    if (this->thread.joinable())
+    {
+        return;
+    }
+
+    this->hardware = &hardware;
+    this->nvs = &nvs;
+    this->current = current;
+    this->stopping = false;
+
+    // Just above idle, and TLS handshakes need a deep stack
+    auto config = esp_pthread_get_default_config();
+    config.thread_name = "ota_prefetch";
+    config.prio = 1;
+    config.stack_size = 8192;
+    esp_pthread_set_cfg(&config);
+
+    this->thread = std::thread(&CPrefetcher::run, this);
+
+    config = esp_pthread_get_default_config();
+    esp_pthread_set_cfg(&config);
+
+    ESP_LOGI(TAG, "Started");
+}
+
+void CPrefetcher::stop()
+{
+    if (!this->thread.joinable())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard lock(this->stoppingMutex);
+        this->stopping = true;
+    }
+    this->stoppingChanged.notify_all();
+
+    // A check that is running is finished first
+    this->thread.join();
+
+    ESP_LOGI(TAG, "Stopped");
+}
+
+void CPrefetcher::setPaused(bool value)
+{
+    this->paused = value;
+}
+
+bool CPrefetcher::getUpdateAvailable() const
+{
+    if (!this->updateAvailable)
+    {
+        return false;
+    }
+
+    // Badges are only told about the update in their own slot, so they don't all start downloading at once
+    int64_t now;
+    return !CServerClock::now(now) || now >= this->updateSlot;
+}
+
+bool CPrefetcher::getRecent() const
+{
+    auto last = this->lastCheck.load();
+
+    return last != 0 &&
+           esp_timer_get_time() - last < std::chrono::duration_cast<std::chrono::microseconds>(INTERVAL).count();
+}
+
+std::chrono::milliseconds CPrefetcher::jitter(std::chrono::milliseconds base, std::chrono::milliseconds spread)
+{
+    return base + std::chrono::milliseconds(esp_random() % (spread.count() + 1));
+}
+
+bool CPrefetcher::sleep(std::chrono::milliseconds duration)
+{
+    std::unique_lock lock(this->stoppingMutex);
+
+    return !this->stoppingChanged.wait_for(lock, duration, [this] { return this->stopping; });
+}
+
+bool CPrefetcher::check()
+{
+    auto &http = this->hardware->getHttp();
+
+    CFirmwareFetcher fetcher;
+    bool result = fetcher.refresh(http, *this->nvs, false);
+
+    // The next check is a long way off, don't keep the memory of the TLS connection until then
+    http.closeIdle();
+
+    if (!result)
+    {
+        ESP_LOGW(TAG, "Could not check for updates");
+        return false;
+    }
+
+    auto &official = fetcher.getFirmwares(false);
+    bool available = !official.empty() && official.front().version > this->current;
+
+    this->updateSlot = available ? official.front().getSlot() : 0;
+    this->updateAvailable = available;
+
+    // The app shows the cache as up to date, that's only true when it holds what the server just sent
+    this->lastCheck = fetcher.isCached() ? esp_timer_get_time() : 0;
+
+    if (available)
+    {
+        ESP_LOGI(TAG, "Update available: %s", official.front().version.getText());
+    }
+    else
+    {
+        ESP_LOGI(TAG, "Up to date");
+    }
+
+    return true;
+}
+
+void CPrefetcher::run()
+{
+    auto delay = CPrefetcher::jitter(FIRST_DELAY, FIRST_SPREAD);
+
+    while (this->sleep(delay))
+    {
+        if (this->paused || !this->hardware->getWifi().getConnected())
+        {
+            ESP_LOGD(TAG, "Not checking now");
+            delay = CPrefetcher::jitter(RETRY_DELAY, RETRY_SPREAD);
+            continue;
+        }
+
+        if (this->check())
+        {
+            delay = CPrefetcher::jitter(INTERVAL * 3 / 4, INTERVAL / 2);
+        }
+        else
+        {
+            delay = CPrefetcher::jitter(RETRY_DELAY, RETRY_SPREAD);
+        }
+    }
+}
+
+} // namespace Fri3d::Apps::Ota
@@ -0,0 +1,125 @@
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+#include "esp_log.h"
+#include "esp_random.h"
+
+#include "fri3d_private/retry_policy.hpp"
+#include "fri3d_private/server_clock.hpp"
+
+namespace Fri3d::Apps::Ota
+{
+
+static const char *TAG = "Fri3d::Apps::Ota::CRetryPolicy";
+
+static const auto BASE_DELAY = std::chrono::milliseconds(CONFIG_FRI3D_OTA_RETRY_DELAY);
+static const auto MAX_DELAY = std::chrono::milliseconds(CONFIG_FRI3D_OTA_RETRY_MAX_DELAY * 1000);
+
+CRetryPolicy::CRetryPolicy(int retries)
+    : retries(retries)
+    , attempt(0)
+    , retryAfter(0)
+{
+    esp_log_level_set(TAG, static_cast<esp_log_level_t>(LOG_LOCAL_LEVEL));
+}
+
+void CRetryPolicy::watch(Application::Hardware::CHttpClient &client)
+{
+    client.watchHeader("Date");
+    client.watchHeader("Retry-After");
+}
+
+bool CRetryPolicy::isBusy(int status)
+{
+    return status == 429 || status == 503;
+}
+
+void CRetryPolicy::update(const Application::Hardware::CHttpClient &client)
+{
+    auto date = client.getHeader("Date");
+    CServerClock::update(date);
+
+    auto value = client.getHeader("Retry-After");
+    if (value.empty())
+    {
+        this->retryAfter = std::chrono::milliseconds(0);
+        return;
+    }
+
+    // Either a number of seconds or a date
+    char *end;
+    auto seconds = strtol(value.c_str(), &end, 10);
+
+    if (*end != '\0')
+    {
+        int64_t until, now;
+        seconds = CServerClock::parse(value, until) && CServerClock::now(now) ? static_cast<long>(until - now) : 0;
+    }
+
+    this->retryAfter = std::chrono::seconds(std::max(seconds, 0L));
+    ESP_LOGD(TAG, "Server asks to retry after %ld s", seconds);
+}
+
+std::chrono::milliseconds CRetryPolicy::getDelay() const
+{
+    // Half of the backoff is fixed, the other half random
+    auto backoff = std::min(BASE_DELAY * (1 << std::min(this->attempt, 16)), MAX_DELAY);
+    auto spread = std::chrono::milliseconds(esp_random() % (backoff.count() / 2 + 1));
+
+    if (this->retryAfter.count() > 0)
+    {
+        return this->retryAfter + spread;
+    }
+
+    return backoff / 2 + spread;
+}
+
+bool CRetryPolicy::wait(const char *what)
+{
+    if (this->attempt >= this->retries)
+    {
+        ESP_LOGE(TAG, "Giving up on %s after %d attempts", what, this->attempt + 1);
+        return false;
+    }
+
+    if (this->retryAfter > MAX_DELAY)
+    {
+        ESP_LOGE(
+            TAG,
+            "Server is busy for %lu s, giving up on %s",
+            static_cast<uint32_t>(this->retryAfter.count() / 1000),
+            what);
+        return false;
+    }
+
+    auto delay = this->getDelay();
+    this->attempt++;
+    this->retryAfter = std::chrono::milliseconds(0);
+
+    ESP_LOGW(
+        TAG,
+        "Retrying %s in %lu ms (%d/%d)",
+        what,
+        static_cast<uint32_t>(delay.count()),
+        this->attempt,
+        this->retries);
+
+    std::this_thread::sleep_for(delay);
+
+    return true;
+}
+
+void CRetryPolicy::reset()
+{
+    this->attempt = 0;
+    this->retryAfter = std::chrono::milliseconds(0);
+}
+
+int CRetryPolicy::getAttempt() const
+{
+    return this->attempt;
+}
+
+} // namespace Fri3d::Apps::Ota
@@ -0,0 +1,83 @@
+#include <cstdio>
+#include <cstring>
+
+#include "esp_timer.h"
+
+#include "fri3d_private/server_clock.hpp"
+
+namespace Fri3d::Apps::Ota
+{
+
+static const char *MONTHS[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+
+std::atomic<int64_t> CServerClock::offset(0);
+std::atomic<bool> CServerClock::known(false);
+
+static int64_t getUptime()
+{
+    return esp_timer_get_time() / 1000000;
+}
+
+// Days since 1970-01-01 of a date in the proleptic Gregorian calendar, newlib has no timegm()
+static int64_t getDays(int year, int month, int day)
+{
+    year -= month <= 2;
+    int64_t era = (year >= 0 ? year : year - 399) / 400;
+    int64_t yearOfEra = year - era * 400;
+    int64_t dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int64_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+
+    return era * 146097 + dayOfEra - 719468;
+}
+
+bool CServerClock::parse(const std::string &text, int64_t &time)
+{
+    int day, year, hour, minute, second;
+    char month[4];
+
+    if (sscanf(text.c_str(), "%*3s, %2d %3s %4d %2d:%2d:%2d GMT", &day, month, &year, &hour, &minute, &second) != 6)
+    {
+        return false;
+    }
+
+    for (int i = 0; i < 12; i++)
+    {
+        if (strcmp(month, MONTHS[i]) == 0)
+        {
+            if (day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60)
+            {
+                return false;
+            }
+
+            time = getDays(year, i + 1, day) * 86400 + hour * 3600 + minute * 60 + second;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void CServerClock::update(const std::string &date)
+{
+    int64_t time;
+    if (!CServerClock::parse(date, time))
+    {
+        return;
+    }
+
+    CServerClock::offset = time - getUptime();
+    CServerClock::known = true;
+}
+
+bool CServerClock::now(int64_t &time)
+{
+    if (!CServerClock::known)
+    {
+        return false;
+    }
+
+    time = CServerClock::offset + getUptime();
+    return true;
+}
+
+} // namespace Fri3d::Apps::Ota
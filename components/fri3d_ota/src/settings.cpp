@@ -0,0 +1,26 @@
+#include "fri3d_private/settings.hpp"
+
+namespace Fri3d::Apps::Ota::Settings
+{
+
+using Application::CSetting;
+using Application::SYS_NAMESPACE;
+
+CSetting<int32_t> bootPartition(SYS_NAMESPACE, "boot_partition", 0);
+CSetting<uint16_t> appVersion(SYS_NAMESPACE, "appVersion", 0);
+
+CSetting<std::string> microPython(SYS_NAMESPACE, "microPython", "");
+CSetting<std::string> retroGoLauncher(SYS_NAMESPACE, "rgLauncher", "");
+CSetting<std::string> retroGoCore(SYS_NAMESPACE, "rgCore", "");
+CSetting<std::string> retroGoPRBoom(SYS_NAMESPACE, "rgPRBoom", "");
+CSetting<std::string> vfs(SYS_NAMESPACE, "vfs", "");
+
+CSetting<std::string> resumeUrl(OTA_NAMESPACE, "resumeUrl", "");
+CSetting<std::string> resumePartition(OTA_NAMESPACE, "resumePart", "");
+CSetting<int32_t> resumeSize(OTA_NAMESPACE, "resumeSize", 0);
+CSetting<int32_t> resumeOffset(OTA_NAMESPACE, "resumeOffset", 0);
+
+CSetting<std::string> manifestETag(OTA_NAMESPACE, "manifestETag", "");
+CSetting<std::string> manifestModified(OTA_NAMESPACE, "manifestDate", "");
+
+} // namespace Fri3d::Apps::Ota::Settings
@@ -0,0 +1,130 @@
+#include <algorithm>
+#include <utility>
+
+#include "esp_log.h"
+
+#include "fri3d_private/source.hpp"
+
+namespace Fri3d::Apps::Ota
+{
+
+static const char *TAG = "Fri3d::Apps::Ota::CSource";
+
+CMemorySource::CMemorySource(const uint8_t *data, size_t size)
+    : data(data)
+    , size(size)
+    , position(0)
+    , end(size)
+{
+}
+
+bool CMemorySource::open(size_t offset, int length)
+{
+    if (offset > this->size || (length >= 0 && offset + length > this->size))
+    {
+        return false;
+    }
+
+    this->position = offset;
+    this->end = length >= 0 ? offset + length : this->size;
+
+    return true;
+}
+
+int CMemorySource::read(uint8_t *data, size_t length)
+{
+    length = std::min(length, this->end - this->position);
+    std::copy(this->data + this->position, this->data + this->position + length, data);
+    this->position += length;
+
+    return static_cast<int>(length);
+}
+
+void CMemorySource::close()
+{
+    this->position = this->end;
+}
+
+const char *CMemorySource::getName() const
+{
+    return "memory";
+}
+
+CFileSource::CFileSource(std::string path)
+    : path(std::move(path))
+    , file(nullptr)
+    , remaining(-1)
+{
+    esp_log_level_set(TAG, static_cast<esp_log_level_t>(LOG_LOCAL_LEVEL));
+}
+
+CFileSource::~CFileSource()
+{
+    this->close();
+}
+
+bool CFileSource::open(size_t offset, int length)
+{
+    this->close();
+
+    this->file = fopen(this->path.c_str(), "rb");
+    if (this->file == nullptr || fseek(this->file, static_cast<long>(offset), SEEK_SET) != 0)
+    {
+        ESP_LOGE(TAG, "Could not open %s at %d", this->path.c_str(), offset);
+        this->close();
+        return false;
+    }
+
+    this->remaining = length;
+
+    return true;
+}
+
+int CFileSource::read(uint8_t *data, size_t length)
+{
+    if (this->file == nullptr)
+    {
+        return -1;
+    }
+
+    if (this->remaining >= 0)
+    {
+        length = std::min(length, static_cast<size_t>(this->remaining));
+    }
+
+    auto read = fread(data, 1, length, this->file);
+    if (read < length && ferror(this->file))
+    {
+        ESP_LOGE(TAG, "Could not read %s", this->path.c_str());
+        return -1;
+    }
+
+    if (this->remaining >= 0)
+    {
+        if (read == 0 && length > 0)
+        {
+            ESP_LOGE(TAG, "%s is shorter than expected", this->path.c_str());
+            return -1;
+        }
+
+        this->remaining -= static_cast<int>(read);
+    }
+
+    return static_cast<int>(read);
+}
+
+void CFileSource::close()
+{
+    if (this->file != nullptr)
+    {
+        fclose(this->file);
+        this->file = nullptr;
+    }
+}
+
+const char *CFileSource::getName() const
+{
+    return this->path.c_str();
+}
+
+} // namespace Fri3d::Apps::Ota
@@ -0,0 +1,321 @@
+#include <cstdio>
+
+#include "esp_log.h"
+#include "esp_pthread.h"
+
+#include "fri3d_application/frame_stats.hpp"
+
+#include "fri3d_private/mirrors.hpp"
+#include "fri3d_private/server_clock.hpp"
+#include "fri3d_private/settings.hpp"
+#include "fri3d_private/update_job.hpp"
+
+namespace Fri3d::Apps::Ota
+{
+
+static const char *TAG = "Fri3d::Apps::Ota::CUpdateJob";
+
+using namespace std::chrono_literals;
+
+CDialogStatus::CDialogStatus(Application::LVGL::CWaitDialog &dialog)
+    : dialog(dialog)
+{
+}
+
+void CDialogStatus::setStatus(const char *status)
+{
+    this->dialog.setStatus(status);
+}
+
+void CDialogStatus::setProgress(float value)
+{
+    this->dialog.setProgress(value);
+}
+
+CUpdateJob::CIndicatorStatus::CIndicatorStatus(Application::LVGL::CStatusIndicator &indicator)
+    : indicator(indicator)
+{
+}
+
+void CUpdateJob::CIndicatorStatus::setStatus(const char *status)
+{
+}
+
+void CUpdateJob::CIndicatorStatus::setProgress(float value)
+{
+    char text[24];
+    snprintf(text, sizeof(text), LV_SYMBOL_DOWNLOAD " %d%%", static_cast<int>(value));
+
+    // The indicator only redraws when the text changes, so at most once per percent
+    this->indicator.setText(text);
+}
+
+CUpdateJob::CUpdateJob()
+    : http(nullptr)
+    , selection()
+    , stopping(false)
+    , state(Idle)
+{
+    esp_log_level_set(TAG, static_cast<esp_log_level_t>(LOG_LOCAL_LEVEL));
+}
+
+CUpdateJob::~CUpdateJob()
+{
+    this->stop();
+}
+
+bool CUpdateJob::flash(
+    Application::Hardware::IHttp &http,
+    const CFirmware &firmware,
+    const CSelection &selection,
+    IFlashStatus &status,
+    const CFlashThrottle &throttle)
+{
+    bool result = true;
+
+    // Shows where the time went and how well the UI kept up while flashing
+    CFlasher::resetStatistics();
+    Application::frameStats.reset();
+
+    for (const auto &image : firmware.images)
+    {
+        switch (image.imageType)
+        {
+        case CImage::Main:
+            if (selection.main)
+            {
+                if (!CFlasher::flash(http, image, status, throttle))
+                {
+                    result = false;
+                    ESP_LOGE(TAG, "Error flashing main firmware.");
+                }
+            }
+            break;
+        case CImage::MicroPython:
+            if (selection.microPython)
+            {
+                if (CFlasher::flash(http, image, "micropython", status, throttle))
+                {
+                    Settings::microPython.set(image.version.getText());
+                }
+                else
+                {
+                    result = false;
+                    ESP_LOGE(TAG, "Error flashing MicroPython");
+                }
+            }
+            break;
+        case CImage::RetroGoLauncher:
+            if (selection.retroGo)
+            {
+                if (CFlasher::flash(http, image, "launcher", status, throttle))
+                {
+                    Settings::retroGoLauncher.set(image.version.getText());
+                }
+                else
+                {
+                    result = false;
+                    ESP_LOGE(TAG, "Error flashing Retro-Go Launcher");
+                }
+            }
+            break;
+        case CImage::RetroGoCore:
+            if (selection.retroGo)
+            {
+                if (CFlasher::flash(http, image, "retro-core", status, throttle))
+                {
+                    Settings::retroGoCore.set(image.version.getText());
+                }
+                else
+                {
+                    result = false;
+                    ESP_LOGE(TAG, "Error flashing Retro-Go Core");
+                }
+            }
+            break;
+        case CImage::RetroGoPRBoom:
+            if (selection.retroGo)
+            {
+                if (CFlasher::flash(http, image, "prboom-go", status, throttle))
+                {
+                    Settings::retroGoPRBoom.set(image.version.getText());
+                }
+                else
+                {
+                    result = false;
+                    ESP_LOGE(TAG, "Error flashing Retro-Go Doom");
+                }
+            }
+            break;
+        case CImage::VFS:
+            if (selection.vfs)
+            {
+                if (CFlasher::flash(http, image, "vfs", status, throttle))
+                {
+                    Settings::vfs.set(image.version.getText());
+                }
+                else
+                {
+                    result = false;
+                    ESP_LOGE(TAG, "Error flashing VFS");
+                }
+            }
+            break;
+        }
+    }
+
+    CFlasher::getStatistics().print("Update");
+
+    auto statistics = http.getStatistics();
+    ESP_LOGI(TAG, "Sent %lu requests over %lu connections", statistics.requests, statistics.connections);
+    CMirrors::printStatistics();
+    Application::frameStats.print("UI during the update");
+
+    return result;
+}
+
+bool CUpdateJob::start(
+    Application::Hardware::IHttp &http,
+    const CFirmware &firmware,
+    const CSelection &selection,
+    COnFinished onFinished)
+{
+    if (this->state == Running)
+    {
+        return false;
+    }
+
+    if (this->thread.joinable())
+    {
+        this->thread.join();
+    }
+
+    // The job keeps its own copy, the OTA app releases its firmware list when it is reclaimed
+    this->http = &http;
+    this->firmware = firmware;
+    this->selection = selection;
+    this->onFinished = std::move(onFinished);
+    this->stopping = false;
+    this->state = Running;
+
+    // Same as the prefetcher: just above idle, and TLS handshakes need a deep stack
+    auto config = esp_pthread_get_default_config();
+    config.thread_name = "ota_update";
+    config.prio = 1;
+    config.stack_size = 8192;
+    esp_pthread_set_cfg(&config);
+
+    this->thread = std::thread(&CUpdateJob::run, this);
+
+    config = esp_pthread_get_default_config();
+    esp_pthread_set_cfg(&config);
+
+    ESP_LOGI(TAG, "Started updating to %s in the background", this->firmware.version.getText());
+
+    return true;
+}
+
+void CUpdateJob::stop()
+{
+    if (!this->thread.joinable())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard lock(this->stoppingMutex);
+        this->stopping = true;
+    }
+    this->stoppingChanged.notify_all();
+
+    this->thread.join();
+}
+
+void CUpdateJob::reset()
+{
+    this->stop();
+
+    this->indicator.hide();
+    this->state = Idle;
+}
+
+CUpdateJob::State CUpdateJob::getState() const
+{
+    return this->state;
+}
+
+bool CUpdateJob::waitForSlot()
+{
+    int64_t now;
+    if (this->firmware.rolloutWindow == 0 || !CServerClock::now(now))
+    {
+        return true;
+    }
+
+    auto slot = this->firmware.getSlot();
+    if (now >= slot)
+    {
+        return true;
+    }
+
+    ESP_LOGI(TAG, "Waiting %lu s for the rollout slot of this badge", static_cast<uint32_t>(slot - now));
+
+    char text[24];
+    std::unique_lock lock(this->stoppingMutex);
+
+    for (auto remaining = slot - now; remaining > 0; remaining--)
+    {
+        snprintf(
+            text,
+            sizeof(text),
+            LV_SYMBOL_DOWNLOAD " %lu:%02lu",
+            static_cast<uint32_t>(remaining / 60),
+            static_cast<uint32_t>(remaining % 60));
+        this->indicator.setText(text);
+
+        if (this->stoppingChanged.wait_for(lock, 1s, [this]() { return this->stopping; }))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void CUpdateJob::run()
+{
+    this->indicator.setText(LV_SYMBOL_DOWNLOAD);
+    this->indicator.show();
+
+    if (!this->waitForSlot())
+    {
+        ESP_LOGI(TAG, "Cancelled before the rollout slot");
+        this->indicator.hide();
+        this->state = Idle;
+        return;
+    }
+
+    CIndicatorStatus status(this->indicator);
+    bool result = CUpdateJob::flash(
+        *this->http,
+        this->firmware,
+        this->selection,
+        status,
+        {
+            .dutyCycle = CONFIG_FRI3D_OTA_BACKGROUND_DUTY,
+            .eraseSize = CONFIG_FRI3D_OTA_BACKGROUND_ERASE_SIZE,
+        });
+
+    ESP_LOGI(TAG, "Update to %s %s", this->firmware.version.getText(), result ? "finished" : "failed");
+
+    // Stays until the user restarts or opens the OTA app
+    this->indicator.setText(result ? LV_SYMBOL_OK " Restart" : LV_SYMBOL_WARNING " Update failed");
+    this->state = result ? Finished : Failed;
+
+    if (this->onFinished)
+    {
+        this->onFinished(result);
+    }
+}
+
+} // namespace Fri3d::Apps::Ota
@@ -0,0 +1,114 @@
+#include "esp_log.h"
+
+#include "fri3d_private/update_statistics.hpp"
+
+namespace Fri3d::Apps::Ota
+{
+
+static const char *TAG = "Fri3d::Apps::Ota::CUpdateStatistics";
+
+static uint32_t toMilliseconds(int64_t duration)
+{
+    return static_cast<uint32_t>(duration / 1000);
+}
+
+static uint32_t toKilobytesPerSecond(size_t bytes, int64_t duration)
+{
+    return duration > 0 ? static_cast<uint32_t>(static_cast<int64_t>(bytes) * 1000000 / duration / 1024) : 0;
+}
+
+CDownloadStatistics &CDownloadStatistics::operator+=(const CDownloadStatistics &other)
+{
+    this->connect += other.connect;
+    this->response += other.response;
+    this->receive += other.receive;
+    this->backoff += other.backoff;
+    this->received += other.received;
+    this->requests += other.requests;
+
+    return *this;
+}
+
+void CUpdateStatistics::add(const CPartitionWriter::CStatistics &writer, const CImageVerifier::CStatistics &verifier)
+{
+    this->erase += writer.erase;
+    this->write += writer.write;
+    this->idle += writer.idle;
+    this->rest += writer.rest;
+    this->erased += writer.erased;
+    this->written += writer.written;
+    this->hash += verifier.duration;
+    this->hashed += verifier.hashed;
+}
+
+CUpdateStatistics &CUpdateStatistics::operator+=(const CUpdateStatistics &other)
+{
+    this->images += other.images;
+    this->total += other.total;
+    this->check += other.check;
+    this->download += other.download;
+    this->decompress += other.decompress;
+    this->erase += other.erase;
+    this->write += other.write;
+    this->hash += other.hash;
+    this->idle += other.idle;
+    this->rest += other.rest;
+    this->erased += other.erased;
+    this->written += other.written;
+    this->hashed += other.hashed;
+    this->ui += other.ui;
+    this->progressUpdates += other.progressUpdates;
+
+    return *this;
+}
+
+void CUpdateStatistics::print(const char *title) const
+{
+    ESP_LOGI(
+        TAG,
+        "%s: %lu images, %d kB written in %lu ms (%lu kB/s), checking the partitions took %lu ms",
+        title,
+        this->images,
+        this->written / 1024,
+        toMilliseconds(this->total),
+        toKilobytesPerSecond(this->written, this->total),
+        toMilliseconds(this->check));
+
+    ESP_LOGI(
+        TAG,
+        "%s: downloaded %d kB with %lu requests: connecting %lu ms, waiting for responses %lu ms, receiving %lu ms "
+        "(%lu kB/s), pausing before retries %lu ms",
+        title,
+        this->download.received / 1024,
+        this->download.requests,
+        toMilliseconds(this->download.connect),
+        toMilliseconds(this->download.response),
+        toMilliseconds(this->download.receive),
+        toKilobytesPerSecond(this->download.received, this->download.receive),
+        toMilliseconds(this->download.backoff));
+
+    ESP_LOGI(
+        TAG,
+        "%s: erasing %d kB in %lu ms (%lu kB/s), writing %lu ms (%lu kB/s), hashing %lu ms (%lu kB/s), writer waiting "
+        "for data %lu ms, resting %lu ms",
+        title,
+        this->erased / 1024,
+        toMilliseconds(this->erase),
+        toKilobytesPerSecond(this->erased, this->erase),
+        toMilliseconds(this->write),
+        toKilobytesPerSecond(this->written, this->write),
+        toMilliseconds(this->hash),
+        toKilobytesPerSecond(this->hashed, this->hash),
+        toMilliseconds(this->idle),
+        toMilliseconds(this->rest));
+
+    ESP_LOGI(
+        TAG,
+        "%s: decompressing %lu ms, %lu progress updates %lu ms",
+        title,
+        toMilliseconds(this->decompress),
+        this->progressUpdates,
+        toMilliseconds(this->ui));
+}
+
+} // namespace Fri3d::Apps::Ota
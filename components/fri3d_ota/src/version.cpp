@@ -1,4 +1,7 @@
+#include <cctype>
+#include <cstdint>
 #include <cstring>
+#include <string_view>
 
 #include "esp_log.h"
 
@@ -9,83 +12,196 @@ namespace Fri3d::Apps::Ota
 
 static const char *TAG = "Fri3d::Apps::Ota::CVersion";
 
-CVersion::CVersion()
-    : CVersion("0.0.0")
+// Bits of every part in the key, larger parts saturate and are compared separately
+static const int PART_BITS = 21;
+static const uint32_t MAX_PART = (1 << PART_BITS) - 1;
+
+// Set in the key of a version without prerelease
+static const uint64_t RELEASE = 1;
+
+template <typename T> static int compareValues(T l, T r)
 {
+    return (l > r) - (l < r);
 }
 
-CVersion::CVersion(const CVersion &other)
-    : CVersion()
+static uint64_t saturate(uint32_t part)
 {
-    *this = other;
+    return part < MAX_PART ? part : MAX_PART;
 }
 
-CVersion::CVersion(const char *version)
-    : text(version)
-    , semver({})
+static bool isNumeric(std::string_view identifier)
 {
-    if (text.empty())
+    for (auto character : identifier)
     {
-        text = "0.0.0";
+        if (character < '0' || character > '9')
+        {
+            return false;
+        }
     }
 
-    auto result = semver_parse(this->text.c_str(), &this->semver);
+    return true;
+}
 
-    if (result != 0)
+// Saturates instead of overflowing, numbers that large are compared as equal
+static uint32_t toNumber(std::string_view digits)
+{
+    uint64_t value = 0;
+
+    for (auto character : digits)
+    {
+        value = value * 10 + (character - '0');
+        if (value > UINT32_MAX)
+        {
+            return UINT32_MAX;
+        }
+    }
+
+    return static_cast<uint32_t>(value);
+}
+
+CVersion::CVersion()
+    : CVersion("0.0.0")
+{
+}
+
+CVersion::CVersion(const char *version)
+    : text()
+    , key(0)
+    , major(0)
+    , minor(0)
+    , patch(0)
+    , prereleaseStart(0)
+    , prereleaseLength(0)
+{
+    this->setText(version);
+
+    if (!this->parse())
     {
         ESP_LOGW(TAG, "Could not parse version %s", version);
+        this->prereleaseLength = 0;
+        this->setParts(0, 0, 0);
     }
 }
 
-CVersion::~CVersion()
+CVersion::CVersion(const char *version, int major, int minor, int patch, const char *prerelease, const char *metadata)
+    : text()
+    , key(0)
+    , major(0)
+    , minor(0)
+    , patch(0)
+    , prereleaseStart(0)
+    , prereleaseLength(0)
 {
-    semver_free(&this->semver);
+    this->setText(version);
+
+    // Only the place of the prerelease in the text has to be found
+    if (prerelease != nullptr)
+    {
+        auto data = this->text.data();
+        auto end = strchr(data, '+');
+        auto start = strchr(data, '-');
+        auto length = strlen(prerelease);
+
+        if (start == nullptr || (end != nullptr && start > end) ||
+            static_cast<size_t>((end != nullptr ? end : data + strlen(data)) - start - 1) != length ||
+            strncmp(start + 1, prerelease, length) != 0)
+        {
+            ESP_LOGW(TAG, "Prerelease %s is not the one of %s, parsing it again", prerelease, this->text.data());
+            *this = CVersion(version);
+            return;
+        }
+
+        this->prereleaseStart = static_cast<uint8_t>(start + 1 - data);
+        this->prereleaseLength = static_cast<uint8_t>(length);
+    }
+
+    this->setParts(static_cast<uint32_t>(major), static_cast<uint32_t>(minor), static_cast<uint32_t>(patch));
 }
 
-CVersion &CVersion::operator=(const CVersion &other)
+void CVersion::setText(const char *version)
 {
-    if (this != &other)
+    if (version == nullptr || *version == '\0')
     {
-        this->text = other.text;
+        version = "0.0.0";
+    }
+
+    auto length = strnlen(version, MaxLength - 1);
+    memcpy(this->text.data(), version, length);
+    this->text[length] = '\0';
+}
 
-        semver_free(&this->semver);
+void CVersion::setParts(uint32_t major, uint32_t minor, uint32_t patch)
+{
+    this->major = major;
+    this->minor = minor;
+    this->patch = patch;
 
-        // There is no copy function for semver, so we do it ourselves
-        this->semver = other.semver;
+    this->key = saturate(major) << (PART_BITS * 2 + 1) | saturate(minor) << (PART_BITS + 1) | saturate(patch) << 1 |
+                (this->prereleaseLength == 0 ? RELEASE : 0);
+}
 
-        if (other.semver.metadata != nullptr)
+bool CVersion::parse()
+{
+    std::string_view version(this->text.data());
+
+    for (auto character : version)
+    {
+        if (!isalnum(static_cast<unsigned char>(character)) && character != '.' && character != '-' &&
+            character != '+')
         {
-            this->semver.metadata = static_cast<char *>(calloc(strlen(other.semver.metadata) + 1, sizeof(char *)));
-            strcpy(this->semver.metadata, other.semver.metadata);
+            return false;
         }
-        if (other.semver.prerelease != nullptr)
+    }
+
+    // Metadata starts at the first '+', the prerelease at the first '-' before it
+    auto core = version.substr(0, version.find('+'));
+    auto separator = core.find('-');
+    if (separator != std::string_view::npos)
+    {
+        this->prereleaseStart = static_cast<uint8_t>(separator + 1);
+        this->prereleaseLength = static_cast<uint8_t>(core.size() - separator - 1);
+        core = core.substr(0, separator);
+    }
+
+    // Missing parts are 0, "1.2" is 1.2.0
+    std::array<uint32_t, 3> parts = {};
+    for (size_t index = 0; index < parts.size() && !core.empty(); index++)
+    {
+        auto end = core.find('.');
+        auto part = core.substr(0, end);
+
+        if (!isNumeric(part))
         {
-            this->semver.prerelease = static_cast<char *>(calloc(strlen(other.semver.prerelease) + 1, sizeof(char *)));
-            strcpy(this->semver.prerelease, other.semver.prerelease);
+            return false;
         }
+
+        parts[index] = toNumber(part);
+        core = end == std::string_view::npos ? std::string_view() : core.substr(end + 1);
     }
 
-    return *this;
-}
+    if (!core.empty())
+    {
+        return false;
+    }
 
-CVersion &CVersion::operator=(CVersion &&other) noexcept
-{
-    this->text = std::move(other.text);
+    this->setParts(parts[0], parts[1], parts[2]);
 
-    this->semver = other.semver;
-    other.semver = {};
+    return true;
+}
 
-    return *this;
+bool CVersion::isLarge() const
+{
+    return this->major > MAX_PART || this->minor > MAX_PART || this->patch > MAX_PART;
 }
 
 CVersion CVersion::simplify() const
 {
-    CVersion result;
+    CVersion result = *this;
 
-    result.semver = this->semver;
-    result.semver.metadata = nullptr;
-    result.semver.prerelease = nullptr;
-    result.text = std::string(this->text, 0, this->text.find('-'));
+    result.text[strcspn(result.text.data(), "-")] = '\0';
+    result.prereleaseStart = 0;
+    result.prereleaseLength = 0;
+    result.setParts(this->major, this->minor, this->patch);
 
     return result;
 }
@@ -95,19 +211,91 @@ bool CVersion::empty() const
     return *this == CVersion();
 }
 
+const char *CVersion::getText() const
+{
+    return this->text.data();
+}
+
+int CVersion::comparePrerelease(const CVersion &l, const CVersion &r)
+{
+    std::string_view x(l.text.data() + l.prereleaseStart, l.prereleaseLength);
+    std::string_view y(r.text.data() + r.prereleaseStart, r.prereleaseLength);
+
+    // Identifier by identifier: numbers are compared as numbers and come before text, a longer list wins when the
+    // shorter one is its start
+    while (true)
+    {
+        auto xEnd = x.find('.');
+        auto yEnd = y.find('.');
+        auto xIdentifier = x.substr(0, xEnd);
+        auto yIdentifier = y.substr(0, yEnd);
+
+        bool xNumeric = isNumeric(xIdentifier);
+        bool yNumeric = isNumeric(yIdentifier);
+        if (xNumeric != yNumeric)
+        {
+            return xNumeric ? -1 : 1;
+        }
+
+        int result = xNumeric ? compareValues(toNumber(xIdentifier), toNumber(yIdentifier))
+                              : compareValues(xIdentifier.compare(yIdentifier), 0);
+        if (result != 0)
+        {
+            return result;
+        }
+
+        if (xEnd == std::string_view::npos || yEnd == std::string_view::npos)
+        {
+            return compareValues(xEnd != std::string_view::npos, yEnd != std::string_view::npos);
+        }
+
+        x = x.substr(xEnd + 1);
+        y = y.substr(yEnd + 1);
+    }
+}
+
+int CVersion::compare(const CVersion &l, const CVersion &r)
+{
+    int result = compareValues(l.key, r.key);
+    if (result != 0)
+    {
+        return result;
+    }
+
+    // The keys are only equal for different parts when those didn't fit, then both are large
+    if (l.isLarge())
+    {
+        result = compareValues(l.major, r.major);
+        result = result != 0 ? result : compareValues(l.minor, r.minor);
+        result = result != 0 ? result : compareValues(l.patch, r.patch);
+        if (result != 0)
+        {
+            return result;
+        }
+    }
+
+    // Equal keys are either both releases or both prereleases
+    if ((l.key & RELEASE) != 0)
+    {
+        return 0;
+    }
+
+    return CVersion::comparePrerelease(l, r);
+}
+
 bool CVersion::operator==(const CVersion &other) const
 {
-    return semver_eq(this->semver, other.semver);
+    return CVersion::compare(*this, other) == 0;
 }
 
 bool operator<(const CVersion &l, const CVersion &r)
 {
-    return semver_compare(l.semver, r.semver) == -1;
+    return CVersion::compare(l, r) < 0;
 }
 
 bool operator>(const CVersion &l, const CVersion &r)
 {
-    return semver_compare(l.semver, r.semver) == 1;
+    return CVersion::compare(l, r) > 0;
 }
 
 } // namespace Fri3d::Apps::Ota
@@ -28,6 +28,7 @@ public:
 
     [[nodiscard]] const char *getName() const override;
     [[nodiscard]] bool getVisible() const override;
+    [[nodiscard]] bool getReclaimable() const override;
 
     void activate() override;
     void deactivate() override;
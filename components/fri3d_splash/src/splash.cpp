@@ -126,6 +126,11 @@ bool CSplash::getVisible() const
     return false;
 }
 
+bool CSplash::getReclaimable() const
+{
+    return true;
+}
+
 static CSplash splash_impl;
 Application::CBaseApp &splash = splash_impl;
 
@@ -0,0 +1,365 @@
+# Converts a versions manifest from JSON to the compact binary format read by CBinaryManifestParser.
+#
+# Serve the result next to the JSON manifest with the same name and the .f3dm extension: tools/ota_server.py sends it to
+# badges that ask for it in their Accept header. The layout is documented in binary_manifest_parser.hpp. After writing,
+# the file is decoded again and compared to the JSON manifest, then the sizes are printed. The badge logs how long it
+# took to parse either format.
+import argparse
+import gzip
+import json
+import re
+
+MAGIC = b"F3DM"
+FORMAT_VERSION = 1
+
+RECORD_END = 0x00
+RECORD_STRING = 0x01
+RECORD_FIRMWARE = 0x02
+
+# Same order as CImage::ImageType and CImage::Encoding
+TYPES = ["main", "micropython", "retro-launcher", "retro-core", "retro-prboom", "vfs"]
+ENCODINGS = ["raw", "zlib"]
+
+FIRMWARE_BETA = 0x01
+FIRMWARE_ROLLOUT = 0x02
+FIRMWARE_MIRRORS = 0x04
+
+VERSION_PARSED = 0x01
+VERSION_PRERELEASE = 0x02
+VERSION_METADATA = 0x04
+
+IMAGE_HASH = 0x01
+IMAGE_BLOCKS = 0x02
+
+VERSION_CHARACTERS = re.compile(r"[0-9A-Za-z.+-]+")
+
+
+def usable_image(image):
+    return (
+        image.get("type") in TYPES
+        and image.get("encoding", "raw") in ENCODINGS
+        and all(key in image for key in ("version", "url"))
+    )
+
+
+def usable_patch(patch):
+    return patch.get("encoding", "raw") in ENCODINGS and all(
+        key in patch for key in ("from", "fromSize", "fromSha256", "url")
+    )
+
+
+def rollout(node):
+    """Rollout start and window of a firmware, None when it has neither"""
+    if "rolloutStart" not in node and "rolloutWindow" not in node:
+        return None
+    return int(node.get("rolloutStart", 0)), int(node.get("rolloutWindow", 0))
+
+
+def varint(value):
+    result = bytearray()
+    while True:
+        byte = value & 0x7F
+        value >>= 7
+        if value:
+            result.append(byte | 0x80)
+        else:
+            result.append(byte)
+            return bytes(result)
+
+
+def parse_semver(text):
+    # Mirrors semver_parse() on the badge, anything it wouldn't parse the same way is left to the badge
+    if not VERSION_CHARACTERS.fullmatch(text):
+        return None
+
+    core, plus, metadata = text.partition("+")
+    core, minus, prerelease = core.partition("-")
+    numbers = core.split(".")
+
+    if len(numbers) != 3 or not all(number.isdigit() and len(number) <= 9 for number in numbers):
+        return None
+
+    return (
+        [int(number) for number in numbers],
+        prerelease if minus else None,
+        metadata if plus else None,
+    )
+
+
+class Writer:
+    def __init__(self):
+        self.output = bytearray(MAGIC + bytes([FORMAT_VERSION]))
+        self.strings = {}
+
+    def record(self, kind, payload):
+        self.output += bytes([kind]) + varint(len(payload)) + payload
+
+    def string(self, text):
+        # Strings are defined right before the first firmware that uses them
+        if text not in self.strings:
+            self.strings[text] = len(self.strings)
+            self.record(RECORD_STRING, text.encode())
+
+        return varint(self.strings[text])
+
+    def version(self, text):
+        result = self.string(text)
+        parsed = parse_semver(text)
+
+        if parsed is None:
+            return result + bytes([0])
+
+        numbers, prerelease, metadata = parsed
+        flags = VERSION_PARSED
+        extra = b""
+
+        if prerelease is not None:
+            flags |= VERSION_PRERELEASE
+            extra += self.string(prerelease)
+        if metadata is not None:
+            flags |= VERSION_METADATA
+            extra += self.string(metadata)
+
+        return result + bytes([flags]) + b"".join(varint(number) for number in numbers) + extra
+
+    def url(self, url):
+        # The directory part is shared by most images of a release, the file name by the same image in all releases
+        prefix, _, name = url.rpartition("/")
+        prefix = prefix + "/" if _ else ""
+        return self.string(prefix) + self.string(name)
+
+    def image(self, node):
+        result = bytes([TYPES.index(node["type"])])
+        result += self.version(node["version"])
+        result += self.url(node["url"])
+        result += varint(node["size"] + 1 if isinstance(node.get("size"), int) and node["size"] >= 0 else 0)
+        result += bytes([ENCODINGS.index(node.get("encoding", "raw"))])
+
+        flags = 0
+        hashes = b""
+        if "sha256" in node:
+            flags |= IMAGE_HASH
+            hashes += bytes.fromhex(node["sha256"])
+        if "blocks" in node and "blockSize" in node:
+            flags |= IMAGE_BLOCKS
+            hashes += varint(node["blockSize"]) + varint(len(node["blocks"]))
+            hashes += b"".join(bytes.fromhex(block) for block in node["blocks"])
+        result += bytes([flags]) + hashes
+
+        patches = [patch for patch in node.get("patches", []) if usable_patch(patch)]
+        result += varint(len(patches))
+        for patch in patches:
+            result += self.string(patch["from"])
+            result += varint(patch["fromSize"])
+            result += bytes.fromhex(patch["fromSha256"])
+            result += self.url(patch["url"])
+            result += varint(patch["size"] + 1 if "size" in patch else 0)
+            result += bytes([ENCODINGS.index(patch.get("encoding", "raw"))])
+
+        return result
+
+    def firmware(self, node):
+        images = [image for image in node["images"] if usable_image(image)]
+
+        slot = rollout(node)
+        mirrors = any(image.get("mirrors") for image in images)
+
+        flags = FIRMWARE_BETA if node.get("beta") else 0
+        if slot:
+            flags |= FIRMWARE_ROLLOUT
+        if mirrors:
+            flags |= FIRMWARE_MIRRORS
+
+        payload = bytes([flags])
+        payload += self.version(node["version"])
+        payload += varint(len(images))
+        payload += b"".join(self.image(image) for image in images)
+        if slot:
+            payload += varint(slot[0]) + varint(slot[1])
+        if mirrors:
+            for image in images:
+                bases = image.get("mirrors", [])
+                payload += varint(len(bases)) + b"".join(self.string(base) for base in bases)
+
+        self.record(RECORD_FIRMWARE, payload)
+
+    def finish(self):
+        self.record(RECORD_END, b"")
+        return bytes(self.output)
+
+
+class Reader:
+    def __init__(self, data):
+        self.data = data
+        self.position = 0
+
+    def byte(self):
+        self.position += 1
+        return self.data[self.position - 1]
+
+    def varint(self):
+        value, shift = 0, 0
+        while True:
+            byte = self.byte()
+            value |= (byte & 0x7F) << shift
+            shift += 7
+            if not byte & 0x80:
+                return value
+
+    def bytes(self, length):
+        self.position += length
+        return self.data[self.position - length : self.position]
+
+
+def decode(data):
+    """Decode a binary manifest back into JSON, without the fields that only exist to save the badge some work"""
+    assert data[:4] == MAGIC and data[4] == FORMAT_VERSION
+    reader = Reader(data)
+    reader.position = 5
+    strings = []
+    firmwares = []
+
+    def string(r):
+        return strings[r.varint()]
+
+    def version(r):
+        text = string(r)
+        flags = r.byte()
+        if flags & VERSION_PARSED:
+            for _ in range(3):
+                r.varint()
+            if flags & VERSION_PRERELEASE:
+                string(r)
+            if flags & VERSION_METADATA:
+                string(r)
+        return text
+
+    while True:
+        kind = reader.byte()
+        payload = Reader(reader.bytes(reader.varint()))
+
+        if kind == RECORD_END:
+            return firmwares
+        if kind == RECORD_STRING:
+            strings.append(payload.data.decode())
+            continue
+
+        firmware_flags = payload.byte()
+        firmware = {"version": None, "beta": bool(firmware_flags & FIRMWARE_BETA), "images": []}
+        firmware["version"] = version(payload)
+
+        for _ in range(payload.varint()):
+            image = {"type": TYPES[payload.byte()], "version": version(payload)}
+            image["url"] = string(payload) + string(payload)
+            size = payload.varint()
+            if size:
+                image["size"] = size - 1
+            image["encoding"] = ENCODINGS[payload.byte()]
+
+            flags = payload.byte()
+            if flags & IMAGE_HASH:
+                image["sha256"] = payload.bytes(32).hex()
+            if flags & IMAGE_BLOCKS:
+                image["blockSize"] = payload.varint()
+                image["blocks"] = [payload.bytes(32).hex() for _ in range(payload.varint())]
+
+            patches = []
+            for _ in range(payload.varint()):
+                patch = {"from": string(payload), "fromSize": payload.varint(), "fromSha256": payload.bytes(32).hex()}
+                patch["url"] = string(payload) + string(payload)
+                size = payload.varint()
+                if size:
+                    patch["size"] = size - 1
+                patch["encoding"] = ENCODINGS[payload.byte()]
+                patches.append(patch)
+            if patches:
+                image["patches"] = patches
+
+            firmware["images"].append(image)
+
+        if firmware_flags & FIRMWARE_ROLLOUT:
+            firmware["rolloutStart"] = payload.varint()
+            firmware["rolloutWindow"] = payload.varint()
+
+        if firmware_flags & FIRMWARE_MIRRORS:
+            for image in firmware["images"]:
+                bases = [string(payload) for _ in range(payload.varint())]
+                if bases:
+                    image["mirrors"] = bases
+
+        firmwares.append(firmware)
+
+
+def normalize(manifest):
+    """The JSON manifest as decode() returns it: known images only, explicit defaults"""
+    result = []
+    for node in manifest:
+        images = []
+        for image in node["images"]:
+            if not usable_image(image):
+                continue
+
+            copy = {key: image[key] for key in ("type", "version", "url", "sha256") if key in image}
+            if image.get("mirrors"):
+                copy["mirrors"] = image["mirrors"]
+            if isinstance(image.get("size"), int) and image["size"] >= 0:
+                copy["size"] = image["size"]
+            copy["encoding"] = image.get("encoding", "raw")
+            if "blocks" in image and "blockSize" in image:
+                copy["blockSize"] = image["blockSize"]
+                copy["blocks"] = image["blocks"]
+
+            patches = []
+            for patch in image.get("patches", []):
+                if not usable_patch(patch):
+                    continue
+                patch = dict(patch)
+                patch["encoding"] = patch.get("encoding", "raw")
+                patches.append(patch)
+            if patches:
+                copy["patches"] = patches
+
+            images.append(copy)
+
+        copy = {"version": node["version"], "beta": bool(node.get("beta")), "images": images}
+        slot = rollout(node)
+        if slot:
+            copy["rolloutStart"], copy["rolloutWindow"] = slot
+
+        result.append(copy)
+
+    return result
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Convert a JSON versions manifest to the binary format")
+    parser.add_argument("input", help="JSON manifest")
+    parser.add_argument("output", help="binary manifest to write, usually the same name with .f3dm")
+    args = parser.parse_args()
+
+    with open(args.input, "rb") as f:
+        text = f.read()
+
+    manifest = json.loads(text)
+
+    writer = Writer()
+    for node in manifest:
+        if "version" in node and isinstance(node.get("images"), list):
+            writer.firmware(node)
+    data = writer.finish()
+
+    with open(args.output, "wb") as f:
+        f.write(data)
+
+    decoded = decode(data)
+    expected = normalize([node for node in manifest if "version" in node and isinstance(node.get("images"), list)])
+    if decoded != expected:
+        raise SystemExit("Decoded binary manifest does not match the JSON manifest")
+
+    print(f"{len(manifest)} releases, {len(writer.strings)} unique strings")
+    print(f"JSON:   {len(text):>10} bytes, {len(gzip.compress(text)):>10} gzipped")
+    print(f"Binary: {len(data):>10} bytes, {len(gzip.compress(data)):>10} gzipped")
+
+
+if __name__ == "__main__":
+    main()
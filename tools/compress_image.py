@@ -0,0 +1,84 @@
+# Compresses an OTA image for the update server and prints the fields to add to the image in the update manifest.
+#
+# The badge decompresses with the inflate implementation in its ROM, which uses a 32 KB window, so the data is written
+# as a zlib stream with the default window size.
+import argparse
+import json
+import time
+import zlib
+
+from image_hashes import image_hashes
+
+
+def compress(source, destination, level):
+    with open(source, "rb") as f:
+        data = f.read()
+
+    compressed = zlib.compress(data, level)
+
+    with open(destination, "wb") as f:
+        f.write(compressed)
+
+    return len(data), len(compressed)
+
+
+def benchmark(path, runs, chunk_size):
+    # Mimics the badge: the stream is fed in network sized chunks and the output never exceeds the window
+    with open(path, "rb") as f:
+        compressed = f.read()
+
+    best = None
+    size = 0
+
+    for _ in range(runs):
+        start = time.perf_counter()
+        decompressor = zlib.decompressobj()
+        size = 0
+
+        for offset in range(0, len(compressed), chunk_size):
+            data = decompressor.decompress(compressed[offset : offset + chunk_size], 32768)
+            size += len(data)
+
+            while decompressor.unconsumed_tail:
+                data = decompressor.decompress(decompressor.unconsumed_tail, 32768)
+                size += len(data)
+
+        size += len(decompressor.flush())
+
+        duration = time.perf_counter() - start
+        best = duration if best is None else min(best, duration)
+
+    return size, best
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compress an OTA image")
+    parser.add_argument("image", help="image to compress")
+    parser.add_argument("output", help="compressed image to write")
+    parser.add_argument("--level", type=int, default=9, help="zlib compression level")
+    parser.add_argument("--block-size", type=int, default=65536, help="size of the blocks for the block hashes")
+    parser.add_argument("--benchmark", type=int, default=0, metavar="RUNS", help="measure decompression throughput")
+    parser.add_argument("--chunk-size", type=int, default=4096, help="size of the input chunks for the benchmark")
+    args = parser.parse_args()
+
+    size, compressed = compress(args.image, args.output, args.level)
+
+    fields = image_hashes(args.image, args.block_size)
+    fields["encoding"] = "zlib"
+
+    print(json.dumps(fields, indent=2))
+    print(f"Compressed {size} bytes to {compressed} bytes ({compressed / size * 100:.1f}%)")
+
+    if args.benchmark > 0:
+        decompressed, duration = benchmark(args.output, args.benchmark, args.chunk_size)
+        if decompressed != size:
+            raise SystemExit(f"Decompressed size {decompressed} does not match the image size {size}")
+
+        print(
+            f"Decompressed in {duration * 1000:.1f} ms, {size / duration / 1024 / 1024:.1f} MB/s of output, "
+            f"{compressed / duration / 1024 / 1024:.1f} MB/s of input (best of {args.benchmark})"
+        )
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,189 @@
+# Creates and applies delta patches for the main firmware image, see CPatcher in the fri3d_ota component for the format.
+#
+#   make:  create a patch from the image currently on the badges to a new image, prints the manifest entry for it
+#   apply: apply a patch to a file, the same way the badge applies it to its flash partitions
+import argparse
+import hashlib
+import json
+import struct
+import zlib
+
+MAGIC = b"F3DP"
+
+OP_END = 0x00
+OP_COPY = 0x01
+OP_DATA = 0x02
+
+# Matches are searched on blocks of this size, shorter matches are not worth a COPY
+BLOCK_SIZE = 32
+
+# Offset of the version in esp_app_desc_t, which follows the image and segment headers
+APP_DESC_OFFSET = 24 + 8
+APP_DESC_MAGIC = 0xABCD5432
+
+
+def app_version(image):
+    magic = struct.unpack_from("<I", image, APP_DESC_OFFSET)[0]
+    if magic != APP_DESC_MAGIC:
+        return None
+
+    return image[APP_DESC_OFFSET + 16 : APP_DESC_OFFSET + 48].split(b"\0")[0].decode()
+
+
+def make_patch(source, target):
+    index = {}
+    for offset in range(0, len(source) - BLOCK_SIZE + 1, BLOCK_SIZE):
+        index.setdefault(source[offset : offset + BLOCK_SIZE], offset)
+
+    operations = []
+    literal_start = 0
+    position = 0
+
+    def emit_data(end):
+        if end > literal_start:
+            operations.append((OP_DATA, literal_start, end - literal_start))
+
+    while position + BLOCK_SIZE <= len(target):
+        match = index.get(target[position : position + BLOCK_SIZE])
+        if match is None:
+            position += 1
+            continue
+
+        # Extend the match in both directions
+        start, source_start = position, match
+        while start > literal_start and source_start > 0 and target[start - 1] == source[source_start - 1]:
+            start -= 1
+            source_start -= 1
+
+        end, source_end = position + BLOCK_SIZE, match + BLOCK_SIZE
+        while end < len(target) and source_end < len(source) and target[end] == source[source_end]:
+            end += 1
+            source_end += 1
+
+        emit_data(start)
+        operations.append((OP_COPY, source_start, end - start))
+
+        position = end
+        literal_start = end
+
+    emit_data(len(target))
+
+    patch = bytearray(MAGIC + struct.pack("<II", len(source), len(target)))
+    for operation, offset, length in operations:
+        if operation == OP_COPY:
+            patch += struct.pack("<BII", OP_COPY, offset, length)
+        else:
+            patch += struct.pack("<BI", OP_DATA, length) + target[offset : offset + length]
+    patch.append(OP_END)
+
+    return bytes(patch)
+
+
+def apply_patch(source, patch):
+    if patch[:4] != MAGIC:
+        raise ValueError("wrong magic")
+
+    source_size, target_size = struct.unpack_from("<II", patch, 4)
+    if source_size != len(source):
+        raise ValueError("made for another source")
+
+    target = bytearray()
+    position = 12
+
+    while True:
+        operation = patch[position]
+        position += 1
+
+        if operation == OP_END:
+            break
+        elif operation == OP_COPY:
+            offset, length = struct.unpack_from("<II", patch, position)
+            position += 8
+            if offset + length > len(source):
+                raise ValueError("copy beyond the end of the source")
+            target += source[offset : offset + length]
+        elif operation == OP_DATA:
+            length = struct.unpack_from("<I", patch, position)[0]
+            position += 4
+            target += patch[position : position + length]
+            position += length
+        else:
+            raise ValueError("unknown operation")
+
+    if len(target) != target_size:
+        raise ValueError("target is incomplete")
+
+    return bytes(target)
+
+
+def read(path):
+    with open(path, "rb") as f:
+        return f.read()
+
+
+def write(path, data):
+    with open(path, "wb") as f:
+        f.write(data)
+
+
+def command_make(args):
+    source = read(args.source)
+    target = read(args.target)
+
+    patch = make_patch(source, target)
+
+    # Never publish a patch that doesn't reproduce the target
+    if apply_patch(source, patch) != target:
+        raise SystemExit("Patch does not reproduce the target image")
+
+    data = zlib.compress(patch, 9) if args.zlib else patch
+    write(args.patch, data)
+
+    entry = {
+        "from": args.source_version or app_version(source),
+        "fromSize": len(source),
+        "fromSha256": hashlib.sha256(source).hexdigest(),
+        "url": args.url or "",
+        "size": len(data),
+    }
+    if args.zlib:
+        entry["encoding"] = "zlib"
+
+    print(json.dumps(entry, indent=2))
+    print(f"Patch is {len(data)} bytes, {len(data) / len(target) * 100:.1f}% of the target image")
+
+
+def command_apply(args):
+    patch = read(args.patch)
+    if args.zlib:
+        patch = zlib.decompress(patch)
+
+    write(args.output, apply_patch(read(args.source), patch))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Create and apply delta patches for the main firmware")
+    commands = parser.add_subparsers(required=True)
+
+    make = commands.add_parser("make", help="create a patch")
+    make.add_argument("source", help="image currently installed")
+    make.add_argument("target", help="new image")
+    make.add_argument("patch", help="patch to write")
+    make.add_argument("--zlib", action="store_true", help="compress the patch")
+    make.add_argument("--url", help="URL the patch will be published on")
+    make.add_argument("--source-version", help="version of the source image, read from the image by default")
+    make.set_defaults(function=command_make)
+
+    apply = commands.add_parser("apply", help="apply a patch")
+    apply.add_argument("source", help="image to patch, for example a copy of the ota_0 partition")
+    apply.add_argument("patch", help="patch to apply")
+    apply.add_argument("output", help="patched image to write")
+    apply.add_argument("--zlib", action="store_true", help="the patch is compressed")
+    apply.set_defaults(function=command_apply)
+
+    args = parser.parse_args()
+    args.function(args)
+
+
+if __name__ == "__main__":
+    main()
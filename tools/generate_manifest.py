@@ -0,0 +1,70 @@
+# Generates a versions manifest with many synthetic releases, to measure how the badge copes with a growing manifest.
+#
+# Every release gets the same images as the real manifest, with block hashes and a patch for `main`. Serve the result
+# with tools/ota_server.py and point FRI3D_VERSIONS_URL at it: the badge logs how long fetching and parsing took.
+import argparse
+import hashlib
+import json
+
+IMAGES = ["main", "micropython", "retro-launcher", "retro-core", "retro-prboom", "vfs"]
+BLOCK_SIZE = 65536
+
+
+def digest(*parts):
+    return hashlib.sha256("/".join(str(part) for part in parts).encode()).hexdigest()
+
+
+def release(index, base_url, block_hashes):
+    version = f"1.{index // 100}.{index % 100}"
+    images = []
+
+    for name in IMAGES:
+        size = 1024 * 1024 + index * 4096
+        image = {
+            "type": name,
+            "version": version,
+            "url": f"{base_url}/{version}/{name}.bin",
+            "size": size,
+            "sha256": digest(name, version),
+        }
+
+        if block_hashes:
+            image["blockSize"] = BLOCK_SIZE
+            image["blocks"] = [digest(name, version, block) for block in range((size + BLOCK_SIZE - 1) // BLOCK_SIZE)]
+
+        if name == "main" and index > 0:
+            previous = f"1.{(index - 1) // 100}.{(index - 1) % 100}"
+            image["patches"] = [
+                {
+                    "from": previous,
+                    "fromSize": size - 4096,
+                    "fromSha256": digest(name, previous),
+                    "url": f"{base_url}/{version}/main-from-{previous}.patch",
+                    "size": 65536,
+                    "encoding": "zlib",
+                }
+            ]
+
+        images.append(image)
+
+    return {"version": version, "beta": index % 3 == 0, "images": images}
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Generate a large versions manifest")
+    parser.add_argument("output", help="manifest to write")
+    parser.add_argument("--versions", type=int, default=1000, help="number of releases")
+    parser.add_argument("--url", default="http://192.168.1.10:8000", help="base URL of the images")
+    parser.add_argument("--no-blocks", action="store_true", help="leave out the block hashes")
+    args = parser.parse_args()
+
+    manifest = [release(index, args.url, not args.no_blocks) for index in range(args.versions)]
+
+    with open(args.output, "w") as f:
+        json.dump(manifest, f, indent=2)
+
+    print(f"Wrote {args.versions} releases to {args.output}")
+
+
+if __name__ == "__main__":
+    main()
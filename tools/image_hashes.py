@@ -0,0 +1,44 @@
+# Calculates the hashes used for delta flashing, prints the fields to add to an image in the update manifest.
+import argparse
+import hashlib
+import json
+import os
+
+
+def image_hashes(path, block_size):
+    blocks = []
+    image = hashlib.sha256()
+
+    with open(path, "rb") as f:
+        while True:
+            block = f.read(block_size)
+            if not block:
+                break
+
+            image.update(block)
+            blocks.append(hashlib.sha256(block).hexdigest())
+
+    return {
+        "size": os.path.getsize(path),
+        "sha256": image.hexdigest(),
+        "blockSize": block_size,
+        "blocks": blocks,
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Calculate the hashes of an OTA image")
+    parser.add_argument("image", help="image to hash")
+    parser.add_argument(
+        "--block-size", type=int, default=65536, help="size of the blocks, has to be a multiple of 4096"
+    )
+    args = parser.parse_args()
+
+    if args.block_size <= 0 or args.block_size % 4096 != 0:
+        parser.error("the block size has to be a multiple of 4096")
+
+    print(json.dumps(image_hashes(args.image, args.block_size), indent=2))
+
+
+if __name__ == "__main__":
+    main()
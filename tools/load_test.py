@@ -0,0 +1,190 @@
+# Simulates a crowd of badges checking for and downloading an update at the same moment, like at camp right after a
+# release is announced, to see how the retry policy copes with an overloaded server.
+#
+# Start tools/ota_server.py with --capacity to make it turn away requests with 503 and Retry-After, then run this
+# against the JSON manifest it serves, for example:
+#
+#   tools/ota_server.py build/ota --capacity 20 --rate 200
+#   tools/load_test.py http://localhost:8000/firmware-fox.json --badges 500 --download
+#
+# Every badge is a thread that follows the same rules as CRetryPolicy and CFirmware::getSlot() on the badge:
+# exponential backoff with jitter, Retry-After honored up to --max-delay and rollout slots from the manifest, measured
+# against the Date header of the server. With --policy linear the badges retry like older firmware did instead: one
+# second longer after every attempt, without looking at Retry-After.
+import argparse
+import email.utils
+import http.client
+import json
+import random
+import statistics
+import threading
+import time
+import urllib.parse
+
+
+class Stats:
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.requests = 0
+        self.busy = 0
+        self.errors = 0
+        self.times = []
+        self.failed = 0
+        self.starts = []
+
+    def add(self, **counts):
+        with self.lock:
+            for key, value in counts.items():
+                setattr(self, key, getattr(self, key) + value)
+
+
+class Policy:
+    """Mirror of CRetryPolicy"""
+
+    def __init__(self, args):
+        self.args = args
+        self.attempt = 0
+        self.retry_after = 0.0
+
+    def update(self, response):
+        value = response.getheader("Retry-After")
+        if value is None or self.args.policy == "linear":
+            self.retry_after = 0.0
+        elif value.isdigit():
+            self.retry_after = float(value)
+        else:
+            date = email.utils.parsedate_to_datetime(value).timestamp()
+            now = email.utils.parsedate_to_datetime(response.getheader("Date")).timestamp()
+            self.retry_after = max(date - now, 0.0)
+
+    def wait(self):
+        if self.attempt >= self.args.retries or self.retry_after > self.args.max_delay:
+            return False
+
+        if self.args.policy == "linear":
+            delay = self.attempt + 1
+        else:
+            backoff = min(self.args.delay / 1000 * 2**self.attempt, self.args.max_delay)
+            spread = random.uniform(0, backoff / 2)
+            delay = self.retry_after + spread if self.retry_after else backoff / 2 + spread
+
+        self.attempt += 1
+        self.retry_after = 0.0
+        time.sleep(delay * self.args.time_scale)
+        return True
+
+
+def get_slot(release, mac):
+    """Mirror of CFirmware::getSlot()"""
+    start, window = release.get("rolloutStart", 0), release.get("rolloutWindow", 0)
+    if not window:
+        return start
+
+    value = 2166136261
+    for byte in mac + release["version"].encode():
+        value = ((value ^ byte) * 16777619) & 0xFFFFFFFF
+    return start + value % window
+
+
+def request(url, args, stats, consume):
+    """GET with retries, the body is passed to consume(), returns the response or None when giving up"""
+    policy = Policy(args)
+    parts = urllib.parse.urlsplit(url)
+
+    while True:
+        connection = http.client.HTTPConnection(parts.hostname, parts.port or 80, timeout=args.timeout)
+        stats.add(requests=1)
+        with stats.lock:
+            stats.starts.append(time.monotonic())
+
+        try:
+            connection.request("GET", parts.path or "/")
+            response = connection.getresponse()
+            policy.update(response)
+
+            if response.status in (429, 503) or response.status >= 500:
+                response.read()
+                stats.add(busy=1)
+            elif response.status == 200:
+                consume(response)
+                return response
+            else:
+                return None
+        except OSError:
+            stats.add(errors=1)
+        finally:
+            connection.close()
+
+        if not policy.wait():
+            return None
+
+
+def badge(args, stats):
+    begin = time.monotonic()
+    mac = random.randbytes(6)
+
+    # The background checks of badges that were turned on around the same time are spread a little
+    time.sleep(random.uniform(0, args.spread) * args.time_scale)
+
+    body = []
+    response = request(args.url, args, stats, lambda r: body.append(r.read()))
+    ok = response is not None
+
+    if ok and args.download:
+        releases = json.loads(body[0])
+        release = max(releases, key=lambda r: [int(x) for x in r["version"].split("-")[0].split(".")[:3]])
+        image = next(i for i in release["images"] if i["type"] == "main")
+
+        now = email.utils.parsedate_to_datetime(response.getheader("Date")).timestamp()
+        slot = get_slot(release, mac)
+        if slot > now:
+            time.sleep((slot - now) * args.time_scale)
+
+        url = urllib.parse.urljoin(args.url, image["url"])
+        ok = request(url, args, stats, lambda r: r.read()) is not None
+
+    if ok:
+        stats.add(times=[time.monotonic() - begin])
+    else:
+        stats.add(failed=1)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Simulate many badges updating against one server")
+    parser.add_argument("url", help="JSON manifest, as served by tools/ota_server.py")
+    parser.add_argument("--badges", type=int, default=200)
+    parser.add_argument("--download", action="store_true", help="also download the main image of the newest release")
+    parser.add_argument("--spread", type=float, default=0, help="start the badges within this many seconds")
+    parser.add_argument("--policy", choices=["backoff", "linear"], default="backoff")
+    parser.add_argument("--retries", type=int, default=5, help="FRI3D_OTA_RETRIES")
+    parser.add_argument("--delay", type=int, default=1000, help="FRI3D_OTA_RETRY_DELAY, in ms")
+    parser.add_argument("--max-delay", type=float, default=60, help="FRI3D_OTA_RETRY_MAX_DELAY, in seconds")
+    parser.add_argument("--timeout", type=float, default=5, help="timeout of every request, in seconds")
+    parser.add_argument("--time-scale", type=float, default=1, help="multiply all waits, < 1 to run faster")
+    args = parser.parse_args()
+
+    stats = Stats()
+    begin = time.monotonic()
+
+    threads = [threading.Thread(target=badge, args=(args, stats)) for _ in range(args.badges)]
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+
+    duration = time.monotonic() - begin
+    peak = max(
+        (sum(1 for s in stats.starts if second <= s - begin < second + 1) for second in range(int(duration) + 1)),
+        default=0,
+    )
+
+    print(f"{args.badges} badges, policy {args.policy}, finished in {duration:.1f} s")
+    print(f"Succeeded: {len(stats.times)}, gave up: {stats.failed}")
+    print(f"Requests:  {stats.requests}, busy: {stats.busy}, connection errors: {stats.errors}, peak {peak}/s")
+    if stats.times:
+        times = sorted(stats.times)
+        print(f"Done after: median {statistics.median(times):.1f} s, 95% {times[int(len(times) * 0.95) - 1]:.1f} s")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,396 @@
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <string>
+#include <strings.h>
+#include <vector>
+
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "esp_http_client.h"
+#include "esp_log.h"
+
+static const char *TAG = "esp_http_client";
+
+// Larger headers are not something tools/ota_server.py sends
+static const size_t MAX_HEADER_SIZE = 8192;
+
+struct esp_http_client
+{
+    int timeout;
+
+    std::string host;
+    std::string port;
+    std::string path;
+
+    // Request headers, in the order they were set
+    std::vector<std::pair<std::string, std::string>> headers;
+
+    int socket;
+    // Host and port the socket is connected to
+    std::string connectedTo;
+    uint32_t requests;
+    uint32_t connections;
+    // The server asked to close the connection after this response
+    bool closeAfter;
+
+    int status;
+    std::map<std::string, std::string> responseHeaders;
+    int64_t contentLength;
+    int64_t received;
+    // Part of the body that came in with the headers
+    std::string pending;
+};
+
+static bool parseUrl(esp_http_client *client, const char *url)
+{
+    static const char *SCHEME = "http://";
+
+    if (strncmp(url, SCHEME, strlen(SCHEME)) != 0)
+    {
+        ESP_LOGE(TAG, "Only plain HTTP is supported on the host: %s", url);
+        return false;
+    }
+
+    std::string rest(url + strlen(SCHEME));
+    auto slash = rest.find('/');
+    auto authority = rest.substr(0, slash);
+    client->path = slash == std::string::npos ? "/" : rest.substr(slash);
+
+    auto colon = authority.rfind(':');
+    client->host = authority.substr(0, colon);
+    client->port = colon == std::string::npos ? "80" : authority.substr(colon + 1);
+
+    return !client->host.empty();
+}
+
+static void disconnect(esp_http_client *client)
+{
+    if (client->socket >= 0)
+    {
+        ::close(client->socket);
+        client->socket = -1;
+    }
+
+    client->connectedTo.clear();
+}
+
+// A kept connection the server closed in the meantime shows up as readable with nothing to read
+static bool isAlive(esp_http_client *client)
+{
+    pollfd descriptor = {.fd = client->socket, .events = POLLIN, .revents = 0};
+    if (poll(&descriptor, 1, 0) == 0)
+    {
+        return true;
+    }
+
+    char byte;
+    return recv(client->socket, &byte, 1, MSG_PEEK | MSG_DONTWAIT) > 0;
+}
+
+static bool connect(esp_http_client *client)
+{
+    auto target = client->host + ":" + client->port;
+
+    if (client->socket >= 0 && client->connectedTo == target && !client->closeAfter && isAlive(client))
+    {
+        return true;
+    }
+
+    disconnect(client);
+
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    addrinfo *addresses = nullptr;
+    if (getaddrinfo(client->host.c_str(), client->port.c_str(), &hints, &addresses) != 0)
+    {
+        ESP_LOGE(TAG, "Could not resolve %s", client->host.c_str());
+        return false;
+    }
+
+    for (auto address = addresses; address != nullptr; address = address->ai_next)
+    {
+        client->socket = ::socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+        if (client->socket < 0)
+        {
+            continue;
+        }
+
+        timeval timeout = {.tv_sec = client->timeout / 1000, .tv_usec = (client->timeout % 1000) * 1000};
+        setsockopt(client->socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(client->socket, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+        if (::connect(client->socket, address->ai_addr, address->ai_addrlen) == 0)
+        {
+            break;
+        }
+
+        disconnect(client);
+    }
+
+    freeaddrinfo(addresses);
+
+    if (client->socket < 0)
+    {
+        ESP_LOGE(TAG, "Could not connect to %s", target.c_str());
+        return false;
+    }
+
+    client->connectedTo = target;
+    client->connections++;
+    client->closeAfter = false;
+
+    return true;
+}
+
+static bool sendAll(esp_http_client *client, const std::string &data)
+{
+    size_t sent = 0;
+    while (sent < data.size())
+    {
+        auto result = send(client->socket, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (result <= 0)
+        {
+            return false;
+        }
+        sent += result;
+    }
+
+    return true;
+}
+
+esp_http_client_handle_t esp_http_client_init(const esp_http_client_config_t *config)
+{
+    auto client = new esp_http_client();
+    client->timeout = config->timeout_ms > 0 ? config->timeout_ms : 5000;
+    client->socket = -1;
+
+    if (config->url != nullptr && !parseUrl(client, config->url))
+    {
+        delete client;
+        return nullptr;
+    }
+
+    return client;
+}
+
+esp_err_t esp_http_client_cleanup(esp_http_client_handle_t client)
+{
+    disconnect(client);
+    delete client;
+
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_set_url(esp_http_client_handle_t client, const char *url)
+{
+    return parseUrl(client, url) ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t esp_http_client_set_header(esp_http_client_handle_t client, const char *key, const char *value)
+{
+    esp_http_client_delete_header(client, key);
+    client->headers.emplace_back(key, value);
+
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_delete_header(esp_http_client_handle_t client, const char *key)
+{
+    auto &headers = client->headers;
+    headers.erase(
+        std::remove_if(
+            headers.begin(),
+            headers.end(),
+            [key](const auto &header) { return strcasecmp(header.first.c_str(), key) == 0; }),
+        headers.end());
+
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_open(esp_http_client_handle_t client, int write_len)
+{
+    client->status = 0;
+    client->responseHeaders.clear();
+    client->contentLength = -1;
+    client->received = 0;
+    client->pending.clear();
+
+    if (!connect(client))
+    {
+        return ESP_FAIL;
+    }
+
+    auto request = "GET " + client->path + " HTTP/1.1\r\nHost: " + client->host + ":" + client->port +
+                   "\r\nUser-Agent: ota_bench\r\n";
+    for (const auto &header : client->headers)
+    {
+        request += header.first + ": " + header.second + "\r\n";
+    }
+    request += "\r\n";
+
+    if (!sendAll(client, request))
+    {
+        disconnect(client);
+        return ESP_FAIL;
+    }
+
+    client->requests++;
+
+    return ESP_OK;
+}
+
+int64_t esp_http_client_fetch_headers(esp_http_client_handle_t client)
+{
+    std::string data;
+    size_t end;
+
+    while ((end = data.find("\r\n\r\n")) == std::string::npos)
+    {
+        if (data.size() > MAX_HEADER_SIZE)
+        {
+            disconnect(client);
+            return ESP_FAIL;
+        }
+
+        char buffer[1024];
+        auto result = recv(client->socket, buffer, sizeof(buffer), 0);
+        if (result <= 0)
+        {
+            disconnect(client);
+            return ESP_FAIL;
+        }
+        data.append(buffer, result);
+    }
+
+    client->pending = data.substr(end + 4);
+    data.resize(end);
+
+    size_t position = data.find("\r\n");
+    auto statusLine = data.substr(0, position);
+    if (sscanf(statusLine.c_str(), "HTTP/%*d.%*d %d", &client->status) != 1)
+    {
+        disconnect(client);
+        return ESP_FAIL;
+    }
+
+    while (position != std::string::npos)
+    {
+        auto next = data.find("\r\n", position + 2);
+        auto line = data.substr(position + 2, next == std::string::npos ? std::string::npos : next - position - 2);
+        position = next;
+
+        auto colon = line.find(':');
+        if (colon == std::string::npos)
+        {
+            continue;
+        }
+
+        auto key = line.substr(0, colon);
+        std::transform(key.begin(), key.end(), key.begin(), ::tolower);
+        auto value = line.substr(line.find_first_not_of(' ', colon + 1));
+        client->responseHeaders[key] = value;
+    }
+
+    auto length = client->responseHeaders.find("content-length");
+    client->contentLength = length != client->responseHeaders.end() ? std::stoll(length->second) : -1;
+
+    auto connection = client->responseHeaders.find("connection");
+    client->closeAfter =
+        connection != client->responseHeaders.end() && strcasecmp(connection->second.c_str(), "close") == 0;
+
+    // Without a length the body ends when the server closes the connection
+    if (client->contentLength < 0)
+    {
+        client->closeAfter = true;
+    }
+
+    return std::max<int64_t>(client->contentLength, 0);
+}
+
+int esp_http_client_get_status_code(esp_http_client_handle_t client)
+{
+    return client->status;
+}
+
+int esp_http_client_read(esp_http_client_handle_t client, char *buffer, int len)
+{
+    if (esp_http_client_is_complete_data_received(client))
+    {
+        return 0;
+    }
+
+    if (client->contentLength >= 0)
+    {
+        len = static_cast<int>(std::min<int64_t>(len, client->contentLength - client->received));
+    }
+
+    int result;
+    if (!client->pending.empty())
+    {
+        result = static_cast<int>(std::min<size_t>(len, client->pending.size()));
+        memcpy(buffer, client->pending.data(), result);
+        client->pending.erase(0, result);
+    }
+    else if (client->socket < 0)
+    {
+        return -1;
+    }
+    else
+    {
+        result = static_cast<int>(recv(client->socket, buffer, len, 0));
+        if (result < 0)
+        {
+            disconnect(client);
+            return -1;
+        }
+
+        // Also the end of a body without a length
+        if (result == 0)
+        {
+            disconnect(client);
+            return client->contentLength < 0 ? 0 : -1;
+        }
+    }
+
+    client->received += result;
+
+    return result;
+}
+
+bool esp_http_client_is_complete_data_received(esp_http_client_handle_t client)
+{
+    return client->contentLength >= 0 && client->received >= client->contentLength;
+}
+
+esp_err_t esp_http_client_close(esp_http_client_handle_t client)
+{
+    disconnect(client);
+
+    return ESP_OK;
+}
+
+std::string esp_http_client_host_get_response_header(esp_http_client_handle_t client, const char *key)
+{
+    std::string name(key);
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+
+    auto header = client->responseHeaders.find(name);
+    return header != client->responseHeaders.end() ? header->second : std::string();
+}
+
+uint32_t esp_http_client_host_get_requests(esp_http_client_handle_t client)
+{
+    return client->requests;
+}
+
+uint32_t esp_http_client_host_get_connections(esp_http_client_handle_t client)
+{
+    return client->connections;
+}
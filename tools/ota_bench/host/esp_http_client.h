@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "esp_err.h"
+
+// A plain HTTP/1.1 client with the API of the one in ESP-IDF, as far as the OTA component uses it. The connection is
+// kept open between requests to the same host, like on the badge. There is no TLS, the bench talks to
+// tools/ota_server.py on the local network.
+
+typedef struct esp_http_client *esp_http_client_handle_t;
+
+typedef struct
+{
+    const char *url;
+    int timeout_ms;
+} esp_http_client_config_t;
+
+esp_http_client_handle_t esp_http_client_init(const esp_http_client_config_t *config);
+esp_err_t esp_http_client_cleanup(esp_http_client_handle_t client);
+
+esp_err_t esp_http_client_set_url(esp_http_client_handle_t client, const char *url);
+esp_err_t esp_http_client_set_header(esp_http_client_handle_t client, const char *key, const char *value);
+esp_err_t esp_http_client_delete_header(esp_http_client_handle_t client, const char *key);
+
+/**
+ * @brief connect when there is no open connection to the host and send the request
+ */
+esp_err_t esp_http_client_open(esp_http_client_handle_t client, int write_len);
+
+/**
+ * @return the Content-Length of the response, 0 when there is none, negative on errors
+ */
+int64_t esp_http_client_fetch_headers(esp_http_client_handle_t client);
+
+int esp_http_client_get_status_code(esp_http_client_handle_t client);
+int esp_http_client_read(esp_http_client_handle_t client, char *buffer, int len);
+bool esp_http_client_is_complete_data_received(esp_http_client_handle_t client);
+esp_err_t esp_http_client_close(esp_http_client_handle_t client);
+
+// Host only: on the badge the pool collects these through the event handler
+
+/**
+ * @return value of a header of the last response, empty when the server didn't send it
+ */
+std::string esp_http_client_host_get_response_header(esp_http_client_handle_t client, const char *key);
+
+/**
+ * @return number of requests the client sent
+ */
+uint32_t esp_http_client_host_get_requests(esp_http_client_handle_t client);
+
+/**
+ * @return number of TCP connections the client opened
+ */
+uint32_t esp_http_client_host_get_connections(esp_http_client_handle_t client);
@@ -0,0 +1,19 @@
+#include <atomic>
+#include <cstring>
+
+#include "esp_log.h"
+
+static std::atomic<esp_log_level_t> level(ESP_LOG_INFO);
+
+void esp_log_level_set(const char *tag, esp_log_level_t value)
+{
+    if (strcmp(tag, "*") == 0)
+    {
+        level = value;
+    }
+}
+
+esp_log_level_t esp_log_host_get_level()
+{
+    return level;
+}
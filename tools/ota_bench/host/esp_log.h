@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdio>
+#include <type_traits>
+
+#include "esp_err.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+
+typedef enum
+{
+    ESP_LOG_NONE,
+    ESP_LOG_ERROR,
+    ESP_LOG_WARN,
+    ESP_LOG_INFO,
+    ESP_LOG_DEBUG,
+    ESP_LOG_VERBOSE
+} esp_log_level_t;
+
+// Everything is compiled in, the level set for "*" filters at runtime
+#ifndef LOG_LOCAL_LEVEL
+#define LOG_LOCAL_LEVEL ESP_LOG_VERBOSE
+#endif
+
+/**
+ * @brief only the level for "*" is used, the components set their own tags to LOG_LOCAL_LEVEL
+ */
+void esp_log_level_set(const char *tag, esp_log_level_t level);
+
+esp_log_level_t esp_log_host_get_level();
+
+// The formats are written for the 32-bit badge: uint32_t is printed with %lu and size_t with %d. Every integer is
+// widened to 64 bits, so both read the right value on a 64-bit host.
+template <typename T> inline auto esp_log_host_widen(T value)
+{
+    if constexpr (std::is_enum_v<T>)
+    {
+        return static_cast<long long>(value);
+    }
+    else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+    {
+        return static_cast<long long>(value);
+    }
+    else if constexpr (std::is_integral_v<T>)
+    {
+        return static_cast<unsigned long long>(value);
+    }
+    else
+    {
+        return value;
+    }
+}
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-security"
+#pragma GCC diagnostic ignored "-Wformat"
+
+template <typename... Args>
+inline void esp_log_host_write(esp_log_level_t level, char letter, const char *tag, const char *format, Args... args)
+{
+    if (level > esp_log_host_get_level())
+    {
+        return;
+    }
+
+    printf("%c (%lld) %s: ", letter, static_cast<long long>(esp_timer_get_time() / 1000), tag);
+    printf(format, esp_log_host_widen(args)...);
+    printf("\n");
+}
+
+#pragma GCC diagnostic pop
+
+#define ESP_LOGE(tag, format, ...) esp_log_host_write(ESP_LOG_ERROR, 'E', tag, format __VA_OPT__(, ) __VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) esp_log_host_write(ESP_LOG_WARN, 'W', tag, format __VA_OPT__(, ) __VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) esp_log_host_write(ESP_LOG_INFO, 'I', tag, format __VA_OPT__(, ) __VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) esp_log_host_write(ESP_LOG_DEBUG, 'D', tag, format __VA_OPT__(, ) __VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) esp_log_host_write(ESP_LOG_VERBOSE, 'V', tag, format __VA_OPT__(, ) __VA_ARGS__)
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+
+#include "esp_err.h"
+
+typedef enum
+{
+    ESP_MAC_WIFI_STA
+} esp_mac_type_t;
+
+// Every bench run is the same badge, so it gets the same rollout slot
+inline esp_err_t esp_read_mac(uint8_t *mac, esp_mac_type_t type)
+{
+    static const uint8_t address[6] = {0x02, 0xf3, 0xd0, 0x00, 0x00, 0x01};
+
+    for (int i = 0; i < 6; i++)
+    {
+        mac[i] = address[i];
+    }
+
+    return ESP_OK;
+}
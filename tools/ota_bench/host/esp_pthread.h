@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+
+#include "esp_err.h"
+
+// Threads on the host ignore their name, priority and stack size
+typedef struct
+{
+    size_t stack_size;
+    size_t prio;
+    bool inherit_cfg;
+    const char *thread_name;
+    int pin_to_core;
+} esp_pthread_cfg_t;
+
+inline esp_pthread_cfg_t esp_pthread_get_default_config()
+{
+    return {.stack_size = 4096, .prio = 5, .inherit_cfg = false, .thread_name = nullptr, .pin_to_core = -1};
+}
+
+inline esp_err_t esp_pthread_set_cfg(const esp_pthread_cfg_t *cfg)
+{
+    return ESP_OK;
+}
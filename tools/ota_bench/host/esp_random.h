@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+
+inline uint32_t esp_random()
+{
+    static std::mt19937 generator{std::random_device{}()};
+
+    return generator();
+}
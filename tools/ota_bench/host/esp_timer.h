@@ -0,0 +1,14 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+/**
+ * @return microseconds since the bench started, like the time since boot on the badge
+ */
+inline int64_t esp_timer_get_time()
+{
+    static const auto start = std::chrono::steady_clock::now();
+
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
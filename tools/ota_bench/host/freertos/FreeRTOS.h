@@ -0,0 +1,5 @@
+#pragma once
+
+#include <cstdint>
+
+typedef unsigned int UBaseType_t;
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+typedef void *TaskHandle_t;
+
+inline UBaseType_t uxTaskPriorityGet(TaskHandle_t task)
+{
+    return 1;
+}
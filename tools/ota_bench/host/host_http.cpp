@@ -0,0 +1,174 @@
+#include <algorithm>
+
+#include "esp_log.h"
+
+#include "host_http.hpp"
+
+// The client is the same as in fri3d_application, whose implementation of the pool needs ESP-IDF
+namespace Fri3d::Application::Hardware
+{
+
+CHttpClient::CHttpClient(IHttp &http, esp_http_client_handle_t handle)
+    : http(&http)
+    , handle(handle)
+{
+}
+
+CHttpClient::~CHttpClient()
+{
+    if (this->handle == nullptr)
+    {
+        return;
+    }
+
+    for (const auto &key : this->headers)
+    {
+        esp_http_client_delete_header(this->handle, key.c_str());
+    }
+
+    this->http->release(this->handle);
+}
+
+CHttpClient::CHttpClient(CHttpClient &&other) noexcept
+    : http(other.http)
+    , handle(other.handle)
+    , headers(std::move(other.headers))
+{
+    other.handle = nullptr;
+}
+
+esp_http_client_handle_t CHttpClient::get() const
+{
+    return this->handle;
+}
+
+CHttpClient::operator bool() const
+{
+    return this->handle != nullptr;
+}
+
+bool CHttpClient::setHeader(const char *key, const char *value)
+{
+    if (std::find(this->headers.begin(), this->headers.end(), key) == this->headers.end())
+    {
+        this->headers.emplace_back(key);
+    }
+
+    return ESP_OK == esp_http_client_set_header(this->handle, key, value);
+}
+
+void CHttpClient::watchHeader(const char *key)
+{
+    this->http->watchHeader(this->handle, key);
+}
+
+std::string CHttpClient::getHeader(const char *key) const
+{
+    return this->http->getHeader(this->handle, key);
+}
+
+} // namespace Fri3d::Application::Hardware
+
+namespace Fri3d::Bench
+{
+
+static const char *TAG = "Fri3d::Bench::CHostHttp";
+
+CHostHttp::CHostHttp() = default;
+
+CHostHttp::~CHostHttp()
+{
+    for (auto &client : this->clients)
+    {
+        esp_http_client_cleanup(client.handle);
+    }
+}
+
+std::string CHostHttp::getHost(const std::string &url)
+{
+    auto start = url.find("://");
+    start = start == std::string::npos ? 0 : start + 3;
+
+    return url.substr(0, url.find('/', start));
+}
+
+Application::Hardware::CHttpClient CHostHttp::acquire(const std::string &url)
+{
+    std::lock_guard lock(this->mutex);
+
+    auto host = CHostHttp::getHost(url);
+
+    for (auto &client : this->clients)
+    {
+        if (client.idle && client.host == host)
+        {
+            client.idle = false;
+            esp_http_client_set_url(client.handle, url.c_str());
+            return {*this, client.handle};
+        }
+    }
+
+    esp_http_client_config_t config = {.url = url.c_str(), .timeout_ms = 5000};
+    auto handle = esp_http_client_init(&config);
+    if (handle == nullptr)
+    {
+        ESP_LOGE(TAG, "Could not create a client for %s", url.c_str());
+        return {*this, nullptr};
+    }
+
+    this->clients.push_back({.handle = handle, .host = host, .idle = false});
+
+    return {*this, handle};
+}
+
+void CHostHttp::release(esp_http_client_handle_t handle)
+{
+    std::lock_guard lock(this->mutex);
+
+    for (auto &client : this->clients)
+    {
+        if (client.handle == handle)
+        {
+            client.idle = true;
+        }
+    }
+}
+
+void CHostHttp::watchHeader(esp_http_client_handle_t handle, const char *key)
+{
+    // The host client keeps all response headers
+}
+
+std::string CHostHttp::getHeader(esp_http_client_handle_t handle, const char *key)
+{
+    return esp_http_client_host_get_response_header(handle, key);
+}
+
+void CHostHttp::closeIdle()
+{
+    std::lock_guard lock(this->mutex);
+
+    for (auto &client : this->clients)
+    {
+        if (client.idle)
+        {
+            esp_http_client_close(client.handle);
+        }
+    }
+}
+
+Application::Hardware::CHttpStatistics CHostHttp::getStatistics() const
+{
+    std::lock_guard lock(this->mutex);
+
+    Application::Hardware::CHttpStatistics statistics = {.requests = 0, .connections = 0};
+    for (const auto &client : this->clients)
+    {
+        statistics.requests += esp_http_client_host_get_requests(client.handle);
+        statistics.connections += esp_http_client_host_get_connections(client.handle);
+    }
+
+    return statistics;
+}
+
+} // namespace Fri3d::Bench
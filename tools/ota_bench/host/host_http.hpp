@@ -0,0 +1,49 @@
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "fri3d_application/hardware_http.hpp"
+
+namespace Fri3d::Bench
+{
+
+/**
+ * @brief pool of plain HTTP clients, the host counterpart of CHttp in fri3d_application
+ *
+ * Like on the badge, an idle client for the same host is reused, so consecutive requests share its connection.
+ */
+class CHostHttp : public Application::Hardware::IHttp
+{
+private:
+    struct CClient
+    {
+        esp_http_client_handle_t handle;
+        std::string host;
+        bool idle;
+    };
+
+    mutable std::mutex mutex;
+    std::vector<CClient> clients;
+
+    static std::string getHost(const std::string &url);
+
+protected:
+    void release(esp_http_client_handle_t handle) override;
+    void watchHeader(esp_http_client_handle_t handle, const char *key) override;
+    [[nodiscard]] std::string getHeader(esp_http_client_handle_t handle, const char *key) override;
+
+public:
+    CHostHttp();
+    ~CHostHttp();
+
+    CHostHttp(const CHostHttp &) = delete;
+    CHostHttp &operator=(const CHostHttp &) = delete;
+
+    Application::Hardware::CHttpClient acquire(const std::string &url) override;
+    void closeIdle() override;
+    [[nodiscard]] Application::Hardware::CHttpStatistics getStatistics() const override;
+};
+
+} // namespace Fri3d::Bench
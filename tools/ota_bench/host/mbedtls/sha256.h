@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+
+#include <openssl/evp.h>
+
+// SHA-256 from OpenSSL, where the badge uses mbedtls with the hardware accelerator
+typedef struct
+{
+    EVP_MD_CTX *context;
+} mbedtls_sha256_context;
+
+inline void mbedtls_sha256_init(mbedtls_sha256_context *ctx)
+{
+    ctx->context = EVP_MD_CTX_new();
+}
+
+inline void mbedtls_sha256_free(mbedtls_sha256_context *ctx)
+{
+    EVP_MD_CTX_free(ctx->context);
+    ctx->context = nullptr;
+}
+
+inline int mbedtls_sha256_starts(mbedtls_sha256_context *ctx, int is224)
+{
+    return EVP_DigestInit_ex(ctx->context, EVP_sha256(), nullptr) == 1 ? 0 : -1;
+}
+
+inline int mbedtls_sha256_update(mbedtls_sha256_context *ctx, const unsigned char *input, size_t length)
+{
+    return EVP_DigestUpdate(ctx->context, input, length) == 1 ? 0 : -1;
+}
+
+inline int mbedtls_sha256_finish(mbedtls_sha256_context *ctx, unsigned char *output)
+{
+    return EVP_DigestFinal_ex(ctx->context, output, nullptr) == 1 ? 0 : -1;
+}
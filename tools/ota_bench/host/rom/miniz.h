@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include <zlib.h>
+
+// The inflate API of the miniz in ROM, on top of zlib. Only what CInflater uses, with the same status codes.
+
+#define TINFL_LZ_DICT_SIZE 32768
+
+enum
+{
+    TINFL_FLAG_PARSE_ZLIB_HEADER = 1,
+    TINFL_FLAG_HAS_MORE_INPUT = 2,
+    TINFL_FLAG_USING_NON_WRAPPING_OUTPUT_BUF = 4,
+    TINFL_FLAG_COMPUTE_ADLER32 = 8
+};
+
+typedef enum
+{
+    TINFL_STATUS_BAD_PARAM = -3,
+    TINFL_STATUS_ADLER32_MISMATCH = -2,
+    TINFL_STATUS_FAILED = -1,
+    TINFL_STATUS_DONE = 0,
+    TINFL_STATUS_NEEDS_MORE_INPUT = 1,
+    TINFL_STATUS_HAS_MORE_OUTPUT = 2
+} tinfl_status;
+
+struct tinfl_decompressor
+{
+    z_stream stream;
+    bool started;
+
+    ~tinfl_decompressor()
+    {
+        if (this->started)
+        {
+            inflateEnd(&this->stream);
+        }
+    }
+};
+
+inline void tinfl_init(tinfl_decompressor *r)
+{
+    if (r->started)
+    {
+        inflateEnd(&r->stream);
+    }
+
+    r->stream = {};
+    r->started = inflateInit(&r->stream) == Z_OK;
+}
+
+// zlib keeps its own window, so the output can go anywhere in the dictionary of the caller
+inline tinfl_status tinfl_decompress(
+    tinfl_decompressor *r,
+    const uint8_t *pIn_buf_next,
+    size_t *pIn_buf_size,
+    uint8_t *pOut_buf_start,
+    uint8_t *pOut_buf_next,
+    size_t *pOut_buf_size,
+    uint32_t decomp_flags)
+{
+    if (!r->started)
+    {
+        return TINFL_STATUS_BAD_PARAM;
+    }
+
+    r->stream.next_in = const_cast<Bytef *>(pIn_buf_next);
+    r->stream.avail_in = static_cast<uInt>(*pIn_buf_size);
+    r->stream.next_out = pOut_buf_next;
+    r->stream.avail_out = static_cast<uInt>(*pOut_buf_size);
+
+    auto result = inflate(&r->stream, Z_NO_FLUSH);
+
+    *pIn_buf_size -= r->stream.avail_in;
+    *pOut_buf_size -= r->stream.avail_out;
+
+    switch (result)
+    {
+    case Z_STREAM_END:
+        return TINFL_STATUS_DONE;
+    case Z_OK:
+    case Z_BUF_ERROR:
+        return r->stream.avail_out == 0 ? TINFL_STATUS_HAS_MORE_OUTPUT : TINFL_STATUS_NEEDS_MORE_INPUT;
+    case Z_DATA_ERROR:
+        return r->stream.msg != nullptr && std::string_view(r->stream.msg) == "incorrect data check"
+                   ? TINFL_STATUS_ADLER32_MISMATCH
+                   : TINFL_STATUS_FAILED;
+    default:
+        return TINFL_STATUS_FAILED;
+    }
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+// The defaults from components/fri3d_ota/Kconfig, the bench uses the same buffers and retry timing as the badge
+
+#define CONFIG_FRI3D_OTA_BUFFER_SIZE 16384
+#define CONFIG_FRI3D_OTA_RETRIES 5
+#define CONFIG_FRI3D_OTA_RETRY_DELAY 1000
+#define CONFIG_FRI3D_OTA_RETRY_MAX_DELAY 60
+#define CONFIG_FRI3D_OTA_MIRROR_MIN_RATE 16
@@ -0,0 +1,306 @@
+// Runs the download and flash path of the OTA app on a Linux host, to see where the time of an update goes.
+//
+// The manifest and the images come from an HTTP server, normally tools/ota_server.py with --rate and --latency set to
+// the conditions at camp. Every image goes through the same CHttpSource, CMirrors, CRetryPolicy, decoders and
+// CFlashEngine as on the badge, into a file per partition (CFilePartition) that behaves like NOR flash. The times per
+// stage are printed for every image and for the whole update, in the same format as the badge logs them.
+//
+// What the bench doesn't cover: TLS (the server is plain HTTP), the speed of the real flash and the UI. Those are
+// logged by the badge itself after every update. Partitions are always written completely, so block hashes and delta
+// patches are not used.
+//
+//   ota_bench http://localhost:8000/firmware-fox.json --image main --image vfs --duty 50 --erase-size 4096
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <getopt.h>
+#include <memory>
+#include <optional>
+#include <set>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "fri3d_private/binary_manifest_parser.hpp"
+#include "fri3d_private/file_partition.hpp"
+#include "fri3d_private/flash_engine.hpp"
+#include "fri3d_private/http_source.hpp"
+#include "fri3d_private/inflater.hpp"
+#include "fri3d_private/manifest_parser.hpp"
+#include "fri3d_private/mirrors.hpp"
+#include "fri3d_private/update_statistics.hpp"
+
+#include "host_http.hpp"
+
+using namespace Fri3d::Apps::Ota;
+using Fri3d::Bench::CHostHttp;
+
+static const char *TAG = "Fri3d::Bench";
+
+// Partitions of the badge are a multiple of the 64 KB erase block
+static const size_t PARTITION_ALIGNMENT = 64 * 1024;
+
+static uint32_t toMilliseconds(int64_t duration)
+{
+    return static_cast<uint32_t>(duration / 1000);
+}
+
+static bool fetchManifest(CHostHttp &http, const std::string &url, CFirmwares &firmwares)
+{
+    auto start = esp_timer_get_time();
+
+    CMirrors mirrors(url, {});
+    CHttpSource source(http, mirrors, -1);
+    if (!source.open(0, -1))
+    {
+        ESP_LOGE(TAG, "Could not download %s", url.c_str());
+        return false;
+    }
+
+    auto onFirmware = [&firmwares](CFirmware &&firmware) { firmwares.emplace_back(std::move(firmware)); };
+    std::unique_ptr<IManifestParser> parser;
+    int64_t parse = 0;
+    size_t size = 0;
+
+    char data[512];
+    int read;
+    while ((read = source.read(reinterpret_cast<uint8_t *>(data), sizeof(data))) > 0)
+    {
+        if (!parser)
+        {
+            if (CBinaryManifestParser::isBinary(data, read))
+            {
+                parser = std::make_unique<CBinaryManifestParser>(onFirmware);
+            }
+            else
+            {
+                parser = std::make_unique<CManifestParser>(onFirmware);
+            }
+        }
+
+        size += read;
+
+        auto now = esp_timer_get_time();
+        bool result = parser->feed(data, read);
+        parse += esp_timer_get_time() - now;
+
+        if (!result)
+        {
+            ESP_LOGE(TAG, "Invalid manifest %s", url.c_str());
+            return false;
+        }
+    }
+
+    if (read < 0 || !parser || !parser->isDone())
+    {
+        ESP_LOGE(TAG, "Incomplete manifest %s", url.c_str());
+        return false;
+    }
+
+    const auto &statistics = source.getStatistics();
+    ESP_LOGI(
+        TAG,
+        "Parsed %d firmwares from %d bytes in %lu ms (connecting %lu ms, waiting for the response %lu ms, receiving "
+        "%lu ms, parsing %lu ms)",
+        parser->getFirmwareCount(),
+        size,
+        toMilliseconds(esp_timer_get_time() - start),
+        toMilliseconds(statistics.connect),
+        toMilliseconds(statistics.response),
+        toMilliseconds(statistics.receive),
+        toMilliseconds(parse));
+
+    return true;
+}
+
+// The complete image is written, the same as CFlasher does for an image without block hashes
+static bool flashImage(
+    CHostHttp &http,
+    const CImage &image,
+    const std::string &path,
+    const std::string &label,
+    const CFlashThrottle &throttle,
+    CUpdateStatistics &total)
+{
+    auto start = esp_timer_get_time();
+
+    CUpdateStatistics statistics = {};
+    statistics.images = 1;
+
+    // Every run starts from an erased partition, like a fresh badge
+    unlink(path.c_str());
+    auto size = (static_cast<size_t>(image.size) + PARTITION_ALIGNMENT - 1) / PARTITION_ALIGNMENT * PARTITION_ALIGNMENT;
+    CFilePartition partition(path, label, size);
+
+    ESP_LOGI(TAG, "Flashing %s %s to %s", label.c_str(), image.version.getText(), path.c_str());
+
+    auto selecting = esp_timer_get_time();
+    CMirrors mirrors(image.url, image.mirrors);
+    mirrors.select(http, image.size);
+    auto selected = esp_timer_get_time() - selecting;
+
+    CHttpSource source(http, mirrors, image.encoding == CImage::Raw ? image.size : -1);
+
+    std::optional<CInflater> inflater;
+    std::vector<IDecoder *> decoders;
+    if (image.encoding == CImage::Zlib)
+    {
+        inflater.emplace();
+        decoders.push_back(&*inflater);
+    }
+
+    CImageVerifier verifier(image);
+    CFlashEngine engine(partition, &verifier, nullptr, [&statistics](size_t length) {
+        statistics.progressUpdates++;
+    });
+    engine.setThrottle(throttle);
+
+    bool result = engine.begin() && engine.write(source, CFlashEngine::CRegion(0, image.size), decoders);
+    result = engine.finish() && result;
+
+    statistics.total = esp_timer_get_time() - start;
+    statistics.download = source.getStatistics();
+    statistics.download.connect += selected;
+    statistics.decompress = inflater ? inflater->getDuration() : 0;
+    statistics.add(engine.getStatistics(), verifier.getStatistics());
+    statistics.print(label.c_str());
+    total += statistics;
+
+    if (result && !engine.verify())
+    {
+        ESP_LOGE(TAG, "Verification of %s failed", label.c_str());
+        result = false;
+    }
+
+    return result;
+}
+
+static void usage(const char *name)
+{
+    printf(
+        "Usage: %s [options] <manifest url>\n"
+        "  --version VERSION     firmware to flash, the newest one by default\n"
+        "  --image TYPE          image to flash (main, micropython, retro-launcher, retro-core, retro-prboom, vfs),\n"
+        "                        can be repeated, all images of the firmware by default\n"
+        "  --directory PATH      where the partition files are written, the current directory by default\n"
+        "  --duty PERCENT        keep the flash busy at most this part of the time, like a background update\n"
+        "  --erase-size BYTES    erase at most this much at once\n"
+        "  --verbose             log everything, also every buffer\n",
+        name);
+}
+
+int main(int argc, char *argv[])
+{
+    static const option options[] = {
+        {"version", required_argument, nullptr, 'v'},
+        {"image", required_argument, nullptr, 'i'},
+        {"directory", required_argument, nullptr, 'd'},
+        {"duty", required_argument, nullptr, 'u'},
+        {"erase-size", required_argument, nullptr, 'e'},
+        {"verbose", no_argument, nullptr, 'V'},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0},
+    };
+
+    std::string version;
+    std::set<CImage::ImageType> selection;
+    std::string directory = ".";
+    CFlashThrottle throttle;
+
+    int option;
+    while ((option = getopt_long(argc, argv, "", options, nullptr)) != -1)
+    {
+        switch (option)
+        {
+        case 'v':
+            version = optarg;
+            break;
+        case 'i':
+        {
+            CImage::ImageType type;
+            if (!CImage::parseType(optarg, type))
+            {
+                fprintf(stderr, "Unknown image type %s\n", optarg);
+                return 2;
+            }
+            selection.insert(type);
+            break;
+        }
+        case 'd':
+            directory = optarg;
+            break;
+        case 'u':
+            throttle.dutyCycle = atoi(optarg);
+            break;
+        case 'e':
+            throttle.eraseSize = static_cast<size_t>(atol(optarg));
+            break;
+        case 'V':
+            esp_log_level_set("*", ESP_LOG_VERBOSE);
+            break;
+        default:
+            usage(argv[0]);
+            return option == 'h' ? 0 : 2;
+        }
+    }
+
+    if (optind != argc - 1)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    CHostHttp http;
+
+    CFirmwares firmwares;
+    if (!fetchManifest(http, argv[optind], firmwares) || firmwares.empty())
+    {
+        return 1;
+    }
+
+    auto firmware = std::max_element(firmwares.begin(), firmwares.end());
+    if (!version.empty())
+    {
+        firmware = std::find_if(firmwares.begin(), firmwares.end(), [&version](const CFirmware &item) {
+            return version == item.version.getText();
+        });
+
+        if (firmware == firmwares.end())
+        {
+            ESP_LOGE(TAG, "Version %s is not in the manifest", version.c_str());
+            return 1;
+        }
+    }
+
+    ESP_LOGI(TAG, "Flashing %s", firmware->version.getText());
+
+    CUpdateStatistics total = {};
+    bool result = true;
+
+    for (const auto &image : firmware->images)
+    {
+        if (!selection.empty() && selection.count(image.imageType) == 0)
+        {
+            continue;
+        }
+
+        std::string name = CImage::typeToJsonString[image.imageType];
+
+        if (!flashImage(http, image, directory + "/" + name + ".bin", name, throttle, total))
+        {
+            ESP_LOGE(TAG, "Error flashing %s", name.c_str());
+            result = false;
+        }
+    }
+
+    total.print("Update");
+
+    auto statistics = http.getStatistics();
+    ESP_LOGI(TAG, "Sent %lu requests over %lu connections", statistics.requests, statistics.connections);
+    CMirrors::printStatistics();
+
+    return result ? 0 : 1;
+}
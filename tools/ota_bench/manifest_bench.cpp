@@ -0,0 +1,261 @@
+// Measures how long the OTA app takes to turn a versions manifest into the lists it shows, on a Linux host.
+//
+// Every manifest is parsed the way CFirmwareFetcher does while it is downloaded, in parts of the fetch buffer, and
+// then sorted and filtered into the lists of all and of the official firmwares. The fastest of the runs is printed per
+// stage, together with the heap allocations the parser made and the size of the arena the firmwares share.
+//
+// Large manifests come from tools/generate_manifest.py, tools/binary_manifest.py turns them into the binary format:
+//
+//   python3 tools/generate_manifest.py versions.json --versions 2000
+//   python3 tools/binary_manifest.py versions.json versions.f3dm
+//   manifest_bench versions.json versions.f3dm
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <getopt.h>
+#include <memory>
+#include <new>
+#include <string>
+
+#include "fri3d_private/binary_manifest_parser.hpp"
+#include "fri3d_private/firmware.hpp"
+#include "fri3d_private/manifest_parser.hpp"
+
+using namespace Fri3d::Apps::Ota;
+
+// Every allocation of the process is counted, the bench only looks at the difference over the parse
+static size_t allocations = 0;
+static size_t allocatedBytes = 0;
+
+void *operator new(size_t size)
+{
+    allocations++;
+    allocatedBytes += size;
+
+    auto result = malloc(size > 0 ? size : 1);
+    if (result == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+
+    return result;
+}
+
+void operator delete(void *pointer) noexcept
+{
+    free(pointer);
+}
+
+void operator delete(void *pointer, size_t) noexcept
+{
+    free(pointer);
+}
+
+struct CResult
+{
+    size_t firmwares;
+    size_t official;
+    size_t arena;
+    size_t allocations;
+    size_t allocatedBytes;
+    // In microseconds
+    int64_t parse;
+    int64_t sort;
+    int64_t filter;
+};
+
+static int64_t now()
+{
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+static bool readFile(const char *path, std::string &data)
+{
+    auto file = fopen(path, "rb");
+    if (file == nullptr)
+    {
+        return false;
+    }
+
+    char buffer[4096];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+    {
+        data.append(buffer, read);
+    }
+
+    bool result = ferror(file) == 0;
+    fclose(file);
+
+    return result;
+}
+
+// The same steps as CFirmwareFetcher::refresh() and CFirmwareFetcher::sort()
+static bool run(const std::string &manifest, size_t chunkSize, CResult &result)
+{
+    CFirmwares firmwares;
+    auto onFirmware = [&firmwares](CFirmware &&firmware) { firmwares.emplace_back(std::move(firmware)); };
+
+    auto allocationsBefore = allocations;
+    auto bytesBefore = allocatedBytes;
+    auto start = now();
+
+    std::unique_ptr<IManifestParser> parser;
+    if (CBinaryManifestParser::isBinary(manifest.data(), manifest.size()))
+    {
+        parser = std::make_unique<CBinaryManifestParser>(onFirmware);
+    }
+    else
+    {
+        parser = std::make_unique<CManifestParser>(onFirmware);
+    }
+
+    for (size_t offset = 0; offset < manifest.size(); offset += chunkSize)
+    {
+        if (!parser->feed(manifest.data() + offset, std::min(chunkSize, manifest.size() - offset)))
+        {
+            return false;
+        }
+    }
+
+    if (!parser->isDone())
+    {
+        return false;
+    }
+
+    result.parse = now() - start;
+    result.allocations = allocations - allocationsBefore;
+    result.allocatedBytes = allocatedBytes - bytesBefore;
+
+    start = now();
+    CFirmwareList all;
+    for (const auto &firmware : firmwares)
+    {
+        all.add(firmware);
+    }
+    all.sort();
+    result.sort = now() - start;
+
+    start = now();
+    CFirmwareList official;
+    for (const auto &firmware : all)
+    {
+        if (!firmware.beta)
+        {
+            official.add(firmware);
+        }
+    }
+    result.filter = now() - start;
+
+    result.firmwares = firmwares.size();
+    result.official = official.size();
+    result.arena = firmwares.empty() ? 0 : firmwares.front().arena->getSize();
+
+    return true;
+}
+
+static void usage(const char *name)
+{
+    printf(
+        "Usage: %s [options] <manifest>...\n"
+        "  --runs COUNT          parse every manifest this many times, the fastest run is printed (10)\n"
+        "  --chunk-size BYTES    feed the parser in parts of this size, like the download buffer (512)\n",
+        name);
+}
+
+int main(int argc, char *argv[])
+{
+    static const option options[] = {
+        {"runs", required_argument, nullptr, 'r'},
+        {"chunk-size", required_argument, nullptr, 'c'},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0},
+    };
+
+    int runs = 10;
+    size_t chunkSize = 512;
+
+    int option;
+    while ((option = getopt_long(argc, argv, "", options, nullptr)) != -1)
+    {
+        switch (option)
+        {
+        case 'r':
+            runs = std::max(atoi(optarg), 1);
+            break;
+        case 'c':
+            chunkSize = std::max<size_t>(static_cast<size_t>(atol(optarg)), 1);
+            break;
+        default:
+            usage(argv[0]);
+            return option == 'h' ? 0 : 2;
+        }
+    }
+
+    if (optind == argc)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    printf(
+        "%-24s %10s %10s %10s %12s %12s %10s %10s %10s\n",
+        "manifest",
+        "bytes",
+        "firmwares",
+        "official",
+        "arena",
+        "allocations",
+        "parse us",
+        "sort us",
+        "filter us");
+
+    for (int i = optind; i < argc; i++)
+    {
+        std::string manifest;
+        if (!readFile(argv[i], manifest))
+        {
+            fprintf(stderr, "Could not read %s\n", argv[i]);
+            return 1;
+        }
+
+        CResult best = {};
+        for (int run = 0; run < runs; run++)
+        {
+            CResult result = {};
+            if (!::run(manifest, chunkSize, result))
+            {
+                fprintf(stderr, "Invalid manifest %s\n", argv[i]);
+                return 1;
+            }
+
+            if (run == 0)
+            {
+                best = result;
+            }
+
+            best.parse = std::min(best.parse, result.parse);
+            best.sort = std::min(best.sort, result.sort);
+            best.filter = std::min(best.filter, result.filter);
+        }
+
+        auto name = std::string(argv[i]);
+        name = name.substr(name.rfind('/') + 1);
+
+        printf(
+            "%-24s %10zu %10zu %10zu %12zu %12zu %10ld %10ld %10ld\n",
+            name.c_str(),
+            manifest.size(),
+            best.firmwares,
+            best.official,
+            best.arena,
+            best.allocations,
+            static_cast<long>(best.parse),
+            static_cast<long>(best.sort),
+            static_cast<long>(best.filter));
+    }
+
+    return 0;
+}
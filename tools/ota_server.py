@@ -0,0 +1,202 @@
+# Local stand-in for the update server, to test and time OTA updates without touching the real one.
+#
+# Serves the files in a directory over plain HTTP. Point FRI3D_VERSIONS_URL at the manifest in that directory, for
+# example http://192.168.1.10:8000/firmware-fox.json, and make sure the image URLs in it point to this server too.
+#
+# The download speed can be limited to mimic the wifi at camp, every transfer is logged with its duration. Connections
+# can be dropped halfway a response, to test resuming downloads. Badges that accept the binary manifest get the .f3dm
+# file next to the requested JSON one, if there is one, see tools/binary_manifest.py. Every file gets an ETag and a
+# Last-Modified header and conditional requests for unchanged files are answered with 304 Not Modified.
+#
+# With --capacity, requests beyond that many at the same time are turned away with 503 and a Retry-After header, like
+# an overloaded server would. tools/load_test.py uses this to see how a crowd of badges copes.
+import argparse
+import email.utils
+import os
+import re
+import socket
+import threading
+import time
+from functools import partial
+from http.server import SimpleHTTPRequestHandler, ThreadingHTTPServer
+
+
+class Handler(SimpleHTTPRequestHandler):
+    # Set from the command line
+    rate = 0
+    latency = 0.0
+    drop_after = 0
+    slots = None
+    retry_after = 0
+
+    protocol_version = "HTTP/1.1"
+
+    def do_GET(self):
+        if self.slots is None:
+            return super().do_GET()
+
+        if not self.slots.acquire(blocking=False):
+            self.log_message("busy, turning away %s", self.path)
+            self.send_response(503)
+            self.send_header("Retry-After", str(self.retry_after))
+            self.send_header("Content-Length", "0")
+            self.end_headers()
+            return
+
+        try:
+            super().do_GET()
+        finally:
+            self.slots.release()
+
+    def negotiate(self, path):
+        if not path.endswith(".json") or "application/vnd.fri3d.manifest" not in self.headers.get("Accept", ""):
+            return path, None
+
+        binary = path[: -len(".json")] + ".f3dm"
+        if not os.path.isfile(binary):
+            return path, None
+
+        return binary, "application/vnd.fri3d.manifest"
+
+    def not_modified(self, etag, modified):
+        # If-None-Match takes precedence, If-Modified-Since is only checked without it
+        match = self.headers.get("If-None-Match")
+        if match is not None:
+            return any(tag.strip() in (etag, "*") for tag in match.split(","))
+
+        since = self.headers.get("If-Modified-Since")
+        if since is None:
+            return False
+
+        try:
+            return email.utils.parsedate_to_datetime(since).timestamp() >= int(modified)
+        except (TypeError, ValueError):
+            return False
+
+    def send_head(self):
+        # Handlers are reused for keep-alive connections
+        self.remaining = None
+
+        path = self.translate_path(self.path)
+        if not os.path.isfile(path):
+            return super().send_head()
+
+        vary = path.endswith(".json")
+        path, content_type = self.negotiate(path)
+
+        stat = os.stat(path)
+        size = stat.st_size
+        start, end = 0, size - 1
+
+        etag = f'"{stat.st_mtime_ns:x}-{size:x}"'
+        if self.not_modified(etag, stat.st_mtime):
+            self.send_response(304)
+            self.send_header("ETag", etag)
+            if vary:
+                self.send_header("Vary", "Accept")
+            self.send_header("Content-Length", "0")
+            self.end_headers()
+            return None
+
+        match = re.fullmatch(r"bytes=(\d*)-(\d*)", self.headers.get("Range", ""))
+        if match and (match.group(1) or match.group(2)):
+            if match.group(1):
+                start = int(match.group(1))
+                if match.group(2):
+                    end = min(int(match.group(2)), size - 1)
+            else:
+                start = max(size - int(match.group(2)), 0)
+
+            if start > end:
+                self.send_error(416, "Requested range not satisfiable")
+                return None
+
+            self.send_response(206)
+            self.send_header("Content-Range", f"bytes {start}-{end}/{size}")
+        else:
+            self.send_response(200)
+
+        self.send_header("Content-Type", content_type or self.guess_type(path))
+        if vary:
+            self.send_header("Vary", "Accept")
+        self.send_header("Content-Length", str(end - start + 1))
+        self.send_header("Accept-Ranges", "bytes")
+        self.send_header("ETag", etag)
+        self.send_header("Last-Modified", self.date_time_string(int(stat.st_mtime)))
+        self.end_headers()
+
+        f = open(path, "rb")
+        f.seek(start)
+        self.remaining = end - start + 1
+        return f
+
+    def copyfile(self, source, outputfile):
+        if self.latency:
+            time.sleep(self.latency)
+
+        begin = time.monotonic()
+        sent = 0
+        remaining = self.remaining
+
+        while remaining is None or remaining > 0:
+            if self.drop_after and sent >= self.drop_after:
+                # Pretend the wifi went away, the client has to ask for the rest
+                self.log_message("dropping connection after %d bytes of %s", sent, self.path)
+                self.close_connection = True
+                self.connection.shutdown(socket.SHUT_RDWR)
+                return
+
+            size = 4096 if remaining is None else min(4096, remaining)
+            if self.drop_after:
+                size = min(size, self.drop_after - sent)
+            chunk = source.read(size)
+            if not chunk:
+                break
+
+            outputfile.write(chunk)
+            sent += len(chunk)
+            if remaining is not None:
+                remaining -= len(chunk)
+
+            if self.rate:
+                # Sleep until we are back on schedule
+                delay = begin + sent / self.rate - time.monotonic()
+                if delay > 0:
+                    time.sleep(delay)
+
+        duration = time.monotonic() - begin
+        self.log_message(
+            "sent %d bytes of %s in %.2f s (%.1f kB/s)",
+            sent,
+            self.path,
+            duration,
+            sent / 1024 / duration if duration else 0,
+        )
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Serve OTA images locally")
+    parser.add_argument("directory", help="directory containing the manifest and the images")
+    parser.add_argument("--port", type=int, default=8000)
+    parser.add_argument("--rate", type=float, default=0, help="limit downloads to this many kB/s, 0 is unlimited")
+    parser.add_argument("--latency", type=float, default=0, help="delay before each response body, in ms")
+    parser.add_argument(
+        "--drop-after", type=float, default=0, help="close the connection after this many kB of each response"
+    )
+    parser.add_argument("--capacity", type=int, default=0, help="requests served at the same time, 0 is unlimited")
+    parser.add_argument("--retry-after", type=int, default=5, help="seconds in the Retry-After of busy responses")
+    args = parser.parse_args()
+
+    Handler.rate = args.rate * 1024
+    Handler.latency = args.latency / 1000
+    Handler.drop_after = int(args.drop_after * 1024)
+    Handler.slots = threading.BoundedSemaphore(args.capacity) if args.capacity else None
+    Handler.retry_after = args.retry_after
+
+    server = ThreadingHTTPServer(("", args.port), partial(Handler, directory=args.directory))
+    print(f"Serving {args.directory} on port {args.port}")
+    server.serve_forever()
+
+
+if __name__ == "__main__":
+    main()